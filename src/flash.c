@@ -7,7 +7,7 @@
 *@author    Ziga Miklosic
 *@email     ziga.miklosic@gmail.si
 *@date      17.05.2023
-*@version   V0.1.0
+*@version   V0.2.0
 */
 ////////////////////////////////////////////////////////////////////////////////
 /*!
@@ -28,462 +28,6652 @@
 #include "flash.h"
 #include "../../flash_cfg.h"
 
+#if (( 1 == FLASH_CFG_RING_EN ) || ( 1 == FLASH_CFG_SCHED_EN ))
+    #include <stdatomic.h>
+#endif
+
+#if ( FLASH_CFG_OS_FREERTOS == FLASH_CFG_OS )
+    #include "FreeRTOS.h"
+    #include "semphr.h"
+    #include "task.h"
+#elif ( FLASH_CFG_OS_CMSIS_RTOS2 == FLASH_CFG_OS )
+    #include "cmsis_os2.h"
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 // Definitions
 ////////////////////////////////////////////////////////////////////////////////
 
-#if ( 1 == FLASH_CFG_DUAL_BANK_MODE_EN )
+#if (( FLASH_CFG_OS_BARE_METAL != FLASH_CFG_OS ) && ( FLASH_CFG_OS_FREERTOS != FLASH_CFG_OS ) && ( FLASH_CFG_OS_CMSIS_RTOS2 != FLASH_CFG_OS ))
+    #error "Flash: Unsupported FLASH_CFG_OS selection!"
+#endif
+
+/**
+ *  Family backend
+ *
+ *  Program unit, erase unit and fast programming support of selected MCU
+ *  family. Erase job fields are accessed via backend macros as HAL erase
+ *  structure differs between families.
+ */
+#if (( FLASH_CFG_FAMILY_G0 == FLASH_CFG_FAMILY ) || ( FLASH_CFG_FAMILY_G4 == FLASH_CFG_FAMILY ) || ( FLASH_CFG_FAMILY_L4 == FLASH_CFG_FAMILY ))
 
     /**
-     *  Bank data structure
+     *  Program unit - double word
+     *
+     *  Unit: bytes
      */
-    typedef struct
-    {
-        uint32_t addr;  /**<Address */
-        uint32_t size;  /**<Size of data from address */
-    } flash_bank_data_t;
+    #define FLASH_PROG_SIZE                 ( 8U )
 
     /**
-     *  Bank enumerations
+     *  Fast programming row - 32 double words
+     *
+     *  Unit: bytes
      */
-    enum
-    {
-        eFLASH_BANK_1 = 0,
-        eFLASH_BANK_2,
+    #define FLASH_ROW_SIZE                  ( 256U )
 
-        eFLASH_BANK_NUM_OF
-    };
+    /**
+     *  Fast programming support
+     */
+    #define FLASH_FAST_PROGRAM_SUPPORTED    ( 1 )
 
-#endif // ( 1 == FLASH_CFG_DUAL_BANK_MODE_EN )
+    /**
+     *  Erase unit - page
+     */
+    #define FLASH_TYPEERASE_UNIT            ( FLASH_TYPEERASE_PAGES )
+    #define FLASH_JOB_UNIT(job)             ((job).Page )
+    #define FLASH_JOB_UNIT_NB(job)          ((job).NbPages )
 
-////////////////////////////////////////////////////////////////////////////////
-// Variables
-////////////////////////////////////////////////////////////////////////////////
+    /**
+     *  Register level programming status bits
+     */
+    #define FLASH_LL_SR_ERRORS              ( FLASH_SR_OPERR | FLASH_SR_PROGERR | FLASH_SR_WRPERR | FLASH_SR_PGAERR | FLASH_SR_SIZERR | FLASH_SR_PGSERR | FLASH_SR_MISERR | FLASH_SR_FASTERR )
 
-/**
- *  Initialization flag
- */
-static bool gb_is_init = false;
+    #if ( FLASH_CFG_FAMILY_G0 == FLASH_CFG_FAMILY )
+        #define FLASH_LL_SR_BUSY            ( FLASH_SR_BSY1 )
+    #else
+        #define FLASH_LL_SR_BUSY            ( FLASH_SR_BSY )
+    #endif
 
+    /**
+     *  HAL error flags by error class
+     *
+     *  @note   HAL error codes equal status register bits on these families.
+     */
+    #define FLASH_HAL_ERROR_ALIGN           ( HAL_FLASH_ERROR_PGA | HAL_FLASH_ERROR_SIZ )
+    #define FLASH_HAL_ERROR_WRP             ( HAL_FLASH_ERROR_WRP )
+    #define FLASH_HAL_ERROR_NOT_ERASED      ( HAL_FLASH_ERROR_PROG )
+    #define FLASH_HAL_ERROR_SEQ             ( HAL_FLASH_ERROR_PGS | HAL_FLASH_ERROR_MIS | HAL_FLASH_ERROR_FAST )
+    #define FLASH_HAL_ERROR_ECC             ( HAL_FLASH_ERROR_ECCD )
 
-#if ( 1 == FLASH_CFG_DUAL_BANK_MODE_EN )
+    /**
+     *  Runtime geometry
+     *
+     *  @note   Page size of G4 depends on bank mode, 2 kB in dual-bank
+     *          and 4 kB in single bank mode.
+     */
+    #if defined( FLASH_PAGE_SIZE_128_BITS )
+        #define FLASH_GEO_PAGE_SIZE(dual)   (( dual ) ? FLASH_PAGE_SIZE : FLASH_PAGE_SIZE_128_BITS )
+    #else
+        #define FLASH_GEO_PAGE_SIZE(dual)   ( FLASH_PAGE_SIZE )
+    #endif
 
     /**
-     *  Flash base address in dual-bank mode
+     *  Start of bank 2 in dual-bank mode
+     *
+     *  @note   G4 bank 2 always starts at 0x08040000 (RM0440), smaller
+     *          devices leave gap between end of bank 1 and bank 2.
      */
-    const uint32_t gu32_flash_base[eFLASH_BANK_NUM_OF] =
-    {
-        [eFLASH_BANK_1] = FLASH_CFG_BANK1_START_ADDR,
-        [eFLASH_BANK_2] = FLASH_CFG_BANK2_START_ADDR,
-    };
+    #if ( FLASH_CFG_FAMILY_G4 == FLASH_CFG_FAMILY )
+        #define FLASH_GEO_BANK2_ADDR(bank_size)     ( FLASH_BASE + 0x40000U )
+    #else
+        #define FLASH_GEO_BANK2_ADDR(bank_size)     ( FLASH_BASE + ( bank_size ))
+    #endif
 
-#endif
+    #if defined( FLASH_OPTR_DBANK )
+        #define FLASH_GEO_IS_DUAL(size)     ( 0U != READ_BIT( FLASH->OPTR, FLASH_OPTR_DBANK ))
+    #elif defined( FLASH_OPTR_DUALBANK )
+        #define FLASH_GEO_IS_DUAL(size)     (( 0x100000U == ( size )) || ( 0U != READ_BIT( FLASH->OPTR, FLASH_OPTR_DUALBANK )))
+    #elif defined( FLASH_OPTR_DUAL_BANK )
+        #define FLASH_GEO_IS_DUAL(size)     ( 0U != READ_BIT( FLASH->OPTR, FLASH_OPTR_DUAL_BANK ))
+    #else
+        #define FLASH_GEO_IS_DUAL(size)     ( false )
+    #endif
 
-////////////////////////////////////////////////////////////////////////////////
-// Function prototypes
-////////////////////////////////////////////////////////////////////////////////
-static uint32_t         flash_count_page            (const uint32_t addr, const uint32_t size);
+    /**
+     *  Bank mode reconfiguration via DBANK option bit (G4/L4+)
+     */
+    #if defined( FLASH_OPTR_DBANK )
+        #define FLASH_BANK_MODE_SUPPORTED   ( 1 )
+        #define FLASH_OB_BANK_MODE(dual)    (( dual ) ? OB_DBANK_64_BITS : OB_DBANK_128_BITS )
+    #else
+        #define FLASH_BANK_MODE_SUPPORTED   ( 0 )
+    #endif
 
-#if ( 0 == FLASH_CFG_DUAL_BANK_MODE_EN )
-    static flash_status_t   flash_erase_single_bank     (const uint32_t addr, const uint32_t size);
-#else
-    static flash_status_t   flash_erase_dual_bank       (const uint32_t addr, const uint32_t size);
-#endif
+    #if ( FLASH_CFG_FAMILY_G0 == FLASH_CFG_FAMILY )
 
-////////////////////////////////////////////////////////////////////////////////
-// Functions
-////////////////////////////////////////////////////////////////////////////////
+        #if defined( FLASH_DBANK_SUPPORT )
+            #define FLASH_JOB_SET_BANK(job,bank)    ((job).Banks = (bank))
+        #else
+            #define FLASH_JOB_SET_BANK(job,bank)    ((void)(bank))
+        #endif
 
-////////////////////////////////////////////////////////////////////////////////
-/**
-*       Calculate number of sectors to overlap
-*
-* @param[in]    addr        - Start address of memory section to analyse
-* @param[in]    size        - Size of memory section to analyse
-* @return       status      - Status of operation
-*/
-////////////////////////////////////////////////////////////////////////////////
-static uint32_t flash_count_page(const uint32_t addr, const uint32_t size)
-{
-    uint32_t sector_count = 0;
+        #ifndef FLASH_BANK_BOTH
+            #define FLASH_BANK_BOTH             ( FLASH_BANK_1 | FLASH_BANK_2 )
+        #endif
 
-    // Calculate start and end sector number
-    const uint32_t start_sector_num = (uint32_t)( addr / FLASH_CFG_PAGE_SIZE_BYTE );
-    const uint32_t end_sector_num   = (uint32_t)(( addr + size -1U ) / FLASH_CFG_PAGE_SIZE_BYTE );
+    #else
+        #define FLASH_JOB_SET_BANK(job,bank)        ((job).Banks = (bank))
+    #endif
 
-    // Sector count that following address space is taken
-    sector_count = (( end_sector_num - start_sector_num ) + 1U );
+#elif ( FLASH_CFG_FAMILY_H7 == FLASH_CFG_FAMILY )
 
-    return sector_count;
-}
+    /**
+     *  Program unit - flash word (256-bit, 128-bit on H7A3/B0)
+     *
+     *  Unit: bytes
+     */
+    #define FLASH_PROG_SIZE                 ( FLASH_NB_32BITWORD_IN_FLASHWORD * 4U )
 
-#if ( 0 == FLASH_CFG_DUAL_BANK_MODE_EN )
+    /**
+     *  No fast programming, row equals program unit
+     *
+     *  Unit: bytes
+     */
+    #define FLASH_ROW_SIZE                  ( FLASH_PROG_SIZE )
 
-    ////////////////////////////////////////////////////////////////////////////////
     /**
-    *       Erase flash memory in single bank configuration
-    *
-    * @param[in]    addr        - Start address of memory
-    * @param[in]    size        - Size of memory section in bytes
-    * @return       status      - Status of operation
-    */
-    ////////////////////////////////////////////////////////////////////////////////
-    static flash_status_t flash_erase_single_bank(const uint32_t addr, const uint32_t size)
-    {
-        flash_status_t          status          = eFLASH_OK;
-        FLASH_EraseInitTypeDef  flash_erase     = {0};
-        uint32_t                sector_error    = 0U;
+     *  Fast programming support
+     */
+    #define FLASH_FAST_PROGRAM_SUPPORTED    ( 0 )
 
-        // Calculate start page
-        const uint32_t start_page = (uint32_t)(( addr - FLASH_BASE ) / FLASH_CFG_PAGE_SIZE_BYTE );
+    /**
+     *  Erase unit - sector
+     */
+    #define FLASH_TYPEERASE_UNIT            ( FLASH_TYPEERASE_SECTORS )
+    #define FLASH_JOB_UNIT(job)             ((job).Sector )
+    #define FLASH_JOB_UNIT_NB(job)          ((job).NbSectors )
+    #define FLASH_JOB_SET_BANK(job,bank)    ((job).Banks = (bank), (job).VoltageRange = FLASH_VOLTAGE_RANGE_3 )
 
-        // Calcualte number of pages
-        const uint32_t num_of_pages = flash_count_page( addr, size );
+    /**
+     *  HAL error flags by error class
+     *
+     *  @note   No alignment or not erased errors reported by H7.
+     */
+    #define FLASH_HAL_ERROR_ALIGN           ( 0U )
+    #define FLASH_HAL_ERROR_WRP             ( HAL_FLASH_ERROR_WRP )
+    #define FLASH_HAL_ERROR_NOT_ERASED      ( 0U )
+    #define FLASH_HAL_ERROR_SEQ             ( HAL_FLASH_ERROR_PGS | HAL_FLASH_ERROR_INC | HAL_FLASH_ERROR_STRB )
+    #define FLASH_HAL_ERROR_ECC             ( HAL_FLASH_ERROR_DBECC )
 
-        FLASH_ASSERT( num_of_pages <= FLASH_PAGE_NB );
+    /**
+     *  Runtime geometry
+     *
+     *  @note   Bank mode is fixed by device, no option bit.
+     */
+    #define FLASH_GEO_PAGE_SIZE(dual)       ( FLASH_SECTOR_SIZE )
+    #define FLASH_GEO_BANK2_ADDR(bank_size) ( FLASH_BASE + ( bank_size ))
 
-        // Setup flash erase
-        flash_erase.TypeErase   = FLASH_TYPEERASE_PAGES;
-        flash_erase.Page        = start_page;
-        flash_erase.NbPages     = num_of_pages;
-        flash_erase.Banks       = FLASH_BANK_1;
+    #if defined( DUAL_BANK )
+        #define FLASH_GEO_IS_DUAL(size)     ( true )
+    #else
+        #define FLASH_GEO_IS_DUAL(size)     ( false )
+    #endif
 
-        // Erase flash
-        if( HAL_OK != HAL_FLASHEx_Erase( &flash_erase, &sector_error ))
-        {
-            status = false;
-        }
+    /**
+     *  No bank mode reconfiguration
+     */
+    #define FLASH_BANK_MODE_SUPPORTED       ( 0 )
 
-        return status;
-    }
+#else
+    #error "Flash: Unsupported FLASH_CFG_FAMILY selection!"
+#endif
 
+#if (( 1 == FLASH_CFG_FAST_PROGRAM_EN ) && ( 0 == FLASH_FAST_PROGRAM_SUPPORTED ))
+    #error "Flash: Fast programming not supported by selected family, disable FLASH_CFG_FAST_PROGRAM_EN!"
 #endif
 
-#if ( 1 == FLASH_CFG_DUAL_BANK_MODE_EN )
+#if (( 1 == FLASH_CFG_LL_PROGRAM_EN ) && ( FLASH_CFG_FAMILY_H7 == FLASH_CFG_FAMILY ))
+    #error "Flash: Register level programming not supported by selected family, disable FLASH_CFG_LL_PROGRAM_EN!"
+#endif
 
-    ////////////////////////////////////////////////////////////////////////////////
-    /**
-    *       Erase flash memory in dual bank configuration
-    *
-    * @param[in]    addr        - Start address of memory
-    * @param[in]    size        - Size of memory section in bytes
-    * @return       status      - Status of operation
-    */
-    ////////////////////////////////////////////////////////////////////////////////
-    static flash_status_t flash_erase_dual_bank(const uint32_t addr, const uint32_t size)
-    {
-        flash_status_t          status                          = eFLASH_OK;
-        FLASH_EraseInitTypeDef  flash_erase                     = {0};
-        flash_bank_data_t       bank_data[eFLASH_BANK_NUM_OF]   = {0};
-        uint32_t                sector_error                    = 0U;
+#if (( 1 == FLASH_CFG_ECC_EN ) && ( FLASH_CFG_FAMILY_H7 == FLASH_CFG_FAMILY ))
+    #error "Flash: ECC monitoring not supported by selected family, disable FLASH_CFG_ECC_EN!"
+#endif
 
-        // Address starts in bank 1
-        if ( addr < FLASH_CFG_BANK2_START_ADDR )
-        {
-            bank_data[eFLASH_BANK_1].addr = addr;
+#if (( 1 == FLASH_CFG_FAULT_INJECT_EN ) && (( 1 == FLASH_CFG_FAST_PROGRAM_EN ) || ( 1 == FLASH_CFG_LL_PROGRAM_EN )))
+    #error "Flash: Fault injection requires per unit programming, disable FLASH_CFG_FAST_PROGRAM_EN and FLASH_CFG_LL_PROGRAM_EN!"
+#endif
 
-            // Single bank operation
-            if (( addr + size ) < FLASH_CFG_BANK2_START_ADDR )
-            {
-                bank_data[eFLASH_BANK_1].size = size;
-            }
+#if (( 1 == FLASH_CFG_ATOMIC_EN ) && ( 0 == FLASH_CFG_ECC_EN ) && ( FLASH_CFG_FAMILY_H7 != FLASH_CFG_FAMILY ))
+    #error "Flash: Atomic slots require FLASH_CFG_ECC_EN, torn commit marker raises ECC NMI at mount!"
+#endif
 
-            // Dual-bank operation
-            else
-            {
-                bank_data[eFLASH_BANK_1].size = ( FLASH_CFG_BANK2_START_ADDR - addr );
+#if (( 1 == FLASH_CFG_LATENCY_EN ) && ( FLASH_CFG_FAMILY_H7 == FLASH_CFG_FAMILY ))
+    #error "Flash: Latency tuning not supported by selected family, disable FLASH_CFG_LATENCY_EN!"
+#endif
 
-                bank_data[eFLASH_BANK_2].addr = FLASH_CFG_BANK2_START_ADDR;
-                bank_data[eFLASH_BANK_2].size = ( size - bank_data[eFLASH_BANK_1].size );
-            }
-        }
+#if (( 1 == FLASH_CFG_BENCHMARK_EN ) && ( FLASH_CFG_FAMILY_G0 == FLASH_CFG_FAMILY ))
+    #error "Flash: No DWT cycle counter on selected family, disable FLASH_CFG_BENCHMARK_EN!"
+#endif
 
-        // Address start in bank 2 -> single bank operation
-        else
-        {
-            bank_data[eFLASH_BANK_2].addr = addr;
-            bank_data[eFLASH_BANK_2].size = size;
-        }
+#if ( 1 == FLASH_CFG_RING_EN )
 
-        // Perform erase opration by bank
-        for ( uint8_t bank = 0; bank < eFLASH_BANK_NUM_OF; bank++ )
-        {
-            // Anything to do?
-            if ( bank_data[bank].size > 0 )
-            {
-                // Calculate start page
-                const uint32_t start_page = (uint32_t)(( bank_data[bank].addr - gu32_flash_base[bank] ) / FLASH_CFG_PAGE_SIZE_BYTE );
+    #if (( 0 == FLASH_CFG_RING_SIZE ) || ( 0 != ( FLASH_CFG_RING_SIZE & ( FLASH_CFG_RING_SIZE - 1 ))))
+        #error "Flash: FLASH_CFG_RING_SIZE must be power of two!"
+    #endif
 
-                // Calcualte number of pages
-                const uint32_t num_of_pages = flash_count_page( bank_data[bank].addr, bank_data[bank].size );
+    /**
+     *  Command ring index mask
+     */
+    #define FLASH_RING_MASK                 ((uint32_t)( FLASH_CFG_RING_SIZE - 1U ))
 
-                FLASH_ASSERT( num_of_pages <= FLASH_PAGE_NB );
+    /**
+     *  Lock-free single-producer/single-consumer command ring
+     */
+    typedef struct
+    {
+        flash_cmd_t         cmd[FLASH_CFG_RING_SIZE];   /**<Command buffer */
+        _Atomic uint32_t    head;                       /**<Write index, owned by producer */
+        _Atomic uint32_t    tail;                       /**<Read index, owned by consumer */
+    } flash_ring_t;
 
-                // Mass erase if all pages in bank needs to be erased
-                flash_erase.TypeErase = ((num_of_pages == FLASH_PAGE_NB) ? FLASH_TYPEERASE_MASSERASE : FLASH_TYPEERASE_PAGES );
+#endif // ( 1 == FLASH_CFG_RING_EN )
 
-                // Select bank
-                flash_erase.Banks = (( bank == eFLASH_BANK_1 ) ? FLASH_BANK_1 : FLASH_BANK_2 );
+#if ( 1 == FLASH_CFG_JOB_EN )
 
-                // Only if page type erase
-                if ( FLASH_TYPEERASE_PAGES == flash_erase.TypeErase  )
-                {
-                    flash_erase.Page        = start_page;
-                    flash_erase.NbPages     = num_of_pages;
-                }
+    /**
+     *  Step budget clock ticks
+     *
+     *  @note   Conversion saturates at clock range, 25 s at 170 MHz.
+     */
+    #if ( FLASH_CFG_FAMILY_G0 == FLASH_CFG_FAMILY )
+        #define FLASH_JOB_TICKS_PER_US      ( 1U )
+    #else
+        #define FLASH_JOB_TICKS_PER_US      ( SystemCoreClock / 1000000U )
+    #endif
 
-                // Erase flash
-                if( HAL_OK != HAL_FLASHEx_Erase( &flash_erase, &sector_error ))
-                {
-                    status = false;
-                }
-            }
-        }
+    #define FLASH_JOB_US_TO_TICKS(us)       ((uint32_t)((( (uint64_t)( us ) * FLASH_JOB_TICKS_PER_US ) > UINT32_MAX ) ? UINT32_MAX : ( (uint64_t)( us ) * FLASH_JOB_TICKS_PER_US )))
+    #define FLASH_JOB_TICKS_TO_US(ticks)    (( ticks ) / FLASH_JOB_TICKS_PER_US )
 
-        return status;
-    }
+    /**
+     *  Last measured durations of step operations
+     */
+    typedef struct
+    {
+        uint32_t    unit;           /**<Program unit */
+        uint32_t    row;            /**<Fast programmed row */
+        uint32_t    page;           /**<Page erase */
+    } flash_job_ticks_t;
 
-#endif
+    /**
+     *  Time budgeted step job control
+     */
+    typedef struct
+    {
+        flash_cmd_t cmd;            /**<Job command */
+        uint32_t    offset;         /**<Processed bytes */
+        bool        is_active;      /**<Job in progress */
+    } flash_job_t;
 
-////////////////////////////////////////////////////////////////////////////////
-/**
-* @} <!-- END GROUP -->
-*/
-////////////////////////////////////////////////////////////////////////////////
+#endif // ( 1 == FLASH_CFG_JOB_EN )
+
+#if ( 1 == FLASH_CFG_SCHED_EN )
+
+    #if ( 0 == FLASH_CFG_JOB_EN )
+        #error "Flash: Scheduler requires FLASH_CFG_JOB_EN!"
+    #endif
+
+    /**
+     *  Longest time measured with step budget clock, half of its range
+     *
+     *  @note   Longer waits are measured with 1 ms system tick.
+     */
+    #define FLASH_SCHED_FINE_MS             ( 0x80000000U / ( FLASH_JOB_TICKS_PER_US * 1000U ))
+
+    /**
+     *  Scheduler slot states
+     */
+    typedef enum
+    {
+        eFLASH_SLOT_FREE = 0,       /**<Slot available */
+        eFLASH_SLOT_CLAIMED,        /**<Slot being filled by producer */
+        eFLASH_SLOT_READY,          /**<Request pending */
+    } flash_slot_state_t;
+
+    /**
+     *  Scheduler request slot
+     */
+    typedef struct
+    {
+        flash_job_t         job;            /**<Request progress, active after first operation */
+        pf_flash_sched_cb_t pf_done;        /**<Completion callback */
+        uint32_t            submit;         /**<Submit time. Unit: clock ticks */
+        uint32_t            submit_ms;      /**<Submit time. Unit: ms */
+        uint32_t            deadline_us;    /**<Deadline relative to submit. Unit: us */
+        uint32_t            seq;            /**<Submit order */
+        flash_prio_t        prio;           /**<Request priority */
+        bool                has_deadline;   /**<Deadline requested */
+        _Atomic uint32_t    state;          /**<Slot state, flash_slot_state_t */
+    } flash_sched_slot_t;
+
+#endif // ( 1 == FLASH_CFG_SCHED_EN )
 
-////////////////////////////////////////////////////////////////////////////////
 /**
-*@addtogroup FLASH_API
-* @{ <!-- BEGIN GROUP -->
-*
-* 	Following function are part of Flash API.
-*/
-////////////////////////////////////////////////////////////////////////////////
+ *  Bank data structure
+ */
+typedef struct
+{
+    uint32_t addr;  /**<Address */
+    uint32_t size;  /**<Size of data from address */
+} flash_bank_data_t;
 
-////////////////////////////////////////////////////////////////////////////////
 /**
-*       Initialize STM32 internal flash
-*
-* @return       status - Status of operation
-*/
-////////////////////////////////////////////////////////////////////////////////
-flash_status_t flash_init(void)
+ *  Cache maintenance of flash access
+ *
+ *  @note   Caches are suspended by first program/erase under flash lock
+ *          and resumed once when lock is released.
+ */
+typedef struct
 {
-    flash_status_t status = eFLASH_OK;
+    uint32_t    acr;            /**<Accelerator state saved at suspend */
+    uint32_t    start;          /**<Start of modified range */
+    uint32_t    end;            /**<End of modified range */
+    uint32_t    lock_num;       /**<Nesting of flash lock */
+    bool        is_suspended;   /**<Caches suspended */
+    bool        is_erase;       /**<Erase done while suspended */
+} flash_cache_t;
 
-    if ( false == gb_is_init )
-    {
-        // Enable flash clock
-        __HAL_RCC_FLASH_CLK_ENABLE();
+/**
+ *  Device size register
+ *
+ *  Unit: kilobytes
+ */
+#define FLASH_GEO_SIZE_KB                   ( *(const volatile uint16_t *) FLASHSIZE_BASE )
 
-        // Wait for flash to be ready
-        while(__HAL_FLASH_GET_FLAG(FLASH_FLAG_BSY) != RESET);
+/**
+ *  Compile time base-2 logarithm of power of two value
+ */
+#define FLASH_LOG2(x)                       (   ((x) >= ( 1UL << 20 )) ? 20U : ((x) >= ( 1UL << 19 )) ? 19U : ((x) >= ( 1UL << 18 )) ? 18U : \
+                                                ((x) >= ( 1UL << 17 )) ? 17U : ((x) >= ( 1UL << 16 )) ? 16U : ((x) >= ( 1UL << 15 )) ? 15U : \
+                                                ((x) >= ( 1UL << 14 )) ? 14U : ((x) >= ( 1UL << 13 )) ? 13U : ((x) >= ( 1UL << 12 )) ? 12U : \
+                                                ((x) >= ( 1UL << 11 )) ? 11U : ((x) >= ( 1UL << 10 )) ? 10U : ((x) >= ( 1UL <<  9 )) ?  9U : \
+                                                ((x) >= ( 1UL <<  8 )) ?  8U : ((x) >= ( 1UL <<  7 )) ?  7U : ((x) >= ( 1UL <<  6 )) ?  6U : \
+                                                ((x) >= ( 1UL <<  5 )) ?  5U : ((x) >= ( 1UL <<  4 )) ?  4U : ((x) >= ( 1UL <<  3 )) ?  3U : \
+                                                ((x) >= ( 1UL <<  2 )) ?  2U : ((x) >= ( 1UL <<  1 )) ?  1U : 0U )
 
-        // Unlock flash
-        if ( HAL_OK != HAL_FLASH_Unlock())
-        {
-            status = eFLASH_ERROR;
-        }
-        else
-        {
-            // Init success
-            gb_is_init = true;
-        }
-    }
+/**
+ *  Page arithmetic derived from power of two page size
+ */
+#define FLASH_PAGE_SHIFT                    ( FLASH_LOG2( FLASH_CFG_PAGE_SIZE_BYTE ))
+#define FLASH_PAGE_MASK                     ((uint32_t)( FLASH_CFG_PAGE_SIZE_BYTE - 1U ))
 
-    return status;
-}
+/**
+ *  Blocking erase page by page
+ *
+ *  @note   With RTOS (erase not interrupt driven) other tasks run while
+ *          page is erased, with fault injection every page is cut point.
+ */
+#if (( 1 == FLASH_CFG_FAULT_INJECT_EN ) || (( FLASH_CFG_OS_BARE_METAL != FLASH_CFG_OS ) && ( 0 == FLASH_CFG_ASYNC_ERASE_EN )))
+    #define FLASH_ERASE_PER_UNIT            ( 1 )
+#else
+    #define FLASH_ERASE_PER_UNIT            ( 0 )
+#endif
 
-////////////////////////////////////////////////////////////////////////////////
 /**
-*       De-Initialize STM32 internal flash
-*
-* @return       status - Status of operation
-*/
-////////////////////////////////////////////////////////////////////////////////
-flash_status_t flash_deinit(void)
-{
-    flash_status_t status = eFLASH_OK;
+ *  Compile time check of flash configuration
+ */
+static_assert( 0U == ( FLASH_CFG_PAGE_SIZE_BYTE & ( FLASH_CFG_PAGE_SIZE_BYTE - 1U )),                "Flash: Page size must be power of two!" );
+static_assert( FLASH_CFG_PAGE_SIZE_BYTE == ( 1UL << FLASH_PAGE_SHIFT ),                             "Flash: Page size out of supported range!" );
+static_assert( 0U == ( FLASH_CFG_PAGE_SIZE_BYTE % FLASH_ROW_SIZE ),                                 "Flash: Page size must be multiple of row size!" );
+static_assert( 0U == ( FLASH_ROW_SIZE % FLASH_PROG_SIZE ),                                          "Flash: Row size must be multiple of program unit!" );
+static_assert( 0U == ( FLASH_PROG_SIZE % 8U ),                                                      "Flash: Program unit must be multiple of 8 bytes!" );
+static_assert( FLASH_CFG_START_ADDR >= FLASH_BASE,                                                  "Flash: User region starts below flash base address!" );
+static_assert( 0U == ( FLASH_CFG_START_ADDR & FLASH_PAGE_MASK ),                                    "Flash: User region start must be page aligned!" );
+static_assert( 0U == ( FLASH_CFG_SIZE_BYTE & FLASH_PAGE_MASK ),                                     "Flash: User region size must be multiple of page size!" );
+static_assert(( FLASH_CFG_START_ADDR + (uint64_t) FLASH_CFG_SIZE_BYTE ) <= 0x100000000ULL,          "Flash: User region exceeds address space!" );
 
-    if ( true == gb_is_init )
-    {
-        // Lock flash
-        if ( HAL_OK != HAL_FLASH_Lock())
-        {
-            status = eFLASH_ERROR;
-        }
-        else
-        {
-            // Disable flash clock
-            __HAL_RCC_FLASH_CLK_DISABLE();
+#if ( 1 == FLASH_CFG_POOL_EN )
+    static_assert( 0U == ( FLASH_CFG_POOL_START_ADDR & FLASH_PAGE_MASK ),                           "Flash: Pool start must be page aligned!" );
+    static_assert( FLASH_CFG_POOL_START_ADDR >= FLASH_CFG_START_ADDR,                               "Flash: Pool must be inside user region!" );
+    static_assert(( FLASH_CFG_POOL_START_ADDR + ( FLASH_CFG_POOL_PAGE_NUM * FLASH_CFG_PAGE_SIZE_BYTE )) <= ( FLASH_CFG_START_ADDR + FLASH_CFG_SIZE_BYTE ),
+                                                                                                    "Flash: Pool must be inside user region!" );
+    static_assert( FLASH_CFG_POOL_PREERASE_NUM <= FLASH_CFG_POOL_PAGE_NUM,                          "Flash: Pool pre-erase number exceeds pool size!" );
+#endif
 
-            // De-init success
-            gb_is_init = false;
-        }
-    }
+#if (( 1 == FLASH_CFG_ECC_EN ) && ( 1 == FLASH_CFG_ECC_REMAP_EN ))
 
-    return status;
-}
+    /**
+     *  Remap area: table page followed by spare pages
+     */
+    #define FLASH_ECC_TABLE_ADDR            ( FLASH_CFG_ECC_REMAP_START_ADDR )
+    #define FLASH_ECC_SPARE_ADDR(n)         ( FLASH_CFG_ECC_REMAP_START_ADDR + ((( n ) + 1U ) << FLASH_PAGE_SHIFT ))
+    #define FLASH_ECC_AREA_SIZE             (( FLASH_CFG_ECC_REMAP_PAGE_NUM + 1U ) * FLASH_CFG_PAGE_SIZE_BYTE )
 
-////////////////////////////////////////////////////////////////////////////////
-/*!
-* @brief        Get Flash initialization flag
-*
-* @param[out]   p_is_init   - Pointer to init flag
-* @return       status      - Status of operation
-*/
-////////////////////////////////////////////////////////////////////////////////
-flash_status_t flash_is_init(bool * const p_is_init)
-{
-    flash_status_t status = eFLASH_OK;
+    /**
+     *  Remap table entry, rounded up to program units
+     */
+    #define FLASH_ECC_ENTRY_SIZE            (((( 4U * sizeof( uint32_t )) + FLASH_PROG_SIZE - 1U ) / FLASH_PROG_SIZE ) * FLASH_PROG_SIZE )
+    #define FLASH_ECC_ENTRY_ADDR(n)         ( FLASH_ECC_TABLE_ADDR + (( n ) * FLASH_ECC_ENTRY_SIZE ))
 
-    FLASH_ASSERT( NULL != p_is_init );
+    /**
+     *  Remap table entry check word
+     */
+    #define FLASH_ECC_ENTRY_CHECK(p)        ( ~(( p )->page ^ ( p )->spare ^ ( p )->seq ))
 
-    if ( NULL != p_is_init )
-    {
-        *p_is_init = gb_is_init;
-    }
-    else
-    {
-        status = eFLASH_ERROR;
-    }
+    static_assert( 0U == ( FLASH_CFG_ECC_REMAP_START_ADDR & FLASH_PAGE_MASK ),                      "Flash: Remap area start must be page aligned!" );
+    static_assert( FLASH_CFG_ECC_REMAP_START_ADDR >= FLASH_CFG_START_ADDR,                          "Flash: Remap area must be inside user region!" );
+    static_assert(( FLASH_CFG_ECC_REMAP_START_ADDR + FLASH_ECC_AREA_SIZE ) <= ( FLASH_CFG_START_ADDR + FLASH_CFG_SIZE_BYTE ),
+                                                                                                    "Flash: Remap area must be inside user region!" );
+    static_assert( FLASH_CFG_ECC_REMAP_PAGE_NUM <= ( FLASH_CFG_PAGE_SIZE_BYTE / FLASH_ECC_ENTRY_SIZE ), "Flash: Remap table does not fit into single page!" );
 
-    return status;
+    #if ( 1 == FLASH_CFG_POOL_EN )
+        static_assert(  (( FLASH_CFG_ECC_REMAP_START_ADDR + FLASH_ECC_AREA_SIZE ) <= FLASH_CFG_POOL_START_ADDR )
+                    ||  ( FLASH_CFG_ECC_REMAP_START_ADDR >= ( FLASH_CFG_POOL_START_ADDR + ( FLASH_CFG_POOL_PAGE_NUM * FLASH_CFG_PAGE_SIZE_BYTE ))),
+                                                                                                    "Flash: Remap area overlaps pool!" );
+    #endif
 
-    return status;
-}
+#endif
+
+#if ( 1 == FLASH_CFG_ATOMIC_EN )
+
+    /**
+     *  Atomic area: two pages per slot, commit marker in last program unit
+     */
+    #define FLASH_ATOMIC_PAGE_ADDR(slot,copy)   ( FLASH_CFG_ATOMIC_START_ADDR + ((( 2U * ( slot )) + ( copy )) << FLASH_PAGE_SHIFT ))
+    #define FLASH_ATOMIC_COMMIT_OFFSET          ( FLASH_CFG_PAGE_SIZE_BYTE - FLASH_PROG_SIZE )
+    #define FLASH_ATOMIC_AREA_SIZE              ( 2U * FLASH_CFG_ATOMIC_SLOT_NUM * FLASH_CFG_PAGE_SIZE_BYTE )
+
+    static_assert( 0U == ( FLASH_CFG_ATOMIC_START_ADDR & FLASH_PAGE_MASK ),                         "Flash: Atomic area start must be page aligned!" );
+    static_assert( FLASH_CFG_ATOMIC_START_ADDR >= FLASH_CFG_START_ADDR,                             "Flash: Atomic area must be inside user region!" );
+    static_assert(( FLASH_CFG_ATOMIC_START_ADDR + FLASH_ATOMIC_AREA_SIZE ) <= ( FLASH_CFG_START_ADDR + FLASH_CFG_SIZE_BYTE ),
+                                                                                                    "Flash: Atomic area must be inside user region!" );
+    static_assert( FLASH_ATOMIC_DATA_SIZE <= FLASH_ATOMIC_COMMIT_OFFSET,                            "Flash: Atomic data overlaps commit marker!" );
+
+    #if ( 1 == FLASH_CFG_POOL_EN )
+        static_assert(  (( FLASH_CFG_ATOMIC_START_ADDR + FLASH_ATOMIC_AREA_SIZE ) <= FLASH_CFG_POOL_START_ADDR )
+                    ||  ( FLASH_CFG_ATOMIC_START_ADDR >= ( FLASH_CFG_POOL_START_ADDR + ( FLASH_CFG_POOL_PAGE_NUM * FLASH_CFG_PAGE_SIZE_BYTE ))),
+                                                                                                    "Flash: Atomic area overlaps pool!" );
+    #endif
+
+    #if (( 1 == FLASH_CFG_ECC_EN ) && ( 1 == FLASH_CFG_ECC_REMAP_EN ))
+        static_assert(  (( FLASH_CFG_ATOMIC_START_ADDR + FLASH_ATOMIC_AREA_SIZE ) <= FLASH_CFG_ECC_REMAP_START_ADDR )
+                    ||  ( FLASH_CFG_ATOMIC_START_ADDR >= ( FLASH_CFG_ECC_REMAP_START_ADDR + FLASH_ECC_AREA_SIZE )),
+                                                                                                    "Flash: Atomic area overlaps remap area!" );
+    #endif
+
+#endif
+
+#if ( 1 == FLASH_CFG_BATCH_EN )
+
+    /**
+     *  Write batching staging row
+     */
+    typedef struct
+    {
+        uint32_t    row[FLASH_ROW_SIZE / sizeof( uint32_t )];   /**<Staged data */
+        uint8_t     byte_mask[FLASH_ROW_SIZE / 8U];             /**<Staged bytes, bit per byte */
+        uint32_t    addr;                                       /**<Row start address */
+        uint32_t    tick;                                       /**<Timestamp of first staged write */
+        bool        is_used;                                    /**<Any data staged */
+    } flash_batch_t;
+
+#endif // ( 1 == FLASH_CFG_BATCH_EN )
+
+#if ( 1 == FLASH_CFG_ASYNC_ERASE_EN )
+
+    /**
+     *  Interrupt driven erase control
+     */
+    typedef struct
+    {
+        FLASH_EraseInitTypeDef  job[eFLASH_BANK_NUM_OF];    /**<Erase jobs, one per bank */
+        pf_flash_erase_cb_t     pf_done;                    /**<Erase completion callback */
+        uint32_t                start_tick;                 /**<Erase start timestamp */
+        uint8_t                 job_num;                    /**<Number of erase jobs */
+        volatile uint8_t        job_idx;                    /**<Current erase job */
+        volatile bool           job_done;                   /**<Current erase job completed */
+        volatile flash_status_t job_err;                    /**<Erase error, eFLASH_OK if none */
+        volatile bool           busy;                       /**<Erase in progress */
+        volatile flash_status_t result;                     /**<Status of last completed erase */
+    } flash_async_t;
+
+#endif // ( 1 == FLASH_CFG_ASYNC_ERASE_EN )
+
+#if ( 1 == FLASH_CFG_POOL_EN )
+
+    /**
+     *  Pre-erased page pool page states
+     */
+    typedef enum
+    {
+        eFLASH_POOL_PAGE_USED = 0,  /**<Page allocated to user */
+        eFLASH_POOL_PAGE_DIRTY,     /**<Page released, waiting for erase */
+        eFLASH_POOL_PAGE_ERASING,   /**<Page erase in progress */
+        eFLASH_POOL_PAGE_ERASED,    /**<Page erased, ready for allocation */
+    } flash_pool_page_state_t;
+
+    /**
+     *  Pre-erased page pool control
+     */
+    typedef struct
+    {
+        volatile flash_pool_page_state_t    state[FLASH_CFG_POOL_PAGE_NUM];     /**<Page states */
+        uint32_t                            alloc_idx;                          /**<Next page to allocate */
+        uint32_t                            erase_idx;                          /**<Page being erased */
+    } flash_pool_t;
+
+#endif // ( 1 == FLASH_CFG_POOL_EN )
+
+#if ( 1 == FLASH_CFG_ECC_EN )
+
+    /**
+     *  ECC monitoring control
+     */
+    typedef struct
+    {
+        uint32_t            corr_addr;                                  /**<Address of last corrected error */
+        uint32_t            uncorr_addr;                                /**<Address of last uncorrectable error */
+        volatile bool       is_probe;                                   /**<Probing possibly torn data, uncorrectable errors masked */
+        volatile bool       is_probe_err;                               /**<Uncorrectable error masked while probing */
+
+        #if ( 1 == FLASH_CFG_ECC_REMAP_EN )
+            uint32_t        page[FLASH_CFG_ECC_REMAP_PAGE_NUM];         /**<Relocated pages */
+            uint32_t        spare[FLASH_CFG_ECC_REMAP_PAGE_NUM];        /**<Spare page of relocated page */
+            uint32_t        map_num;                                    /**<Number of relocated pages */
+            uint32_t        entry_num;                                  /**<Number of used table slots, equals used spare pages */
+            volatile uint32_t   pending_addr;                           /**<Address of corrected error waiting for relocation */
+            volatile bool       is_pending;                             /**<Relocation pending */
+        #endif
+    } flash_ecc_t;
+
+    /**
+     *  Remap table entry
+     *
+     *  @note   Sequence number and check word are in last program unit,
+     *          programmed after page and spare, thus acting as commit marker.
+     */
+    typedef struct
+    {
+        uint32_t page;      /**<Relocated page */
+        uint32_t spare;     /**<Spare page */
+        uint32_t seq;       /**<Sequence number, equals table slot */
+        uint32_t check;     /**<Check word, FLASH_ECC_ENTRY_CHECK */
+    } flash_ecc_entry_t;
+
+#endif // ( 1 == FLASH_CFG_ECC_EN )
+
+#if ( 1 == FLASH_CFG_ATOMIC_EN )
+
+    /**
+     *  Atomic slot state
+     */
+    typedef struct
+    {
+        uint32_t    seq;        /**<Sequence number of valid copy */
+        uint8_t     copy;       /**<Page holding valid copy */
+        bool        is_valid;   /**<Slot holds committed data */
+    } flash_atomic_slot_t;
+
+    /**
+     *  Atomic commit marker
+     *
+     *  @note   Programmed last, torn marker fails inverted sequence check.
+     */
+    typedef struct
+    {
+        uint32_t    seq;        /**<Sequence number */
+        uint32_t    seq_inv;    /**<Inverted sequence number */
+    } flash_atomic_commit_t;
+
+#endif // ( 1 == FLASH_CFG_ATOMIC_EN )
+
+#if ( 1 == FLASH_CFG_FAULT_INJECT_EN )
+
+    /**
+     *  Fault injection control
+     */
+    typedef struct
+    {
+        pf_flash_fault_cb_t pf_cut;     /**<Power cut callback */
+        uint32_t            op_num;     /**<Operations left before cut */
+        bool                is_armed;   /**<Cut armed */
+    } flash_fault_t;
+
+#endif // ( 1 == FLASH_CFG_FAULT_INJECT_EN )
 
 ////////////////////////////////////////////////////////////////////////////////
-/*!
-* @brief        Write to flash
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ *  Initialization flag
+ */
+static bool gb_is_init = false;
+
+
+/**
+ *  Flash statistics
+ */
+static flash_stats_t g_flash_stats = {0};
+
+/**
+ *  Last flash error
+ */
+static flash_error_t g_flash_error = { .status = eFLASH_OK, .sector_error = 0xFFFFFFFFU };
+
+/**
+ *  Detected flash geometry
+ */
+static flash_geometry_t g_flash_geo = {0};
+
+/**
+ *  Base-2 logarithm of erase unit size
+ */
+static uint32_t gu32_flash_page_shift = 0U;
+
+/**
+ *  Cache maintenance
+ */
+static flash_cache_t g_flash_cache = {0};
+
+#if ( FLASH_CFG_OS_FREERTOS == FLASH_CFG_OS )
+
+    /**
+     *  Flash access mutex
+     */
+    static SemaphoreHandle_t g_flash_mutex = NULL;
+
+#elif ( FLASH_CFG_OS_CMSIS_RTOS2 == FLASH_CFG_OS )
+
+    /**
+     *  Flash access mutex
+     */
+    static osMutexId_t g_flash_mutex = NULL;
+
+    /**
+     *  Flash access mutex attributes
+     */
+    static const osMutexAttr_t g_flash_mutex_attr =
+    {
+        .name       = "flash",
+        .attr_bits  = ( osMutexRecursive | osMutexPrioInherit ),
+    };
+
+#endif
+
+#if ( 1 == FLASH_CFG_ASYNC_ERASE_EN )
+
+    /**
+     *  Interrupt driven erase control
+     */
+    static flash_async_t g_flash_async = {0};
+
+#endif
+
+#if ( 1 == FLASH_CFG_POOL_EN )
+
+    /**
+     *  Pre-erased page pool
+     */
+    static flash_pool_t g_flash_pool = {0};
+
+#endif
+
+#if ( 1 == FLASH_CFG_BATCH_EN )
+
+    /**
+     *  Write batching staging row
+     */
+    static flash_batch_t g_flash_batch = {0};
+
+#endif
+
+#if ( 1 == FLASH_CFG_ECC_EN )
+
+    /**
+     *  ECC monitoring control
+     */
+    static flash_ecc_t g_flash_ecc = {0};
+
+#endif
+
+#if ( 1 == FLASH_CFG_ATOMIC_EN )
+
+    /**
+     *  Atomic slots
+     */
+    static flash_atomic_slot_t g_flash_atomic[FLASH_CFG_ATOMIC_SLOT_NUM] = {0};
+
+#endif
+
+#if ( 1 == FLASH_CFG_FAULT_INJECT_EN )
+
+    /**
+     *  Fault injection control
+     */
+    static flash_fault_t g_flash_fault = {0};
+
+#endif
+
+#if ( 1 == FLASH_CFG_LATENCY_EN )
+
+    /**
+     *  Maximum HCLK per number of wait states
+     *
+     *  Unit: Hz
+     */
+    #if ( FLASH_CFG_FAMILY_G4 == FLASH_CFG_FAMILY )
+        static const uint32_t g_flash_ws_boost_hz[]     = { 34000000U, 68000000U, 102000000U, 136000000U, 170000000U };
+        static const uint32_t g_flash_ws_range1_hz[]    = { 30000000U, 60000000U, 90000000U, 120000000U, 150000000U };
+        static const uint32_t g_flash_ws_range2_hz[]    = { 12000000U, 24000000U, 26000000U };
+    #elif ( FLASH_CFG_FAMILY_L4 == FLASH_CFG_FAMILY )
+        #if defined( PWR_REGULATOR_VOLTAGE_SCALE1_BOOST )
+
+            // L4+ (RM0432), boost mode exists on L4+ only
+            static const uint32_t g_flash_ws_boost_hz[]     = { 20000000U, 40000000U, 60000000U, 80000000U, 100000000U, 120000000U };
+            static const uint32_t g_flash_ws_range1_hz[]    = { 20000000U, 40000000U, 60000000U, 80000000U };
+            static const uint32_t g_flash_ws_range2_hz[]    = { 8000000U, 16000000U, 26000000U };
+
+        #else
+
+            // L4 (RM0351)
+            static const uint32_t g_flash_ws_range1_hz[]    = { 16000000U, 32000000U, 48000000U, 64000000U, 80000000U };
+            static const uint32_t g_flash_ws_range2_hz[]    = { 6000000U, 12000000U, 18000000U, 26000000U };
+
+        #endif
+    #else
+        static const uint32_t g_flash_ws_range1_hz[]    = { 24000000U, 48000000U, 64000000U };
+        static const uint32_t g_flash_ws_range2_hz[]    = { 8000000U, 16000000U };
+    #endif
+
+#endif
+
+#if ( 1 == FLASH_CFG_RING_EN )
+
+    /**
+     *  Command ring
+     */
+    static flash_ring_t g_flash_ring = {0};
+
+#endif
+
+#if ( 1 == FLASH_CFG_JOB_EN )
+
+    /**
+     *  Step job
+     */
+    static flash_job_t g_flash_job = {0};
+
+    /**
+     *  Step operation durations, shared by step job and scheduler
+     */
+    static flash_job_ticks_t g_flash_job_ticks = {0};
+
+#endif
+
+#if ( 1 == FLASH_CFG_SCHED_EN )
+
+    /**
+     *  Scheduler request slots
+     */
+    static flash_sched_slot_t g_flash_sched[FLASH_CFG_SCHED_SIZE] = {0};
+
+    /**
+     *  Scheduler submit order counter
+     */
+    static _Atomic uint32_t g_flash_sched_seq = 0U;
+
+    /**
+     *  Rejected submit counter, kept apart from statistics as submit is
+     *  called from several interrupt contexts. Merged by flash_get_stats.
+     */
+    static _Atomic uint32_t g_flash_sched_drop_num = 0U;
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Function prototypes
+////////////////////////////////////////////////////////////////////////////////
+static flash_status_t   flash_geo_init              (void);
+static inline bool      flash_is_in_region          (const uint32_t addr, const uint32_t size);
+static inline uint32_t  flash_mem_addr              (const uint32_t addr);
+static uint32_t         flash_count_page            (const uint32_t addr, const uint32_t size);
+static void             flash_get_bank_region       (const flash_bank_t bank, uint32_t * const p_addr, uint32_t * const p_size);
+
+static void             flash_erase_stats           (const FLASH_EraseInitTypeDef * const p_job);
+static flash_status_t   flash_error                 (const HAL_StatusTypeDef hal_status, const uint32_t hal_error, const uint32_t addr, const uint32_t sector_error);
+static uint32_t         flash_erase_error_addr      (const FLASH_EraseInitTypeDef * const p_job, const uint32_t sector_error);
+static flash_status_t   flash_erase_execute         (FLASH_EraseInitTypeDef * const p_job, const uint8_t job_num);
+
+#if (( FLASH_CFG_FAMILY_H7 != FLASH_CFG_FAMILY ) && ( 1 == FLASH_ERASE_PER_UNIT ))
+    static void             flash_erase_unit_start      (const FLASH_EraseInitTypeDef * const p_job);
+    static flash_status_t   flash_erase_unit_end        (const FLASH_EraseInitTypeDef * const p_job);
+#endif
+
+static bool             flash_is_busy_internal      (void);
+static flash_status_t   flash_os_init               (void);
+static void             flash_os_mutex_lock         (void);
+static void             flash_os_mutex_unlock       (void);
+
+#if (( FLASH_CFG_OS_BARE_METAL != FLASH_CFG_OS ) || ( 1 == FLASH_ERASE_PER_UNIT ))
+    static void             flash_os_yield              (void);
+#endif
+
+static flash_status_t   flash_lock                  (void);
+static void             flash_unlock                (void);
+static flash_status_t   flash_lock_error            (void);
+static inline void      flash_job_set               (FLASH_EraseInitTypeDef * const p_job, const uint32_t type, const uint32_t bank, const uint32_t unit, const uint32_t unit_num);
+static inline flash_status_t flash_program_unit (const uint32_t addr, const uint8_t * const p_unit);
+static flash_status_t   flash_program_units         (const uint32_t addr, const uint32_t unit_num, const uint8_t * const p_data);
+static flash_status_t   flash_program_phys          (const uint32_t addr, const uint32_t size, const uint8_t * const p_data, const bool is_fast);
+static flash_status_t   flash_program_sel           (const uint32_t addr, const uint32_t size, const uint8_t * const p_data, const bool is_fast);
+static flash_status_t   flash_program               (const uint32_t addr, const uint32_t size, const uint8_t * const p_data);
+static uint8_t          flash_erase_plan            (const uint32_t addr, const uint32_t size, FLASH_EraseInitTypeDef * const p_job);
+static void             flash_read_internal         (const uint32_t addr, const uint32_t size, uint8_t * const p_data);
+static void             flash_cache_suspend         (const uint32_t addr, const uint32_t size);
+static void             flash_cache_resume          (void);
+
+#if ( FLASH_CFG_FAMILY_H7 == FLASH_CFG_FAMILY )
+    static void         flash_cache_invalidate      (const uint32_t addr, const uint32_t size);
+#endif
+static void             flash_read_desc_sort        (flash_read_desc_t * const p_desc, const uint32_t count);
+static flash_status_t   flash_find_prepare          (const uint32_t addr, const uint32_t size, const uint32_t align, const uint32_t * const p_addr);
+static inline bool      flash_unit_is_blank         (const uint32_t addr);
+static uint32_t         flash_find_blank            (const uint32_t addr, const uint32_t unit_num, const bool is_monotonic);
+static uint32_t         flash_compare_mem           (const uint32_t mem_addr, const uint32_t size, const uint8_t * const p_data);
+static uint32_t         flash_iov_gather            (const flash_iovec_t * const p_iov, const uint32_t count, uint32_t * const p_idx, uint32_t * const p_offset, uint8_t * const p_dst, const uint32_t size);
+static uint8_t          flash_erase_single_bank     (const uint32_t addr, const uint32_t size, FLASH_EraseInitTypeDef * const p_job);
+static uint8_t          flash_erase_dual_bank       (const uint32_t addr, const uint32_t size, FLASH_EraseInitTypeDef * const p_job);
+
+#if ( 1 == FLASH_BANK_MODE_SUPPORTED )
+    static bool             flash_bank_is_running_bank2 (void);
+#endif
+
+#if ( 1 == FLASH_CFG_ASYNC_ERASE_EN )
+    static flash_status_t   flash_async_start           (FLASH_EraseInitTypeDef * const p_job, const uint8_t job_num, pf_flash_erase_cb_t pf_done);
+    static flash_status_t   flash_async_start_job       (void);
+    static void             flash_async_finish          (const flash_status_t status);
+#endif
+
+#if ( 1 == FLASH_CFG_POOL_EN )
+    static uint32_t         flash_pool_page_addr        (const uint32_t page);
+    static void             flash_pool_init             (void);
+    static uint32_t         flash_pool_count_erased     (void);
+    static void             flash_pool_erase_done       (const flash_status_t status);
+#endif
+
+#if ( 1 == FLASH_CFG_LL_PROGRAM_EN )
+    static flash_status_t   flash_ll_program            (const uint32_t addr, const uint32_t unit_num, const uint8_t * const p_data);
+#endif
+
+#if ( 1 == FLASH_CFG_ECC_EN )
+    static uint32_t         flash_ecc_addr              (const uint32_t eccr);
+    static void             flash_ecc_isr               (void);
+#endif
+
+#if (( 1 == FLASH_CFG_ECC_EN ) && ( 1 == FLASH_CFG_ATOMIC_EN ))
+    static bool             flash_ecc_probe             (const uint32_t addr, const uint32_t size, uint8_t * const p_data);
+#endif
+
+#if (( 1 == FLASH_CFG_ECC_EN ) && ( 1 == FLASH_CFG_ECC_REMAP_EN ))
+    static uint32_t         flash_ecc_translate         (const uint32_t addr);
+    static bool             flash_ecc_entry_is_valid    (const flash_ecc_entry_t * const p_entry, const uint32_t slot);
+    static void             flash_ecc_load              (void);
+    static flash_status_t   flash_ecc_relocate          (const uint32_t addr);
+    static flash_status_t   flash_ecc_erase_remapped    (const uint32_t addr, const uint32_t size);
+#endif
+
+#if ( 1 == FLASH_CFG_ATOMIC_EN )
+    static void             flash_atomic_init           (void);
+    static bool             flash_atomic_commit_read    (const uint32_t page_addr, uint32_t * const p_seq);
+    static flash_status_t   flash_atomic_page_erase     (const uint32_t page_addr);
+#endif
+
+#if ( 1 == FLASH_CFG_FAULT_INJECT_EN )
+    static bool             flash_fault_hit             (void);
+    static flash_status_t   flash_fault_cut_program     (const uint32_t addr, const uint8_t * const p_unit);
+    static flash_status_t   flash_fault_cut_erase       (const FLASH_EraseInitTypeDef * const p_job);
+#endif
+
+#if ( 1 == FLASH_CFG_LATENCY_EN )
+    static uint32_t         flash_latency_calc          (const uint32_t hclk, const uint32_t vrange);
+    static flash_status_t   flash_latency_apply         (const uint32_t latency);
+#endif
+
+#if ( 1 == FLASH_CFG_JOB_EN )
+    static uint32_t         flash_job_clock             (void);
+    static uint32_t         flash_job_next              (const flash_job_t * const p_job, uint32_t ** const pp_ticks);
+    static flash_status_t   flash_job_exec              (flash_job_t * const p_job, const uint32_t chunk, uint32_t * const p_ticks);
+#endif
+
+#if ( 1 == FLASH_CFG_SCHED_EN )
+    static uint32_t         flash_sched_elapsed_us      (const flash_sched_slot_t * const p_slot, const uint32_t now, const uint32_t now_ms);
+    static flash_sched_slot_t * flash_sched_pick        (const uint32_t now, const uint32_t now_ms);
+    static void             flash_sched_complete        (flash_sched_slot_t * const p_slot, const flash_status_t status);
+#endif
+
+#if ( 1 == FLASH_CFG_BATCH_EN )
+    static flash_status_t   flash_batch_flush_internal  (void);
+    static flash_status_t   flash_batch_sync            (const uint32_t addr, const uint32_t size);
+    static bool             flash_batch_is_unit_staged  (const uint32_t unit);
+    static bool             flash_batch_is_row_full     (void);
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Detect flash geometry of device
+*
+* @note     Total size is read from device size register, bank mode from
+*           option bytes. Page arithmetic and bank split of all erase
+*           operations are derived from detected geometry.
 *
-* @param[in]    addr        - Flash address
-* @param[in]    size        - Size of data to write in bytes
-* @param[in]    p_data      - Data to write
 * @return       status      - Status of operation
 */
 ////////////////////////////////////////////////////////////////////////////////
-flash_status_t flash_write(const uint32_t addr, const uint32_t size, const uint8_t * const p_data)
+static flash_status_t flash_geo_init(void)
 {
-    flash_status_t  status      = eFLASH_OK;
-    uint64_t        flash_data  = 0UL;
+    flash_status_t  status  = eFLASH_OK;
+    const uint32_t  size    = ((uint32_t) FLASH_GEO_SIZE_KB << 10U );
+    const bool      is_dual = FLASH_GEO_IS_DUAL( size );
+    uint64_t        end     = 0U;
+
+    g_flash_geo.size            = size;
+    g_flash_geo.is_dual_bank    = is_dual;
+    g_flash_geo.bank_size       = (( true == is_dual ) ? ( size >> 1U ) : size );
+    g_flash_geo.bank2_addr      = (( true == is_dual ) ? FLASH_GEO_BANK2_ADDR( g_flash_geo.bank_size ) : 0U );
+    g_flash_geo.page_size       = FLASH_GEO_PAGE_SIZE( is_dual );
+    g_flash_geo.page_num        = 0U;
+
+    // End of flash, bank 2 may be placed past end of bank 1
+    end = (( true == is_dual ) ? ( g_flash_geo.bank2_addr + (uint64_t) g_flash_geo.bank_size ) : ( FLASH_BASE + (uint64_t) size ));
+
+    gu32_flash_page_shift = 0U;
+
+    while (( 1UL << gu32_flash_page_shift ) < g_flash_geo.page_size )
+    {
+        gu32_flash_page_shift++;
+    }
+
+    // Page must be power of two, user region must be built from whole pages
+    // and must not overlap gap between banks
+    if  (   ( 0U == size )
+        ||  ( g_flash_geo.page_size != ( 1UL << gu32_flash_page_shift ))
+        ||  ( 0U != ( FLASH_CFG_PAGE_SIZE_BYTE % g_flash_geo.page_size ))
+        ||  (( FLASH_CFG_START_ADDR + (uint64_t) FLASH_CFG_SIZE_BYTE ) > end )
+        ||  (   ( true == is_dual )
+            &&  ( g_flash_geo.bank2_addr > ( FLASH_BASE + g_flash_geo.bank_size ))
+            &&  ( FLASH_CFG_START_ADDR < g_flash_geo.bank2_addr )
+            &&  (( FLASH_CFG_START_ADDR + (uint64_t) FLASH_CFG_SIZE_BYTE ) > ( FLASH_BASE + g_flash_geo.bank_size ))))
+    {
+        status = eFLASH_ERROR;
+    }
+    else
+    {
+        g_flash_geo.page_num = ( g_flash_geo.bank_size >> gu32_flash_page_shift );
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Check if memory range is inside user flash region
+*
+* @note     Overflow safe, region bounds are compile time constants.
+*
+* @param[in]    addr        - Start address of memory range
+* @param[in]    size        - Size of memory range in bytes
+* @return       is_in       - Memory range inside user flash region
+*/
+////////////////////////////////////////////////////////////////////////////////
+static inline bool flash_is_in_region(const uint32_t addr, const uint32_t size)
+{
+    return  (   ( addr >= FLASH_CFG_START_ADDR )
+            &&  ( size <= FLASH_CFG_SIZE_BYTE )
+            &&  (( addr - FLASH_CFG_START_ADDR ) <= ( FLASH_CFG_SIZE_BYTE - size )));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Get memory mapped address of flash address
+*
+* @note     Address of relocated page when ECC remapping is enabled. Result
+*           is valid up to end of page.
+*
+* @param[in]    addr        - Flash address
+* @return       addr        - Memory mapped address
+*/
+////////////////////////////////////////////////////////////////////////////////
+static inline uint32_t flash_mem_addr(const uint32_t addr)
+{
+    #if (( 1 == FLASH_CFG_ECC_EN ) && ( 1 == FLASH_CFG_ECC_REMAP_EN ))
+        return flash_ecc_translate( addr );
+    #else
+        return addr;
+    #endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Calculate number of sectors to overlap
+*
+* @param[in]    addr        - Start address of memory section to analyse
+* @param[in]    size        - Size of memory section to analyse
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+static uint32_t flash_count_page(const uint32_t addr, const uint32_t size)
+{
+    uint32_t sector_count = 0;
+
+    // Calculate start and end sector number
+    const uint32_t start_sector_num = (uint32_t)( addr >> gu32_flash_page_shift );
+    const uint32_t end_sector_num   = (uint32_t)(( addr + size -1U ) >> gu32_flash_page_shift );
+
+    // Sector count that following address space is taken
+    sector_count = (( end_sector_num - start_sector_num ) + 1U );
+
+    return sector_count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Get memory region occupied by bank
+*
+* @param[in]    bank        - Flash bank
+* @param[out]   p_addr      - Start address of bank
+* @param[out]   p_size      - Size of bank in bytes
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void flash_get_bank_region(const flash_bank_t bank, uint32_t * const p_addr, uint32_t * const p_size)
+{
+    *p_addr = (( eFLASH_BANK_2 == bank ) ? g_flash_geo.bank2_addr : FLASH_BASE );
+    *p_size = g_flash_geo.bank_size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Check if interrupt driven erase is in progress
+*
+* @return       busy    - Erase in progress
+*/
+////////////////////////////////////////////////////////////////////////////////
+static bool flash_is_busy_internal(void)
+{
+    #if ( 1 == FLASH_CFG_ASYNC_ERASE_EN )
+        return g_flash_async.busy;
+    #else
+        return false;
+    #endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Initialize OS resources
+*
+* @note     Mutex is created only once and kept over de-initialization.
+*
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+static flash_status_t flash_os_init(void)
+{
+    flash_status_t status = eFLASH_OK;
+
+    #if ( FLASH_CFG_OS_FREERTOS == FLASH_CFG_OS )
+
+        if ( NULL == g_flash_mutex )
+        {
+            g_flash_mutex = xSemaphoreCreateRecursiveMutex();
+        }
+
+        if ( NULL == g_flash_mutex )
+        {
+            status = eFLASH_ERROR;
+        }
+
+    #elif ( FLASH_CFG_OS_CMSIS_RTOS2 == FLASH_CFG_OS )
+
+        if ( NULL == g_flash_mutex )
+        {
+            g_flash_mutex = osMutexNew( &g_flash_mutex_attr );
+        }
+
+        if ( NULL == g_flash_mutex )
+        {
+            status = eFLASH_ERROR;
+        }
+
+    #endif
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Take flash access mutex
+*
+* @note     Mutex is recursive, so API functions can call each other.
+*
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void flash_os_mutex_lock(void)
+{
+    #if ( FLASH_CFG_OS_FREERTOS == FLASH_CFG_OS )
+        (void) xSemaphoreTakeRecursive( g_flash_mutex, portMAX_DELAY );
+    #elif ( FLASH_CFG_OS_CMSIS_RTOS2 == FLASH_CFG_OS )
+        (void) osMutexAcquire( g_flash_mutex, osWaitForever );
+    #endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Release flash access mutex
+*
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void flash_os_mutex_unlock(void)
+{
+    #if ( FLASH_CFG_OS_FREERTOS == FLASH_CFG_OS )
+        (void) xSemaphoreGiveRecursive( g_flash_mutex );
+    #elif ( FLASH_CFG_OS_CMSIS_RTOS2 == FLASH_CFG_OS )
+        (void) osMutexRelease( g_flash_mutex );
+    #endif
+}
+
+#if (( FLASH_CFG_OS_BARE_METAL != FLASH_CFG_OS ) || ( 1 == FLASH_ERASE_PER_UNIT ))
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Give CPU to other tasks while waiting on flash
+    *
+    * @note     Task sleeps, so lower priority tasks are running as well. In
+    *           bare-metal configuration this is busy wait.
+    *
+    * @return       void
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static void flash_os_yield(void)
+    {
+        #if ( FLASH_CFG_OS_FREERTOS == FLASH_CFG_OS )
+            vTaskDelay( pdMS_TO_TICKS( FLASH_CFG_OS_WAIT_MS ));
+        #elif ( FLASH_CFG_OS_CMSIS_RTOS2 == FLASH_CFG_OS )
+            (void) osDelay( FLASH_CFG_OS_WAIT_MS );
+        #endif
+    }
+
+#endif // (( FLASH_CFG_OS_BARE_METAL != FLASH_CFG_OS ) || ( 1 == FLASH_ERASE_PER_UNIT ))
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Get exclusive access to flash controller
+*
+* @note     With RTOS task sleeps until interrupt driven erase completes.
+*           In bare-metal configuration request is rejected as busy instead.
+*
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+static flash_status_t flash_lock(void)
+{
+    flash_status_t status = eFLASH_OK;
+
+    flash_os_mutex_lock();
+
+    #if ( FLASH_CFG_OS_BARE_METAL != FLASH_CFG_OS )
+
+        while ( true == flash_is_busy_internal())
+        {
+            flash_os_yield();
+        }
+
+    #else
+
+        if ( true == flash_is_busy_internal())
+        {
+            status = eFLASH_ERROR_BUSY;
+        }
+
+    #endif
+
+    if ( eFLASH_OK != status )
+    {
+        flash_os_mutex_unlock();
+    }
+    else
+    {
+        g_flash_cache.lock_num++;
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Release exclusive access to flash controller
+*
+* @note     Caches suspended by program/erase are resumed once, on release
+*           of outermost lock.
+*
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void flash_unlock(void)
+{
+    g_flash_cache.lock_num--;
+
+    if  (   ( 0U == g_flash_cache.lock_num )
+        &&  ( true == g_flash_cache.is_suspended ))
+    {
+        flash_cache_resume();
+    }
+
+    flash_os_mutex_unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Get status of rejected API request
+*
+* @note     Request with valid arguments is rejected by flash_lock() only
+*           in bare-metal configuration while interrupt driven erase is in
+*           progress, e.g. background pool erase. It is reported as busy,
+*           so caller can retry once flash_is_busy() is cleared.
+*
+* @return       status      - Busy or general error
+*/
+////////////////////////////////////////////////////////////////////////////////
+static flash_status_t flash_lock_error(void)
+{
+    flash_status_t status = eFLASH_ERROR;
+
+    #if ( FLASH_CFG_OS_BARE_METAL == FLASH_CFG_OS )
+
+        if ( true == flash_is_busy_internal())
+        {
+            status = eFLASH_ERROR_BUSY;
+        }
+
+    #endif
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Fill erase job
+*
+* @param[out]   p_job       - Erase job
+* @param[in]    type        - Erase type, mass or erase unit
+* @param[in]    bank        - HAL bank selection
+* @param[in]    unit        - First erase unit (page/sector) inside bank
+* @param[in]    unit_num    - Number of erase units
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static inline void flash_job_set(FLASH_EraseInitTypeDef * const p_job, const uint32_t type, const uint32_t bank, const uint32_t unit, const uint32_t unit_num)
+{
+    p_job->TypeErase = type;
+    FLASH_JOB_SET_BANK( *p_job, bank );
+
+    // Only if unit type erase
+    if ( FLASH_TYPEERASE_UNIT == type )
+    {
+        FLASH_JOB_UNIT( *p_job )    = unit;
+        FLASH_JOB_UNIT_NB( *p_job ) = unit_num;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Program single program unit
+*
+* @note     Family specific kernel: G0/G4/L4 program double word passed
+*           by value, H7 programs flash word passed by address.
+*
+* @param[in]    addr        - Flash address, program unit aligned
+* @param[in]    p_unit      - Program unit data
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+static inline flash_status_t flash_program_unit(const uint32_t addr, const uint8_t * const p_unit)
+{
+    flash_status_t status = eFLASH_OK;
+
+    #if ( 1 == FLASH_CFG_FAULT_INJECT_EN )
+
+        // Power cut instead of regular programming
+        if ( true == flash_fault_hit())
+        {
+            status = flash_fault_cut_program( addr, p_unit );
+        }
+        else
+
+    #endif
+    {
+        #if ( FLASH_CFG_FAMILY_H7 == FLASH_CFG_FAMILY )
+
+            uint32_t flash_word[FLASH_PROG_SIZE / sizeof( uint32_t )];
+
+            // HAL reads source word by word
+            memcpy( &flash_word, p_unit, FLASH_PROG_SIZE );
+
+            const HAL_StatusTypeDef hal_status = HAL_FLASH_Program( FLASH_TYPEPROGRAM_FLASHWORD, addr, (uint32_t) &flash_word );
+
+            if ( HAL_OK != hal_status )
+            {
+                status = flash_error( hal_status, HAL_FLASH_GetError(), addr, 0xFFFFFFFFU );
+            }
+
+        #else
+
+            uint64_t flash_data = 0U;
+
+            memcpy( &flash_data, p_unit, FLASH_PROG_SIZE );
+
+            const HAL_StatusTypeDef hal_status = HAL_FLASH_Program( FLASH_TYPEPROGRAM_DOUBLEWORD, addr, flash_data );
+
+            if ( HAL_OK != hal_status )
+            {
+                status = flash_error( hal_status, HAL_FLASH_GetError(), addr, 0xFFFFFFFFU );
+            }
+
+        #endif
+    }
+
+    return status;
+}
+
+#if ( 1 == FLASH_CFG_LL_PROGRAM_EN )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Program units via flash registers
+    *
+    * @note     PG is set once for the whole run, double words are streamed
+    *           with tight busy polling and errors are checked once at the
+    *           end. No HAL locking, timeouts or error bookkeeping.
+    *
+    * @param[in]    addr        - Flash address, program unit aligned
+    * @param[in]    unit_num    - Number of program units
+    * @param[in]    p_data      - Data to write
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static flash_status_t flash_ll_program(const uint32_t addr, const uint32_t unit_num, const uint8_t * const p_data)
+    {
+        flash_status_t  status  = eFLASH_OK;
+        uint32_t        word[FLASH_PROG_SIZE / sizeof( uint32_t )];
+
+        // Wait for previous operation and clear stale errors
+        while ( 0U != ( READ_REG( FLASH->SR ) & FLASH_LL_SR_BUSY ))
+        {
+            // Wait...
+        }
+
+        WRITE_REG( FLASH->SR, ( FLASH_LL_SR_ERRORS | FLASH_SR_EOP ));
+
+        SET_BIT( FLASH->CR, FLASH_CR_PG );
+
+        for ( uint32_t unit = 0U; unit < unit_num; unit++ )
+        {
+            volatile uint32_t * const p_flash = (volatile uint32_t*)( addr + ( unit * FLASH_PROG_SIZE ));
+
+            memcpy( &word, &p_data[ unit * FLASH_PROG_SIZE ], FLASH_PROG_SIZE );
+
+            // Double word is programmed after second word is written
+            p_flash[0] = word[0];
+            __ISB();
+            p_flash[1] = word[1];
+
+            while ( 0U != ( READ_REG( FLASH->SR ) & FLASH_LL_SR_BUSY ))
+            {
+                // Wait...
+            }
+        }
+
+        CLEAR_BIT( FLASH->CR, FLASH_CR_PG );
+
+        // Check errors once per run
+        const uint32_t sr_error = ( READ_REG( FLASH->SR ) & FLASH_LL_SR_ERRORS );
+
+        if ( 0U != sr_error )
+        {
+            WRITE_REG( FLASH->SR, FLASH_LL_SR_ERRORS );
+            status = flash_error( HAL_ERROR, sr_error, addr, 0xFFFFFFFFU );
+        }
+
+        WRITE_REG( FLASH->SR, FLASH_SR_EOP );
+
+        return status;
+    }
+
+#endif // ( 1 == FLASH_CFG_LL_PROGRAM_EN )
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Program run of complete program units
+*
+* @note     With register level programming enabled run is streamed via
+*           registers. On error units already programmed are skipped and
+*           the rest is programmed via HAL.
+*
+* @param[in]    addr        - Flash address, program unit aligned
+* @param[in]    unit_num    - Number of program units
+* @param[in]    p_data      - Data to write
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+static flash_status_t flash_program_units(const uint32_t addr, const uint32_t unit_num, const uint8_t * const p_data)
+{
+    flash_status_t  status  = eFLASH_OK;
+    uint32_t        unit    = 0U;
+
+    #if ( 1 == FLASH_CFG_LL_PROGRAM_EN )
+
+        if ( eFLASH_OK != flash_ll_program( addr, unit_num, p_data ))
+        {
+            // Find first unit not programmed before error
+            while   (   ( unit < unit_num )
+                    &&  ( 0 == memcmp((const void*)( addr + ( unit * FLASH_PROG_SIZE )), &p_data[ unit * FLASH_PROG_SIZE ], FLASH_PROG_SIZE )))
+            {
+                unit++;
+            }
+
+            g_flash_stats.program_fallback_num++;
+        }
+        else
+        {
+            unit = unit_num;
+        }
+
+        g_flash_stats.program_ll_num    += unit;
+        g_flash_stats.program_unit_num  += unit;
+
+    #endif
+
+    // Program (remaining) units via HAL
+    for ( ; ( unit < unit_num ) && ( eFLASH_OK == status ); unit++ )
+    {
+        status = flash_program_unit(( addr + ( unit * FLASH_PROG_SIZE )), &p_data[ unit * FLASH_PROG_SIZE ] );
+
+        if ( eFLASH_OK == status )
+        {
+            g_flash_stats.program_unit_num++;
+        }
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Suspend flash caches before program/erase
+*
+* @note     G0/G4/L4 ART: data cache is disabled for programming, also
+*           instruction cache for erase, so HAL skips its own per operation
+*           cache flush. Caches stay suspended until flash lock is released
+*           (flash_unlock), modified range is accumulated meanwhile. H7 has
+*           no ART, nothing to suspend.
+*
+* @param[in]    addr        - Start of modified range
+* @param[in]    size        - Size of modified range, 0 for erase
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void flash_cache_suspend(const uint32_t addr, const uint32_t size)
+{
+    FLASH_ASSERT( g_flash_cache.lock_num > 0U );
+
+    if ( false == g_flash_cache.is_suspended )
+    {
+        g_flash_cache.start         = UINT32_MAX;
+        g_flash_cache.end           = 0U;
+        g_flash_cache.is_erase      = false;
+        g_flash_cache.is_suspended  = true;
+
+        #if ( FLASH_CFG_FAMILY_H7 != FLASH_CFG_FAMILY )
+
+            g_flash_cache.acr = ( READ_REG( FLASH->ACR ) & ( FLASH_ACR_ICEN | FLASH_ACR_PRFTEN ));
+
+            #if defined( FLASH_ACR_DCEN )
+                g_flash_cache.acr |= ( READ_REG( FLASH->ACR ) & FLASH_ACR_DCEN );
+                __HAL_FLASH_DATA_CACHE_DISABLE();
+            #endif
+
+        #endif
+    }
+
+    if ( 0U == size )
+    {
+        #if ( FLASH_CFG_FAMILY_H7 != FLASH_CFG_FAMILY )
+            if ( false == g_flash_cache.is_erase )
+            {
+                __HAL_FLASH_INSTRUCTION_CACHE_DISABLE();
+            }
+        #endif
+
+        g_flash_cache.is_erase = true;
+    }
+    else
+    {
+        if ( addr < g_flash_cache.start )
+        {
+            g_flash_cache.start = addr;
+        }
+
+        if (( addr + size ) > g_flash_cache.end )
+        {
+            g_flash_cache.end = ( addr + size );
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Resume flash caches after program/erase
+*
+* @note     G0/G4/L4 ART has no line invalidation, suspended caches are
+*           reset once per flash lock and re-enabled. On H7 core data cache
+*           lines of modified range are invalidated, whole cache after erase.
+*
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void flash_cache_resume(void)
+{
+    #if ( FLASH_CFG_FAMILY_H7 != FLASH_CFG_FAMILY )
+
+        const uint32_t acr = g_flash_cache.acr;
+
+        // Instruction cache disabled for erase
+        if  (   ( 0U != ( acr & FLASH_ACR_ICEN ))
+            &&  ( 0U == READ_BIT( FLASH->ACR, FLASH_ACR_ICEN )))
+        {
+            __HAL_FLASH_INSTRUCTION_CACHE_RESET();
+            __HAL_FLASH_INSTRUCTION_CACHE_ENABLE();
+        }
+
+        #if defined( FLASH_ACR_DCEN )
+            if ( 0U != ( acr & FLASH_ACR_DCEN ))
+            {
+                __HAL_FLASH_DATA_CACHE_RESET();
+                __HAL_FLASH_DATA_CACHE_ENABLE();
+            }
+        #endif
+
+        // Restore prefetch
+        MODIFY_REG( FLASH->ACR, FLASH_ACR_PRFTEN, ( acr & FLASH_ACR_PRFTEN ));
+
+    #else
+
+        if ( true == g_flash_cache.is_erase )
+        {
+            flash_cache_invalidate( 0U, 0U );
+        }
+        else if ( g_flash_cache.end > g_flash_cache.start )
+        {
+            flash_cache_invalidate( g_flash_cache.start, ( g_flash_cache.end - g_flash_cache.start ));
+        }
+        else
+        {
+            // No actions...
+        }
+
+    #endif
+
+    g_flash_cache.is_suspended = false;
+}
+
+#if ( FLASH_CFG_FAMILY_H7 == FLASH_CFG_FAMILY )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Invalidate core data cache lines of modified flash
+    *
+    * @param[in]    addr        - Start of modified range
+    * @param[in]    size        - Size of modified range, 0 for whole cache
+    * @return       void
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static void flash_cache_invalidate(const uint32_t addr, const uint32_t size)
+    {
+        #if ( defined( __DCACHE_PRESENT ) && ( 1U == __DCACHE_PRESENT ))
+
+            if ( 0U != ( SCB->CCR & SCB_CCR_DC_Msk ))
+            {
+                if ( 0U == size )
+                {
+                    SCB_InvalidateDCache();
+                }
+                else
+                {
+                    // Cache line aligned range
+                    const uint32_t start = ( addr & ~( __SCB_DCACHE_LINE_SIZE - 1U ));
+
+                    SCB_InvalidateDCache_by_Addr((void*) start, (int32_t)(( addr + size ) - start ));
+                }
+            }
+
+        #else
+            (void) addr;
+            (void) size;
+        #endif
+    }
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Program flash at physical address
+*
+* @note     Complete rows are programmed with fast programming, unless
+*           disabled by caller, the rest in runs of program units. Last
+*           partial program unit is padded with erased value.
+*
+* @param[in]    addr        - Flash address, program unit aligned
+* @param[in]    size        - Size of data to write in bytes
+* @param[in]    p_data      - Data to write
+* @param[in]    is_fast     - Complete rows may be fast programmed (rows erased)
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+static flash_status_t flash_program_phys(const uint32_t addr, const uint32_t size, const uint8_t * const p_data, const bool is_fast)
+{
+    flash_status_t  status  = eFLASH_OK;
+    uint32_t        unit[FLASH_PROG_SIZE / sizeof( uint32_t )];
+    uint32_t        offset  = 0U;
+
+    #if ( 1 == FLASH_CFG_BENCHMARK_EN )
+        const uint32_t start_cycle = DWT->CYCCNT;
+    #endif
+
+    #if ( 0 == FLASH_CFG_FAST_PROGRAM_EN )
+        (void) is_fast;
+    #endif
+
+    flash_cache_suspend( addr, size );
+
+    while (( offset < size ) && ( eFLASH_OK == status ))
+    {
+        const uint32_t flash_addr   = ( addr + offset );
+        const uint32_t remaining    = ( size - offset );
+        uint32_t       unit_num     = ( remaining / FLASH_PROG_SIZE );
+
+        #if ( 1 == FLASH_CFG_FAST_PROGRAM_EN )
+
+            // Complete row from word aligned source
+            if  (   ( true == is_fast )
+                &&  ( 0U == ( flash_addr & ( FLASH_ROW_SIZE - 1U )))
+                &&  ( remaining >= FLASH_ROW_SIZE )
+                &&  ( 0U == ((uint32_t) &p_data[offset] & 0x3U )))
+            {
+                const HAL_StatusTypeDef hal_status = HAL_FLASH_Program( FLASH_TYPEPROGRAM_FAST, flash_addr, (uint64_t)(uint32_t) &p_data[offset] );
+
+                if ( HAL_OK != hal_status )
+                {
+                    status = flash_error( hal_status, HAL_FLASH_GetError(), flash_addr, 0xFFFFFFFFU );
+                }
+                else
+                {
+                    g_flash_stats.program_row_num++;
+                }
+
+                offset += FLASH_ROW_SIZE;
+                continue;
+            }
+
+            // Stop run at next row boundary
+            if ( unit_num > (( FLASH_ROW_SIZE - ( flash_addr & ( FLASH_ROW_SIZE - 1U ))) / FLASH_PROG_SIZE ))
+            {
+                unit_num = (( FLASH_ROW_SIZE - ( flash_addr & ( FLASH_ROW_SIZE - 1U ))) / FLASH_PROG_SIZE );
+            }
+
+        #endif
+
+        // Run of complete program units
+        if ( unit_num > 0U )
+        {
+            status = flash_program_units( flash_addr, unit_num, &p_data[offset] );
+
+            offset += ( unit_num * FLASH_PROG_SIZE );
+        }
+
+        // Last partial program unit
+        else
+        {
+            memset( &unit, 0xFF, sizeof( unit ));
+            memcpy( &unit, &p_data[offset], remaining );
+
+            status = flash_program_units( flash_addr, 1U, (const uint8_t*) &unit );
+
+            offset += FLASH_PROG_SIZE;
+        }
+    }
+
+    #if ( 1 == FLASH_CFG_BENCHMARK_EN )
+        g_flash_stats.program_cycle_num += ( DWT->CYCCNT - start_cycle );
+    #endif
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Program flash with selectable fast programming
+*
+* @note     With ECC remapping relocated pages are programmed at their
+*           spare page.
+*
+* @param[in]    addr        - Flash address, program unit aligned
+* @param[in]    size        - Size of data to write in bytes
+* @param[in]    p_data      - Data to write
+* @param[in]    is_fast     - Complete rows may be fast programmed (rows erased)
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+static flash_status_t flash_program_sel(const uint32_t addr, const uint32_t size, const uint8_t * const p_data, const bool is_fast)
+{
+    flash_status_t status = eFLASH_OK;
+
+    #if (( 1 == FLASH_CFG_ECC_EN ) && ( 1 == FLASH_CFG_ECC_REMAP_EN ))
+
+        if ( 0U != g_flash_ecc.map_num )
+        {
+            uint32_t offset = 0U;
+
+            // Page by page at relocated address
+            while (( offset < size ) && ( eFLASH_OK == status ))
+            {
+                const uint32_t page_left    = ( FLASH_CFG_PAGE_SIZE_BYTE - (( addr + offset ) & FLASH_PAGE_MASK ));
+                const uint32_t chunk        = ((( size - offset ) < page_left ) ? ( size - offset ) : page_left );
+
+                status = flash_program_phys( flash_ecc_translate( addr + offset ), chunk, &p_data[offset], is_fast );
+
+                offset += chunk;
+            }
+        }
+        else
+
+    #endif
+    {
+        status = flash_program_phys( addr, size, p_data, is_fast );
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Program flash
+*
+* @param[in]    addr        - Flash address, program unit aligned
+* @param[in]    size        - Size of data to write in bytes
+* @param[in]    p_data      - Data to write
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+static flash_status_t flash_program(const uint32_t addr, const uint32_t size, const uint8_t * const p_data)
+{
+    return flash_program_sel( addr, size, p_data, true );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Prepare erase of flash memory in single bank configuration
+*
+* @param[in]    addr        - Start address of memory
+* @param[in]    size        - Size of memory section in bytes
+* @param[out]   p_job       - Erase jobs
+* @return       job_num     - Number of prepared erase jobs
+*/
+////////////////////////////////////////////////////////////////////////////////
+static uint8_t flash_erase_single_bank(const uint32_t addr, const uint32_t size, FLASH_EraseInitTypeDef * const p_job)
+{
+    // Calculate start page
+    const uint32_t start_page = (uint32_t)(( addr - FLASH_BASE ) >> gu32_flash_page_shift );
+
+    // Calcualte number of pages
+    const uint32_t num_of_pages = flash_count_page( addr, size );
+
+    FLASH_ASSERT( num_of_pages <= g_flash_geo.page_num );
+
+    // Mass erase if whole flash needs to be erased
+    flash_job_set( &p_job[0],
+                   ((( 0U == start_page ) && ( num_of_pages == g_flash_geo.page_num )) ? FLASH_TYPEERASE_MASSERASE : FLASH_TYPEERASE_UNIT ),
+                   FLASH_BANK_1, start_page, num_of_pages );
+
+    return 1U;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Prepare erase of flash memory in dual bank configuration
+*
+* @note     When both banks needs to be erased completely, single mass
+*           erase of both banks is prepared. Hardware erase both banks
+*           in parallel, thus total erase time is halved.
+*
+* @param[in]    addr        - Start address of memory
+* @param[in]    size        - Size of memory section in bytes
+* @param[out]   p_job       - Erase jobs
+* @return       job_num     - Number of prepared erase jobs
+*/
+////////////////////////////////////////////////////////////////////////////////
+static uint8_t flash_erase_dual_bank(const uint32_t addr, const uint32_t size, FLASH_EraseInitTypeDef * const p_job)
+{
+    flash_bank_data_t   bank_data[eFLASH_BANK_NUM_OF]   = {0};
+    uint8_t             job_num                         = 0U;
+
+    // Address starts in bank 1
+    if ( addr < g_flash_geo.bank2_addr )
+    {
+        bank_data[eFLASH_BANK_1].addr = addr;
+
+        // Single bank operation
+        if (( addr + size ) <= g_flash_geo.bank2_addr )
+        {
+            bank_data[eFLASH_BANK_1].size = size;
+        }
+
+        // Dual-bank operation, skip gap between banks
+        else
+        {
+            bank_data[eFLASH_BANK_1].size = (( FLASH_BASE + g_flash_geo.bank_size ) - addr );
+
+            bank_data[eFLASH_BANK_2].addr = g_flash_geo.bank2_addr;
+            bank_data[eFLASH_BANK_2].size = (( addr + size ) - g_flash_geo.bank2_addr );
+        }
+    }
+
+    // Address start in bank 2 -> single bank operation
+    else
+    {
+        bank_data[eFLASH_BANK_2].addr = addr;
+        bank_data[eFLASH_BANK_2].size = size;
+    }
+
+    // Prepare erase opration by bank
+    for ( uint8_t bank = 0; bank < eFLASH_BANK_NUM_OF; bank++ )
+    {
+        // Anything to do?
+        if ( bank_data[bank].size > 0 )
+        {
+            // Calculate start page
+            const uint32_t start_page = (uint32_t)(( bank_data[bank].addr - (( eFLASH_BANK_1 == bank ) ? FLASH_BASE : g_flash_geo.bank2_addr )) >> gu32_flash_page_shift );
+
+            // Calcualte number of pages
+            const uint32_t num_of_pages = flash_count_page( bank_data[bank].addr, bank_data[bank].size );
+
+            FLASH_ASSERT( num_of_pages <= g_flash_geo.page_num );
+
+            // Mass erase if all pages in bank needs to be erased
+            flash_job_set( &p_job[job_num],
+                           (( num_of_pages == g_flash_geo.page_num ) ? FLASH_TYPEERASE_MASSERASE : FLASH_TYPEERASE_UNIT ),
+                           (( bank == eFLASH_BANK_1 ) ? FLASH_BANK_1 : FLASH_BANK_2 ),
+                           start_page, num_of_pages );
+
+            job_num++;
+        }
+    }
+
+    // Both banks are erased completely -> erase them in parallel
+    if  (   ( eFLASH_BANK_NUM_OF == job_num )
+        &&  ( FLASH_TYPEERASE_MASSERASE == p_job[0].TypeErase )
+        &&  ( FLASH_TYPEERASE_MASSERASE == p_job[1].TypeErase ))
+    {
+        FLASH_JOB_SET_BANK( p_job[0], FLASH_BANK_BOTH );
+        job_num = 1U;
+    }
+
+    return job_num;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Prepare erase of flash memory
+*
+* @param[in]    addr        - Start address of memory
+* @param[in]    size        - Size of memory section in bytes
+* @param[out]   p_job       - Erase jobs
+* @return       job_num     - Number of prepared erase jobs
+*/
+////////////////////////////////////////////////////////////////////////////////
+static uint8_t flash_erase_plan(const uint32_t addr, const uint32_t size, FLASH_EraseInitTypeDef * const p_job)
+{
+    uint8_t job_num = 0U;
+
+    // Dual-bank operation
+    if ( true == g_flash_geo.is_dual_bank )
+    {
+        job_num = flash_erase_dual_bank( addr, size, p_job );
+    }
+
+    // Single bank operation
+    else
+    {
+        job_num = flash_erase_single_bank( addr, size, p_job );
+    }
+
+    return job_num;
+}
+
+#if ( 1 == FLASH_BANK_MODE_SUPPORTED )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Check if firmware runs from bank 2
+    *
+    * @note     Bank 2 disappears in single bank mode, device would not boot
+    *           after bank mode change. Covers bank swap, boot from bank 2
+    *           and code linked into bank 2.
+    *
+    * @return       is_bank2    - Firmware runs from bank 2
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static bool flash_bank_is_running_bank2(void)
+    {
+        const uint32_t  code_addr   = (uint32_t)(uintptr_t) &flash_bank_is_running_bank2;
+        bool            is_bank2    = false;
+
+        if ( true == g_flash_geo.is_dual_bank )
+        {
+            is_bank2 =  (( code_addr >= g_flash_geo.bank2_addr ) && (( code_addr - g_flash_geo.bank2_addr ) < g_flash_geo.bank_size ));
+
+            #if defined( FLASH_OPTR_BFB2 )
+                is_bank2 |= ( 0U != READ_BIT( FLASH->OPTR, FLASH_OPTR_BFB2 ));
+            #endif
+
+            #if defined( SYSCFG_MEMRMP_FB_MODE )
+                is_bank2 |= ( 0U != READ_BIT( SYSCFG->MEMRMP, SYSCFG_MEMRMP_FB_MODE ));
+            #endif
+        }
+
+        return is_bank2;
+    }
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Classify and record flash error
+*
+* @param[in]    hal_status      - HAL status of failed operation
+* @param[in]    hal_error       - HAL error flags
+* @param[in]    addr            - Failing address
+* @param[in]    sector_error    - Failing page/sector of erase, 0xFFFFFFFF otherwise
+* @return       status          - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+static flash_status_t flash_error(const HAL_StatusTypeDef hal_status, const uint32_t hal_error, const uint32_t addr, const uint32_t sector_error)
+{
+    flash_status_t status = eFLASH_ERROR;
+
+    if ( HAL_TIMEOUT == hal_status )
+    {
+        status = eFLASH_ERROR_TIMEOUT;
+    }
+    else if ( 0U != ( hal_error & FLASH_HAL_ERROR_WRP ))
+    {
+        status = eFLASH_ERROR_WRP;
+    }
+    else if ( 0U != ( hal_error & FLASH_HAL_ERROR_NOT_ERASED ))
+    {
+        status = eFLASH_ERROR_NOT_ERASED;
+    }
+    else if ( 0U != ( hal_error & FLASH_HAL_ERROR_ALIGN ))
+    {
+        status = eFLASH_ERROR_ALIGN;
+    }
+    else if ( 0U != ( hal_error & FLASH_HAL_ERROR_SEQ ))
+    {
+        status = eFLASH_ERROR_SEQ;
+    }
+    else if ( 0U != ( hal_error & FLASH_HAL_ERROR_ECC ))
+    {
+        status = eFLASH_ERROR_ECC;
+    }
+    else
+    {
+        // General error
+    }
+
+    g_flash_error.status        = status;
+    g_flash_error.addr          = addr;
+    g_flash_error.sector_error  = sector_error;
+    g_flash_error.hal_error     = hal_error;
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Get address of failed erase
+*
+* @param[in]    p_job           - Failed erase job
+* @param[in]    sector_error    - Failing page/sector, 0xFFFFFFFF for mass erase
+* @return       addr            - Start of failing page/sector or bank
+*/
+////////////////////////////////////////////////////////////////////////////////
+static uint32_t flash_erase_error_addr(const FLASH_EraseInitTypeDef * const p_job, const uint32_t sector_error)
+{
+    uint32_t addr = FLASH_BASE;
+
+    if  (   ( true == g_flash_geo.is_dual_bank )
+        &&  ( FLASH_BANK_2 == p_job->Banks ))
+    {
+        addr = g_flash_geo.bank2_addr;
+    }
+
+    if ( 0xFFFFFFFFU != sector_error )
+    {
+        addr += ( sector_error << gu32_flash_page_shift );
+    }
+
+    return addr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Account erase job into statistics
+*
+* @param[in]    p_job       - Erase job
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void flash_erase_stats(const FLASH_EraseInitTypeDef * const p_job)
+{
+    if ( FLASH_TYPEERASE_MASSERASE == p_job->TypeErase )
+    {
+        g_flash_stats.erase_mass_num++;
+
+        if  (   ( true == g_flash_geo.is_dual_bank )
+            &&  ( FLASH_BANK_BOTH == p_job->Banks ))
+        {
+            g_flash_stats.erase_parallel_num++;
+        }
+    }
+    else
+    {
+        g_flash_stats.erase_page_num += FLASH_JOB_UNIT_NB( *p_job );
+    }
+}
+
+#if (( FLASH_CFG_FAMILY_H7 != FLASH_CFG_FAMILY ) && ( 1 == FLASH_ERASE_PER_UNIT ))
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Start single page erase via registers
+    *
+    * @note     Returns while page is being erased. Caller waits for busy
+    *           flag to clear and completes erase with flash_erase_unit_end().
+    *
+    * @param[in]    p_job       - Erase job, first page is erased
+    * @return       void
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static void flash_erase_unit_start(const FLASH_EraseInitTypeDef * const p_job)
+    {
+        // Wait for previous operation and clear stale errors
+        while ( 0U != ( READ_REG( FLASH->SR ) & FLASH_LL_SR_BUSY ))
+        {
+            // Wait...
+        }
+
+        WRITE_REG( FLASH->SR, ( FLASH_LL_SR_ERRORS | FLASH_SR_EOP ));
+
+        #if defined( FLASH_CR_BKER )
+            MODIFY_REG( FLASH->CR, FLASH_CR_BKER, (( FLASH_BANK_2 == p_job->Banks ) ? FLASH_CR_BKER : 0U ));
+        #endif
+
+        MODIFY_REG( FLASH->CR, FLASH_CR_PNB, ( FLASH_JOB_UNIT( *p_job ) << FLASH_CR_PNB_Pos ));
+        SET_BIT( FLASH->CR, FLASH_CR_PER );
+        SET_BIT( FLASH->CR, FLASH_CR_STRT );
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Complete single page erase started via registers
+    *
+    * @note     Flash must not be busy anymore.
+    *
+    * @param[in]    p_job       - Erase job, first page is erased
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static flash_status_t flash_erase_unit_end(const FLASH_EraseInitTypeDef * const p_job)
+    {
+        flash_status_t status = eFLASH_OK;
+
+        CLEAR_BIT( FLASH->CR, ( FLASH_CR_PER | FLASH_CR_PNB ));
+
+        const uint32_t sr_error = ( READ_REG( FLASH->SR ) & FLASH_LL_SR_ERRORS );
+
+        if ( 0U != sr_error )
+        {
+            WRITE_REG( FLASH->SR, FLASH_LL_SR_ERRORS );
+            status = flash_error( HAL_ERROR, sr_error, flash_erase_error_addr( p_job, FLASH_JOB_UNIT( *p_job )), FLASH_JOB_UNIT( *p_job ));
+        }
+
+        WRITE_REG( FLASH->SR, FLASH_SR_EOP );
+
+        return status;
+    }
+
+#endif // (( FLASH_CFG_FAMILY_H7 != FLASH_CFG_FAMILY ) && ( 1 == FLASH_ERASE_PER_UNIT ))
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Execute erase jobs in blocking mode
+*
+* @param[in]    p_job       - Erase jobs
+* @param[in]    job_num     - Number of erase jobs
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+static flash_status_t flash_erase_execute(FLASH_EraseInitTypeDef * const p_job, const uint8_t job_num)
+{
+    flash_status_t  status          = eFLASH_OK;
+
+    #if (( FLASH_CFG_OS_BARE_METAL != FLASH_CFG_OS ) && ( 1 == FLASH_CFG_ASYNC_ERASE_EN ) && ( 0 == FLASH_CFG_FAULT_INJECT_EN ))
+
+        // Run erase from interrupt and sleep meanwhile
+        status = flash_async_start( p_job, job_num, NULL );
+
+        if ( eFLASH_OK == status )
+        {
+            while ( true == flash_is_busy_internal())
+            {
+                flash_os_yield();
+            }
+
+            status = g_flash_async.result;
+        }
+
+    #else
+
+        uint32_t        sector_error    = 0U;
+
+        flash_cache_suspend( 0U, 0U );
+
+        for ( uint8_t job = 0; job < job_num; job++ )
+        {
+            #if ( 1 == FLASH_ERASE_PER_UNIT )
+
+                // Erase page by page, other tasks run while page is erased,
+                // with fault injection every page is a cut point
+                if ( FLASH_TYPEERASE_UNIT == p_job[job].TypeErase )
+                {
+                    FLASH_EraseInitTypeDef page_job = p_job[job];
+
+                    FLASH_JOB_UNIT_NB( page_job ) = 1U;
+
+                    for ( uint32_t page = 0U; ( page < FLASH_JOB_UNIT_NB( p_job[job] )) && ( eFLASH_OK == status ); page++ )
+                    {
+                        FLASH_JOB_UNIT( page_job ) = ( FLASH_JOB_UNIT( p_job[job] ) + page );
+
+                        #if ( 1 == FLASH_CFG_FAULT_INJECT_EN )
+
+                            // Power cut during page erase
+                            if ( true == flash_fault_hit())
+                            {
+                                status = flash_fault_cut_erase( &page_job );
+                                break;
+                            }
+
+                        #endif
+
+                        #if ( FLASH_CFG_FAMILY_H7 != FLASH_CFG_FAMILY )
+
+                            flash_erase_unit_start( &page_job );
+
+                            while ( 0U != ( READ_REG( FLASH->SR ) & FLASH_LL_SR_BUSY ))
+                            {
+                                flash_os_yield();
+                            }
+
+                            status = flash_erase_unit_end( &page_job );
+
+                        #else
+
+                            // Sector erase blocks in HAL, CPU is given to other tasks in between
+                            const HAL_StatusTypeDef hal_status = HAL_FLASHEx_Erase( &page_job, &sector_error );
+
+                            if ( HAL_OK != hal_status )
+                            {
+                                status = flash_error( hal_status, HAL_FLASH_GetError(), flash_erase_error_addr( &page_job, sector_error ), sector_error );
+                            }
+                            else
+                            {
+                                flash_os_yield();
+                            }
+
+                        #endif
+                    }
+                }
+                else
+
+            #endif
+
+            #if ( 1 == FLASH_CFG_FAULT_INJECT_EN )
+
+                // Power cut during mass erase
+                if ( true == flash_fault_hit())
+                {
+                    status = flash_fault_cut_erase( &p_job[job] );
+                }
+                else
+
+            #endif
+            {
+                // Erase flash
+                const HAL_StatusTypeDef hal_status = HAL_FLASHEx_Erase( &p_job[job], &sector_error );
+
+                if ( HAL_OK != hal_status )
+                {
+                    status = flash_error( hal_status, HAL_FLASH_GetError(), flash_erase_error_addr( &p_job[job], sector_error ), sector_error );
+                }
+            }
+
+            flash_erase_stats( &p_job[job] );
+        }
+
+    #endif
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Read from memory mapped flash
+*
+* @note     Bulk copy, word wide when source and destination alignment
+*           permits it.
+*
+* @param[in]    addr        - Flash address
+* @param[in]    size        - Size of data to read in bytes
+* @param[out]   p_data      - Read data
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void flash_read_internal(const uint32_t addr, const uint32_t size, uint8_t * const p_data)
+{
+    #if (( 1 == FLASH_CFG_ECC_EN ) && ( 1 == FLASH_CFG_ECC_REMAP_EN ))
+
+        uint32_t offset = 0U;
+
+        // Page by page from relocated address
+        while ( offset < size )
+        {
+            const uint32_t page_left    = ( FLASH_CFG_PAGE_SIZE_BYTE - (( addr + offset ) & FLASH_PAGE_MASK ));
+            const uint32_t chunk        = ((( size - offset ) < page_left ) ? ( size - offset ) : page_left );
+
+            memcpy( &p_data[offset], (const void*) flash_ecc_translate( addr + offset ), chunk );
+
+            offset += chunk;
+        }
+
+    #else
+
+        memcpy( p_data, (const void*) addr, size );
+
+    #endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Sort read descriptors by flash address
+*
+* @note     Insertion sort, descriptor lists are short.
+*
+* @param[in,out]p_desc      - Read descriptors
+* @param[in]    count       - Number of descriptors
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void flash_read_desc_sort(flash_read_desc_t * const p_desc, const uint32_t count)
+{
+    for ( uint32_t i = 1U; i < count; i++ )
+    {
+        const flash_read_desc_t desc    = p_desc[i];
+        uint32_t                j       = i;
+
+        while (( j > 0U ) && ( p_desc[j-1U].addr > desc.addr ))
+        {
+            p_desc[j] = p_desc[j-1U];
+            j--;
+        }
+
+        p_desc[j] = desc;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Validate search request and make batched writes visible
+*
+* @param[in]    addr        - Start address of searched range
+* @param[in]    size        - Size of searched range in bytes
+* @param[in]    align       - Required alignment of range and size
+* @param[in]    p_addr      - Result pointer
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+static flash_status_t flash_find_prepare(const uint32_t addr, const uint32_t size, const uint32_t align, const uint32_t * const p_addr)
+{
+    flash_status_t status = eFLASH_OK;
+
+    FLASH_ASSERT( true == gb_is_init );
+    FLASH_ASSERT( true == flash_is_in_region( addr, size ));
+    FLASH_ASSERT( 0U == (( addr | size ) & ( align - 1U )));
+    FLASH_ASSERT( NULL != p_addr );
+
+    if (( false == gb_is_init ) || ( NULL == p_addr ))
+    {
+        status = eFLASH_ERROR;
+    }
+    else if ( false == flash_is_in_region( addr, size ))
+    {
+        status = eFLASH_ERROR_RANGE;
+    }
+    else if ( 0U != (( addr | size ) & ( align - 1U )))
+    {
+        status = eFLASH_ERROR_ALIGN;
+    }
+    else
+    {
+        #if ( 1 == FLASH_CFG_BATCH_EN )
+
+            // Make batched writes visible
+            if ( true == g_flash_batch.is_used )
+            {
+                status = flash_lock();
+
+                if ( eFLASH_OK == status )
+                {
+                    status = flash_batch_sync( addr, size );
+
+                    flash_unlock();
+                }
+            }
+
+        #endif
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Check if program unit is erased
+*
+* @note     Words are AND-ed together, single compare per program unit.
+*
+* @param[in]    addr        - Program unit aligned flash address
+* @return       is_blank    - Program unit is erased
+*/
+////////////////////////////////////////////////////////////////////////////////
+static inline bool flash_unit_is_blank(const uint32_t addr)
+{
+    const volatile uint32_t * const p_word  = (const volatile uint32_t *) flash_mem_addr( addr );
+    uint32_t                        acc     = 0xFFFFFFFFU;
+
+    for ( uint32_t word = 0U; word < ( FLASH_PROG_SIZE / sizeof( uint32_t )); word++ )
+    {
+        acc &= p_word[word];
+    }
+
+    return ( 0xFFFFFFFFU == acc );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Find first erased program unit
+*
+* @note     Binary search for append-only ranges, where all written units
+*           precede all erased units. Linear scan otherwise.
+*
+* @param[in]    addr            - Program unit aligned start address
+* @param[in]    unit_num        - Number of program units
+* @param[in]    is_monotonic    - Range is append-only
+* @return       unit            - Index of first erased unit, unit_num if none
+*/
+////////////////////////////////////////////////////////////////////////////////
+static uint32_t flash_find_blank(const uint32_t addr, const uint32_t unit_num, const bool is_monotonic)
+{
+    uint32_t lo = 0U;
+    uint32_t hi = unit_num;
+
+    if ( true == is_monotonic )
+    {
+        while ( lo < hi )
+        {
+            const uint32_t mid = ( lo + (( hi - lo ) >> 1U ));
+
+            if ( true == flash_unit_is_blank( addr + ( mid * FLASH_PROG_SIZE )))
+            {
+                hi = mid;
+            }
+            else
+            {
+                lo = ( mid + 1U );
+            }
+        }
+    }
+    else
+    {
+        while (( lo < hi ) && ( false == flash_unit_is_blank( addr + ( lo * FLASH_PROG_SIZE ))))
+        {
+            lo++;
+        }
+    }
+
+    return lo;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Compare memory mapped flash against RAM
+*
+* @note     Flash is read with aligned word loads, two words per step,
+*           RAM side may be unaligned. Stops at first difference.
+*
+* @param[in]    mem_addr    - Memory mapped flash address
+* @param[in]    size        - Size to compare in bytes
+* @param[in]    p_data      - RAM data
+* @return       offset      - Offset of first mismatching byte, size if equal
+*/
+////////////////////////////////////////////////////////////////////////////////
+static uint32_t flash_compare_mem(const uint32_t mem_addr, const uint32_t size, const uint8_t * const p_data)
+{
+    const volatile uint8_t * const  p_flash = (const volatile uint8_t *) mem_addr;
+    uint32_t                        offset  = 0U;
+    uint32_t                        ram[2];
+
+    // Head bytes up to word boundary
+    while (( offset < size ) && ( 0U != (( mem_addr + offset ) & 0x3U )) && ( p_flash[offset] == p_data[offset] ))
+    {
+        offset++;
+    }
+
+    // Double words
+    if ( 0U == (( mem_addr + offset ) & 0x3U ))
+    {
+        while (( size - offset ) >= sizeof( ram ))
+        {
+            const volatile uint32_t * const p_word = (const volatile uint32_t *) &p_flash[offset];
+
+            memcpy( ram, &p_data[offset], sizeof( ram ));
+
+            if ( 0U != (( p_word[0] ^ ram[0] ) | ( p_word[1] ^ ram[1] )))
+            {
+                break;
+            }
+
+            offset += sizeof( ram );
+        }
+    }
+
+    // Tail bytes or locate mismatching byte
+    while (( offset < size ) && ( p_flash[offset] == p_data[offset] ))
+    {
+        offset++;
+    }
+
+    return offset;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Gather data from I/O vector fragments
+*
+* @param[in]    p_iov       - I/O vector fragments
+* @param[in]    count       - Number of fragments
+* @param[in,out]p_idx       - Current fragment
+* @param[in,out]p_offset    - Offset within current fragment
+* @param[out]   p_dst       - Gathered data
+* @param[in]    size        - Number of bytes to gather
+* @return       gathered    - Number of gathered bytes
+*/
+////////////////////////////////////////////////////////////////////////////////
+static uint32_t flash_iov_gather(const flash_iovec_t * const p_iov, const uint32_t count, uint32_t * const p_idx, uint32_t * const p_offset, uint8_t * const p_dst, const uint32_t size)
+{
+    uint32_t gathered = 0U;
+
+    while (( gathered < size ) && ( *p_idx < count ))
+    {
+        const uint32_t left     = ( p_iov[*p_idx].size - *p_offset );
+        const uint32_t chunk    = ((( size - gathered ) < left ) ? ( size - gathered ) : left );
+
+        memcpy( &p_dst[gathered], &p_iov[*p_idx].p_data[*p_offset], chunk );
+
+        gathered    += chunk;
+        *p_offset   += chunk;
+
+        // Next fragment
+        if ( *p_offset >= p_iov[*p_idx].size )
+        {
+            *p_idx      += 1U;
+            *p_offset   = 0U;
+        }
+    }
+
+    return gathered;
+}
+
+#if ( 1 == FLASH_CFG_ASYNC_ERASE_EN )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Start interrupt driven erase
+    *
+    * @param[in]    p_job       - Erase jobs
+    * @param[in]    job_num     - Number of erase jobs
+    * @param[in]    pf_done     - Completion callback, can be NULL
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static flash_status_t flash_async_start(FLASH_EraseInitTypeDef * const p_job, const uint8_t job_num, pf_flash_erase_cb_t pf_done)
+    {
+        flash_status_t status = eFLASH_OK;
+
+        FLASH_ASSERT( job_num <= eFLASH_BANK_NUM_OF );
+
+        memcpy( &g_flash_async.job, p_job, ( job_num * sizeof( FLASH_EraseInitTypeDef )));
+
+        g_flash_async.job_num       = job_num;
+        g_flash_async.job_idx       = 0U;
+        g_flash_async.job_err       = eFLASH_OK;
+        g_flash_async.pf_done       = pf_done;
+        g_flash_async.start_tick    = HAL_GetTick();
+        g_flash_async.busy          = true;
+
+        g_flash_stats.erase_async_num++;
+
+        // Kick-off first job
+        status = flash_async_start_job();
+
+        if ( eFLASH_OK != status )
+        {
+            g_flash_async.busy = false;
+        }
+
+        return status;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Start current interrupt driven erase job
+    *
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static flash_status_t flash_async_start_job(void)
+    {
+        flash_status_t status = eFLASH_OK;
+
+        g_flash_async.job_done = false;
+
+        const HAL_StatusTypeDef hal_status = HAL_FLASHEx_Erase_IT( &g_flash_async.job[ g_flash_async.job_idx ] );
+
+        if ( HAL_OK != hal_status )
+        {
+            status = flash_error( hal_status, HAL_FLASH_GetError(), flash_erase_error_addr( &g_flash_async.job[ g_flash_async.job_idx ], 0xFFFFFFFFU ), 0xFFFFFFFFU );
+        }
+        else
+        {
+            flash_erase_stats( &g_flash_async.job[ g_flash_async.job_idx ] );
+        }
+
+        return status;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Finish interrupt driven erase
+    *
+    * @param[in]    status      - Status of erase
+    * @return       void
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static void flash_async_finish(const flash_status_t status)
+    {
+        g_flash_stats.erase_async_time_ms += ( HAL_GetTick() - g_flash_async.start_tick );
+
+        #if ( FLASH_CFG_FAMILY_H7 == FLASH_CFG_FAMILY )
+
+            // ART caches are flushed by HAL interrupt handler, core cache is not
+            flash_cache_invalidate( 0U, 0U );
+
+        #endif
+
+        g_flash_async.result    = status;
+        g_flash_async.busy      = false;
+
+        // Report completion
+        if ( NULL != g_flash_async.pf_done )
+        {
+            g_flash_async.pf_done( status );
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Flash end of operation callback
+    *
+    * @note     Overrides weak HAL implementation!
+    *
+    * @param[in]    ReturnValue - Erased page, 0xFFFFFFFF at the end of page
+    *                             erase or bank at the end of mass erase
+    * @return       void
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    void HAL_FLASH_EndOfOperationCallback(uint32_t ReturnValue)
+    {
+        if ( true == g_flash_async.busy )
+        {
+            // Page erase completes with 0xFFFFFFFF, mass erase with bank
+            if  (   ( FLASH_TYPEERASE_MASSERASE == g_flash_async.job[ g_flash_async.job_idx ].TypeErase )
+                ||  ( 0xFFFFFFFFU == ReturnValue ))
+            {
+                g_flash_async.job_done = true;
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Flash operation error callback
+    *
+    * @note     Overrides weak HAL implementation!
+    *
+    * @param[in]    ReturnValue - Failed page or bank
+    * @return       void
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    void HAL_FLASH_OperationErrorCallback(uint32_t ReturnValue)
+    {
+        if ( true == g_flash_async.busy )
+        {
+            const FLASH_EraseInitTypeDef * const p_job          = &g_flash_async.job[ g_flash_async.job_idx ];
+            const uint32_t                       sector_error   = (( FLASH_TYPEERASE_MASSERASE == p_job->TypeErase ) ? 0xFFFFFFFFU : ReturnValue );
+
+            // Abort remaining jobs
+            g_flash_async.job_done  = true;
+            g_flash_async.job_err   = flash_error( HAL_ERROR, HAL_FLASH_GetError(), flash_erase_error_addr( p_job, sector_error ), sector_error );
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Flash interrupt handler
+    *
+    * @note     Next job can only be started after HAL IRQ handler returns,
+    *           as HAL keeps flash procedure locked during callbacks.
+    *
+    * @return       void
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    void FLASH_IRQHandler(void)
+    {
+        #if ( 1 == FLASH_CFG_ECC_EN )
+
+            // ECC correction shares flash interrupt
+            flash_ecc_isr();
+
+        #endif
+
+        HAL_FLASH_IRQHandler();
+
+        if  (   ( true == g_flash_async.busy )
+            &&  ( true == g_flash_async.job_done ))
+        {
+            g_flash_async.job_idx++;
+
+            // Erase failed
+            if ( eFLASH_OK != g_flash_async.job_err )
+            {
+                flash_async_finish( g_flash_async.job_err );
+            }
+
+            // Start next bank job right away
+            else if ( g_flash_async.job_idx < g_flash_async.job_num )
+            {
+                const flash_status_t status = flash_async_start_job();
+
+                if ( eFLASH_OK != status )
+                {
+                    flash_async_finish( status );
+                }
+            }
+
+            // All jobs done
+            else
+            {
+                flash_async_finish( eFLASH_OK );
+            }
+        }
+    }
+
+#endif // ( 1 == FLASH_CFG_ASYNC_ERASE_EN )
+
+#if ( 1 == FLASH_CFG_ECC_EN )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Get flash address of ECC failure
+    *
+    * @param[in]    eccr        - Value of ECC register
+    * @return       addr        - Flash address of failing double word
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static uint32_t flash_ecc_addr(const uint32_t eccr)
+    {
+        uint32_t addr = ( FLASH_BASE + ( eccr & FLASH_ECCR_ADDR_ECC ));
+
+        #if defined( FLASH_ECCR_BK_ECC )
+
+            // Offset is relative to bank
+            if  (   ( true == g_flash_geo.is_dual_bank )
+                &&  ( 0U != ( eccr & FLASH_ECCR_BK_ECC )))
+            {
+                addr = ( g_flash_geo.bank2_addr + ( eccr & FLASH_ECCR_ADDR_ECC ));
+            }
+
+        #endif
+
+        return addr;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Handle ECC events
+    *
+    * @note     Called from flash interrupt for corrected errors and from
+    *           NMI for uncorrectable errors. Relocation is only marked here
+    *           and done later in flash_ecc_hndl().
+    *
+    * @return       void
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static void flash_ecc_isr(void)
+    {
+        const uint32_t eccr = READ_REG( FLASH->ECCR );
+        const uint32_t addr = flash_ecc_addr( eccr );
+
+        // Single bit error corrected
+        if ( 0U != ( eccr & FLASH_ECCR_ECCC ))
+        {
+            g_flash_stats.ecc_corr_num++;
+            g_flash_ecc.corr_addr = addr;
+
+            #if ( 1 == FLASH_CFG_ECC_REMAP_EN )
+
+                // User pages only, system flash is out of reach
+                if  (   ( false == g_flash_ecc.is_pending )
+                    &&  ( 0U == ( eccr & FLASH_ECCR_SYSF_ECC ))
+                    &&  ( true == flash_is_in_region( addr, 1U )))
+                {
+                    g_flash_ecc.pending_addr    = addr;
+                    g_flash_ecc.is_pending      = true;
+                }
+
+            #endif
+        }
+
+        // Double bit error of torn data, expected while probing
+        if  (   ( 0U != ( eccr & FLASH_ECCR_ECCD ))
+            &&  ( true == g_flash_ecc.is_probe ))
+        {
+            g_flash_ecc.is_probe_err = true;
+        }
+
+        // Double bit error detected
+        else if ( 0U != ( eccr & FLASH_ECCR_ECCD ))
+        {
+            g_flash_stats.ecc_uncorr_num++;
+            g_flash_ecc.uncorr_addr = addr;
+
+            (void) flash_error( HAL_ERROR, FLASH_HAL_ERROR_ECC, addr, 0xFFFFFFFFU );
+        }
+
+        // Clear flags, write 1 to clear
+        WRITE_REG( FLASH->ECCR, eccr );
+    }
+
+    #if ( 1 == FLASH_CFG_ATOMIC_EN )
+
+        ////////////////////////////////////////////////////////////////////////////////
+        /**
+        *       Read flash that may hold torn data
+        *
+        * @note     Double word left torn by power loss fails ECC check and its
+        *           read raises NMI. While probing flash_ecc_nmi_hndl() clears
+        *           error without reporting it, read data is then discarded.
+        *
+        * @param[in]    addr        - Flash address
+        * @param[in]    size        - Size to read in bytes
+        * @param[out]   p_data      - Read data
+        * @return       is_intact   - Read without uncorrectable error
+        */
+        ////////////////////////////////////////////////////////////////////////////////
+        static bool flash_ecc_probe(const uint32_t addr, const uint32_t size, uint8_t * const p_data)
+        {
+            g_flash_ecc.is_probe_err    = false;
+            g_flash_ecc.is_probe        = true;
+            __DSB();
+
+            flash_read_internal( addr, size, p_data );
+
+            __DSB();
+            g_flash_ecc.is_probe        = false;
+
+            return ( false == g_flash_ecc.is_probe_err );
+        }
+
+    #endif
+
+    #if ( 0 == FLASH_CFG_ASYNC_ERASE_EN )
+
+        ////////////////////////////////////////////////////////////////////////////////
+        /**
+        *       Flash interrupt handler
+        *
+        * @return       void
+        */
+        ////////////////////////////////////////////////////////////////////////////////
+        void FLASH_IRQHandler(void)
+        {
+            flash_ecc_isr();
+        }
+
+    #endif
+
+    #if ( 1 == FLASH_CFG_ECC_REMAP_EN )
+
+        ////////////////////////////////////////////////////////////////////////////////
+        /**
+        *       Translate address to relocated page
+        *
+        * @param[in]    addr        - Flash address
+        * @return       addr        - Physical flash address
+        */
+        ////////////////////////////////////////////////////////////////////////////////
+        static uint32_t flash_ecc_translate(const uint32_t addr)
+        {
+            const uint32_t  page    = ( addr & ~FLASH_PAGE_MASK );
+            uint32_t        phys    = addr;
+
+            for ( uint32_t n = 0U; n < g_flash_ecc.map_num; n++ )
+            {
+                if ( page == g_flash_ecc.page[n] )
+                {
+                    phys = ( g_flash_ecc.spare[n] | ( addr & FLASH_PAGE_MASK ));
+                    break;
+                }
+            }
+
+            return phys;
+        }
+
+        ////////////////////////////////////////////////////////////////////////////////
+        /**
+        *       Check remap table entry
+        *
+        * @note     Entry from torn or corrupted programming is rejected, as
+        *           well as entry that would redirect accesses outside user
+        *           region or into remap area.
+        *
+        * @param[in]    p_entry     - Table entry
+        * @param[in]    slot        - Table slot of entry
+        * @return       true if entry is valid
+        */
+        ////////////////////////////////////////////////////////////////////////////////
+        static bool flash_ecc_entry_is_valid(const flash_ecc_entry_t * const p_entry, const uint32_t slot)
+        {
+            return  (   ( slot == p_entry->seq )
+                    &&  ( FLASH_ECC_ENTRY_CHECK( p_entry ) == p_entry->check )
+                    &&  ( FLASH_ECC_SPARE_ADDR( slot ) == p_entry->spare )
+                    &&  ( 0U == ( p_entry->page & FLASH_PAGE_MASK ))
+                    &&  ( true == flash_is_in_region( p_entry->page, FLASH_CFG_PAGE_SIZE_BYTE ))
+                    &&  (   ( p_entry->page >= ( FLASH_CFG_ECC_REMAP_START_ADDR + FLASH_ECC_AREA_SIZE ))
+                        ||  (( p_entry->page + FLASH_CFG_PAGE_SIZE_BYTE ) <= FLASH_CFG_ECC_REMAP_START_ADDR )));
+        }
+
+        ////////////////////////////////////////////////////////////////////////////////
+        /**
+        *       Load remap table from flash
+        *
+        * @note     Table is append only log of {page, spare, seq, check}
+        *           entries. Later entry for same page overrides earlier one.
+        *           Invalid entry (e.g. interrupted relocation) is skipped,
+        *           but its slot and spare page stay used.
+        *
+        * @return       void
+        */
+        ////////////////////////////////////////////////////////////////////////////////
+        static void flash_ecc_load(void)
+        {
+            g_flash_ecc.map_num     = 0U;
+            g_flash_ecc.entry_num   = 0U;
+
+            for ( uint32_t n = 0U; n < FLASH_CFG_ECC_REMAP_PAGE_NUM; n++ )
+            {
+                const flash_ecc_entry_t * const p_entry = (const flash_ecc_entry_t*) FLASH_ECC_ENTRY_ADDR( n );
+                uint32_t                        idx     = 0U;
+
+                // End of table
+                if  (   ( 0xFFFFFFFFU == p_entry->page )
+                    &&  ( 0xFFFFFFFFU == p_entry->spare )
+                    &&  ( 0xFFFFFFFFU == p_entry->seq )
+                    &&  ( 0xFFFFFFFFU == p_entry->check ))
+                {
+                    break;
+                }
+
+                g_flash_ecc.entry_num++;
+
+                if ( true == flash_ecc_entry_is_valid( p_entry, n ))
+                {
+                    // Existing page is overridden
+                    for ( idx = 0U; idx < g_flash_ecc.map_num; idx++ )
+                    {
+                        if ( p_entry->page == g_flash_ecc.page[idx] )
+                        {
+                            break;
+                        }
+                    }
+
+                    g_flash_ecc.page[idx]   = p_entry->page;
+                    g_flash_ecc.spare[idx]  = p_entry->spare;
+
+                    if ( idx == g_flash_ecc.map_num )
+                    {
+                        g_flash_ecc.map_num++;
+                    }
+                }
+            }
+        }
+
+        ////////////////////////////////////////////////////////////////////////////////
+        /**
+        *       Relocate page to spare page
+        *
+        * @note     Content is copied row by row, blank rows are skipped.
+        *           Table entry is appended only after copy succeeded, so
+        *           interrupted relocation leaves old mapping in place.
+        *
+        * @param[in]    addr        - Address of corrected ECC error
+        * @return       status      - Status of operation
+        */
+        ////////////////////////////////////////////////////////////////////////////////
+        static flash_status_t flash_ecc_relocate(const uint32_t addr)
+        {
+                  flash_status_t    status  = eFLASH_OK;
+                  uint32_t          page    = ( addr & ~FLASH_PAGE_MASK );
+            const uint32_t          spare   = FLASH_ECC_SPARE_ADDR( g_flash_ecc.entry_num );
+
+            // Error reported at spare page belongs to its logical page
+            for ( uint32_t n = 0U; n < g_flash_ecc.map_num; n++ )
+            {
+                if ( page == g_flash_ecc.spare[n] )
+                {
+                    page = g_flash_ecc.page[n];
+                    break;
+                }
+            }
+
+            // Remap area itself and stale spares are not relocated
+            if  (   (( page >= FLASH_CFG_ECC_REMAP_START_ADDR ) && ( page < ( FLASH_CFG_ECC_REMAP_START_ADDR + FLASH_ECC_AREA_SIZE )))
+                ||  ( false == flash_is_in_region( page, FLASH_CFG_PAGE_SIZE_BYTE )))
+            {
+                status = eFLASH_OK;
+            }
+
+            // No more spare pages
+            else if ( g_flash_ecc.entry_num >= FLASH_CFG_ECC_REMAP_PAGE_NUM )
+            {
+                status = eFLASH_ERROR;
+            }
+            else
+            {
+                const uint32_t          src     = flash_ecc_translate( page );
+                FLASH_EraseInitTypeDef  job[eFLASH_BANK_NUM_OF];
+                const uint8_t           job_num = flash_erase_plan( spare, FLASH_CFG_PAGE_SIZE_BYTE, job );
+
+                status = flash_erase_execute( job, job_num );
+
+                // Copy content, row by row
+                for ( uint32_t offset = 0U; ( offset < FLASH_CFG_PAGE_SIZE_BYTE ) && ( eFLASH_OK == status ); offset += FLASH_ROW_SIZE )
+                {
+                    uint32_t    row[ FLASH_ROW_SIZE / 4U ];
+                    bool        is_blank = true;
+
+                    memcpy( row, (const void*)( src + offset ), FLASH_ROW_SIZE );
+
+                    // Blank check
+                    for ( uint32_t word = 0U; word < ( FLASH_ROW_SIZE / 4U ); word++ )
+                    {
+                        if ( 0xFFFFFFFFU != row[word] )
+                        {
+                            is_blank = false;
+                            break;
+                        }
+                    }
+
+                    if ( false == is_blank )
+                    {
+                        status = flash_program_phys( spare + offset, FLASH_ROW_SIZE, (const uint8_t*) row, true );
+                    }
+                }
+
+                // Commit mapping, check word is programmed last
+                if ( eFLASH_OK == status )
+                {
+                    uint32_t                    entry[ FLASH_ECC_ENTRY_SIZE / 4U ];
+                    flash_ecc_entry_t * const   p_entry = (flash_ecc_entry_t*) entry;
+
+                    memset( entry, 0xFF, sizeof( entry ));
+                    p_entry->page   = page;
+                    p_entry->spare  = spare;
+                    p_entry->seq    = g_flash_ecc.entry_num;
+                    p_entry->check  = FLASH_ECC_ENTRY_CHECK( p_entry );
+
+                    status = flash_program_phys( FLASH_ECC_ENTRY_ADDR( g_flash_ecc.entry_num ), FLASH_ECC_ENTRY_SIZE, (const uint8_t*) entry, true );
+                }
+
+                if ( eFLASH_OK == status )
+                {
+                    flash_ecc_load();
+                    g_flash_stats.ecc_remap_num++;
+                }
+            }
+
+            return status;
+        }
+
+        ////////////////////////////////////////////////////////////////////////////////
+        /**
+        *       Erase spare pages of relocated pages within erased range
+        *
+        * @note     Erasing remap area itself drops all relocations.
+        *
+        * @param[in]    addr        - Start address of erased memory
+        * @param[in]    size        - Size of erased memory in bytes
+        * @return       status      - Status of operation
+        */
+        ////////////////////////////////////////////////////////////////////////////////
+        static flash_status_t flash_ecc_erase_remapped(const uint32_t addr, const uint32_t size)
+        {
+            flash_status_t status = eFLASH_OK;
+
+            for ( uint32_t n = 0U; ( n < g_flash_ecc.map_num ) && ( eFLASH_OK == status ); n++ )
+            {
+                if  (   ( g_flash_ecc.page[n] >= addr )
+                    &&  ( g_flash_ecc.page[n] < ( addr + size )))
+                {
+                    FLASH_EraseInitTypeDef  job[eFLASH_BANK_NUM_OF];
+                    const uint8_t           job_num = flash_erase_plan( g_flash_ecc.spare[n], FLASH_CFG_PAGE_SIZE_BYTE, job );
+
+                    status = flash_erase_execute( job, job_num );
+                }
+            }
+
+            // Remap area erased
+            if  (   ( addr < ( FLASH_CFG_ECC_REMAP_START_ADDR + FLASH_ECC_AREA_SIZE ))
+                &&  (( addr + size ) > FLASH_CFG_ECC_REMAP_START_ADDR ))
+            {
+                flash_ecc_load();
+            }
+
+            return status;
+        }
+
+    #endif // ( 1 == FLASH_CFG_ECC_REMAP_EN )
+
+#endif // ( 1 == FLASH_CFG_ECC_EN )
+
+#if ( 1 == FLASH_CFG_ATOMIC_EN )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Read commit marker of atomic page
+    *
+    * @param[in]    page_addr   - Start address of page
+    * @param[out]   p_seq       - Sequence number of committed copy
+    * @return       is_valid    - Page holds committed copy
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static bool flash_atomic_commit_read(const uint32_t page_addr, uint32_t * const p_seq)
+    {
+        flash_atomic_commit_t   commit      = {0};
+        bool                    is_intact   = true;
+
+        #if ( 1 == FLASH_CFG_ECC_EN )
+            is_intact = flash_ecc_probe( page_addr + FLASH_ATOMIC_COMMIT_OFFSET, sizeof( commit ), (uint8_t*) &commit );
+        #else
+            flash_read_internal( page_addr + FLASH_ATOMIC_COMMIT_OFFSET, sizeof( commit ), (uint8_t*) &commit );
+        #endif
+
+        *p_seq = commit.seq;
+
+        return (( true == is_intact ) && ( commit.seq == ( ~commit.seq_inv )));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Mount atomic slots
+    *
+    * @note     Newest committed copy of each slot wins. Copy with interrupted
+    *           write or erase has no valid marker or older sequence number.
+    *           Torn marker fails ECC check, its NMI is masked while probing.
+    *
+    * @return       void
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static void flash_atomic_init(void)
+    {
+        for ( uint32_t slot = 0U; slot < FLASH_CFG_ATOMIC_SLOT_NUM; slot++ )
+        {
+            g_flash_atomic[slot].is_valid = false;
+
+            for ( uint8_t copy = 0U; copy < 2U; copy++ )
+            {
+                uint32_t seq = 0U;
+
+                if  (   ( true == flash_atomic_commit_read( FLASH_ATOMIC_PAGE_ADDR( slot, copy ), &seq ))
+                    &&  (   ( false == g_flash_atomic[slot].is_valid )
+                        ||  ( 0 < (int32_t)( seq - g_flash_atomic[slot].seq ))))
+                {
+                    g_flash_atomic[slot].seq        = seq;
+                    g_flash_atomic[slot].copy       = copy;
+                    g_flash_atomic[slot].is_valid   = true;
+                }
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Erase atomic page if not blank
+    *
+    * @param[in]    page_addr   - Start address of page
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static flash_status_t flash_atomic_page_erase(const uint32_t page_addr)
+    {
+        flash_status_t  status      = eFLASH_OK;
+        bool            is_blank    = true;
+        uint32_t        row[ FLASH_ROW_SIZE / 4U ];
+
+        // Blank check, skip erase of clean page. Torn page is not blank.
+        for ( uint32_t offset = 0U; ( offset < FLASH_CFG_PAGE_SIZE_BYTE ) && ( true == is_blank ); offset += FLASH_ROW_SIZE )
+        {
+            #if ( 1 == FLASH_CFG_ECC_EN )
+                is_blank = flash_ecc_probe( page_addr + offset, FLASH_ROW_SIZE, (uint8_t*) row );
+            #else
+                flash_read_internal( page_addr + offset, FLASH_ROW_SIZE, (uint8_t*) row );
+            #endif
+
+            for ( uint32_t word = 0U; word < ( FLASH_ROW_SIZE / 4U ); word++ )
+            {
+                if ( 0xFFFFFFFFU != row[word] )
+                {
+                    is_blank = false;
+                    break;
+                }
+            }
+        }
+
+        if ( false == is_blank )
+        {
+            FLASH_EraseInitTypeDef  job[eFLASH_BANK_NUM_OF];
+            const uint8_t           job_num = flash_erase_plan( page_addr, FLASH_CFG_PAGE_SIZE_BYTE, job );
+
+            status = flash_erase_execute( job, job_num );
+
+            #if (( 1 == FLASH_CFG_ECC_EN ) && ( 1 == FLASH_CFG_ECC_REMAP_EN ))
+
+                // Erase spare of relocated page
+                if ( eFLASH_OK == status )
+                {
+                    status = flash_ecc_erase_remapped( page_addr, FLASH_CFG_PAGE_SIZE_BYTE );
+                }
+
+            #endif
+        }
+
+        return status;
+    }
+
+#endif // ( 1 == FLASH_CFG_ATOMIC_EN )
+
+#if ( 1 == FLASH_CFG_FAULT_INJECT_EN )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Count operation and check for armed power cut
+    *
+    * @return       is_cut      - Power cut at this operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static bool flash_fault_hit(void)
+    {
+        bool is_cut = false;
+
+        g_flash_stats.fault_op_num++;
+
+        if ( true == g_flash_fault.is_armed )
+        {
+            if ( 0U == g_flash_fault.op_num )
+            {
+                g_flash_fault.is_armed = false;
+                is_cut = true;
+            }
+            else
+            {
+                g_flash_fault.op_num--;
+            }
+        }
+
+        return is_cut;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Cut power during programming of single program unit
+    *
+    * @note     On G0/G4/L4 programming is started via registers and cut
+    *           callback is called while double word is being programmed,
+    *           reset from callback leaves torn double word. On H7 callback
+    *           is called before programming.
+    *
+    *           If callback returns, operation is completed and reported
+    *           as failed.
+    *
+    * @param[in]    addr        - Flash address, program unit aligned
+    * @param[in]    p_unit      - Program unit data
+    * @return       status      - Always error
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static flash_status_t flash_fault_cut_program(const uint32_t addr, const uint8_t * const p_unit)
+    {
+        #if ( FLASH_CFG_FAMILY_H7 == FLASH_CFG_FAMILY )
+
+            (void) p_unit;
+
+            if ( NULL != g_flash_fault.pf_cut )
+            {
+                g_flash_fault.pf_cut( addr );
+            }
+
+        #else
+
+            volatile uint32_t * const   p_flash = (volatile uint32_t*) addr;
+            uint32_t                    word[FLASH_PROG_SIZE / sizeof( uint32_t )];
+
+            memcpy( &word, p_unit, FLASH_PROG_SIZE );
+
+            while ( 0U != ( READ_REG( FLASH->SR ) & FLASH_LL_SR_BUSY ))
+            {
+                // Wait...
+            }
+
+            WRITE_REG( FLASH->SR, ( FLASH_LL_SR_ERRORS | FLASH_SR_EOP ));
+            SET_BIT( FLASH->CR, FLASH_CR_PG );
+
+            // Programming starts with second word
+            p_flash[0] = word[0];
+            __ISB();
+            p_flash[1] = word[1];
+
+            if ( NULL != g_flash_fault.pf_cut )
+            {
+                g_flash_fault.pf_cut( addr );
+            }
+
+            while ( 0U != ( READ_REG( FLASH->SR ) & FLASH_LL_SR_BUSY ))
+            {
+                // Wait...
+            }
+
+            CLEAR_BIT( FLASH->CR, FLASH_CR_PG );
+            WRITE_REG( FLASH->SR, ( FLASH_LL_SR_ERRORS | FLASH_SR_EOP ));
+
+        #endif
+
+        return eFLASH_ERROR;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Cut power during erase
+    *
+    * @note     On G0/G4/L4 page erase is started via registers and cut
+    *           callback is called while page is being erased, reset from
+    *           callback leaves partially erased page. Mass erase and H7
+    *           sector erase call callback before erase.
+    *
+    *           If callback returns, operation is reported as failed.
+    *
+    * @param[in]    p_job       - Erase job, single page for page erase
+    * @return       status      - Always error
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static flash_status_t flash_fault_cut_erase(const FLASH_EraseInitTypeDef * const p_job)
+    {
+        const uint32_t sector_error = (( FLASH_TYPEERASE_UNIT == p_job->TypeErase ) ? FLASH_JOB_UNIT( *p_job ) : 0xFFFFFFFFU );
+        const uint32_t addr         = flash_erase_error_addr( p_job, sector_error );
+
+        #if ( FLASH_CFG_FAMILY_H7 != FLASH_CFG_FAMILY )
+
+            if ( FLASH_TYPEERASE_UNIT == p_job->TypeErase )
+            {
+                flash_erase_unit_start( p_job );
+
+                if ( NULL != g_flash_fault.pf_cut )
+                {
+                    g_flash_fault.pf_cut( addr );
+                }
+
+                while ( 0U != ( READ_REG( FLASH->SR ) & FLASH_LL_SR_BUSY ))
+                {
+                    // Wait...
+                }
+
+                (void) flash_erase_unit_end( p_job );
+            }
+            else
+
+        #endif
+        {
+            if ( NULL != g_flash_fault.pf_cut )
+            {
+                g_flash_fault.pf_cut( addr );
+            }
+        }
+
+        return eFLASH_ERROR;
+    }
+
+#endif // ( 1 == FLASH_CFG_FAULT_INJECT_EN )
+
+#if ( 1 == FLASH_CFG_LATENCY_EN )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Calculate minimal wait states
+    *
+    * @param[in]    hclk        - HCLK frequency in Hz
+    * @param[in]    vrange      - Voltage range, PWR_REGULATOR_VOLTAGE_SCALEx
+    * @return       latency     - Wait states, 0xFFFFFFFF if HCLK too high for range
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static uint32_t flash_latency_calc(const uint32_t hclk, const uint32_t vrange)
+    {
+        const uint32_t *    p_max_hz    = g_flash_ws_range2_hz;
+        uint32_t            ws_num      = ( sizeof( g_flash_ws_range2_hz ) / sizeof( uint32_t ));
+        uint32_t            latency     = 0xFFFFFFFFU;
+
+        #if defined( PWR_REGULATOR_VOLTAGE_SCALE1_BOOST ) && ( FLASH_CFG_FAMILY_G0 != FLASH_CFG_FAMILY )
+            if ( PWR_REGULATOR_VOLTAGE_SCALE1_BOOST == vrange )
+            {
+                p_max_hz    = g_flash_ws_boost_hz;
+                ws_num      = ( sizeof( g_flash_ws_boost_hz ) / sizeof( uint32_t ));
+            }
+            else
+        #endif
+        if ( PWR_REGULATOR_VOLTAGE_SCALE1 == vrange )
+        {
+            p_max_hz    = g_flash_ws_range1_hz;
+            ws_num      = ( sizeof( g_flash_ws_range1_hz ) / sizeof( uint32_t ));
+        }
+        else
+        {
+            // Range 2
+        }
+
+        for ( uint32_t ws = 0U; ws < ws_num; ws++ )
+        {
+            if ( hclk <= p_max_hz[ws] )
+            {
+                latency = ws;
+                break;
+            }
+        }
+
+        return latency;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Apply wait states
+    *
+    * @note     New latency must be read back before clock changes.
+    *
+    * @param[in]    latency     - Wait states
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static flash_status_t flash_latency_apply(const uint32_t latency)
+    {
+        flash_status_t status = eFLASH_OK;
+
+        __HAL_FLASH_SET_LATENCY( latency << FLASH_ACR_LATENCY_Pos );
+
+        if (( latency << FLASH_ACR_LATENCY_Pos ) != __HAL_FLASH_GET_LATENCY())
+        {
+            status = eFLASH_ERROR;
+        }
+
+        return status;
+    }
+
+#endif // ( 1 == FLASH_CFG_LATENCY_EN )
+
+#if ( 1 == FLASH_CFG_POOL_EN )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Get start address of pool page
+    *
+    * @param[in]    page        - Pool page index
+    * @return       addr        - Start address of page
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static uint32_t flash_pool_page_addr(const uint32_t page)
+    {
+        return (uint32_t)( FLASH_CFG_POOL_START_ADDR + ( page << FLASH_PAGE_SHIFT ));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Initialize pre-erased page pool
+    *
+    * @note     Blank pages are ready for allocation, all other pages are
+    *           treated as used until released by user as their content
+    *           might still be valid.
+    *
+    * @return       void
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static void flash_pool_init(void)
+    {
+        g_flash_pool.alloc_idx  = 0U;
+        g_flash_pool.erase_idx  = 0U;
+
+        for ( uint32_t page = 0U; page < FLASH_CFG_POOL_PAGE_NUM; page++ )
+        {
+            const uint32_t * const p_word = (const uint32_t*) flash_pool_page_addr( page );
+
+            g_flash_pool.state[page] = eFLASH_POOL_PAGE_ERASED;
+
+            // Blank check
+            for ( uint32_t word = 0U; word < ( FLASH_CFG_PAGE_SIZE_BYTE / sizeof( uint32_t )); word++ )
+            {
+                if ( 0xFFFFFFFFU != p_word[word] )
+                {
+                    g_flash_pool.state[page] = eFLASH_POOL_PAGE_USED;
+                    break;
+                }
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Count pre-erased pages in pool
+    *
+    * @note     Counted from page states instead of shared counter as erase
+    *           completion may be reported from interrupt context.
+    *
+    * @return       erased_num  - Number of pre-erased pages
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static uint32_t flash_pool_count_erased(void)
+    {
+        uint32_t erased_num = 0U;
+
+        for ( uint32_t page = 0U; page < FLASH_CFG_POOL_PAGE_NUM; page++ )
+        {
+            if ( eFLASH_POOL_PAGE_ERASED == g_flash_pool.state[page] )
+            {
+                erased_num++;
+            }
+        }
+
+        return erased_num;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Pool page erase completion
+    *
+    * @note     With interrupt driven erase called from interrupt context!
+    *
+    * @param[in]    status      - Status of erase
+    * @return       void
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static void flash_pool_erase_done(const flash_status_t status)
+    {
+        if ( eFLASH_OK == status )
+        {
+            g_flash_pool.state[ g_flash_pool.erase_idx ] = eFLASH_POOL_PAGE_ERASED;
+        }
+
+        // Retry later
+        else
+        {
+            g_flash_pool.state[ g_flash_pool.erase_idx ] = eFLASH_POOL_PAGE_DIRTY;
+        }
+    }
+
+#endif // ( 1 == FLASH_CFG_POOL_EN )
+
+#if ( 1 == FLASH_CFG_BATCH_EN )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Check if any byte of staging row program unit is staged
+    *
+    * @param[in]    unit        - Program unit index inside row
+    * @return       is_staged   - Program unit staged
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static bool flash_batch_is_unit_staged(const uint32_t unit)
+    {
+        bool is_staged = false;
+
+        for ( uint32_t mask = ( unit * ( FLASH_PROG_SIZE / 8U )); mask < (( unit + 1U ) * ( FLASH_PROG_SIZE / 8U )); mask++ )
+        {
+            if ( 0U != g_flash_batch.byte_mask[mask] )
+            {
+                is_staged = true;
+                break;
+            }
+        }
+
+        return is_staged;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Program staged row to flash
+    *
+    * @note     Completely staged row is programmed with fast programming,
+    *           otherwise only staged runs of program units are programmed.
+    *
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static flash_status_t flash_batch_flush_internal(void)
+    {
+        flash_status_t  status  = eFLASH_OK;
+        uint32_t        unit    = 0U;
+
+        while (( unit < ( FLASH_ROW_SIZE / FLASH_PROG_SIZE )) && ( true == g_flash_batch.is_used ))
+        {
+            // Find run of staged program units
+            if ( true == flash_batch_is_unit_staged( unit ))
+            {
+                const uint32_t start = unit;
+
+                while   (   ( unit < ( FLASH_ROW_SIZE / FLASH_PROG_SIZE ))
+                        &&  ( true == flash_batch_is_unit_staged( unit )))
+                {
+                    unit++;
+                }
+
+                const flash_status_t prog_status = flash_program(( g_flash_batch.addr + ( start * FLASH_PROG_SIZE )),
+                                                                 (( unit - start ) * FLASH_PROG_SIZE ),
+                                                                 &((const uint8_t*) g_flash_batch.row )[ start * FLASH_PROG_SIZE ] );
+
+                if ( eFLASH_OK != prog_status )
+                {
+                    status = prog_status;
+                }
+            }
+            else
+            {
+                unit++;
+            }
+        }
+
+        if ( true == g_flash_batch.is_used )
+        {
+            g_flash_stats.batch_flush_num++;
+        }
+
+        // Staging row is empty again
+        g_flash_batch.is_used = false;
+
+        return status;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Check if every byte of staging row is staged
+    *
+    * @return       is_full     - Row completely staged
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static bool flash_batch_is_row_full(void)
+    {
+        bool is_full = true;
+
+        for ( uint32_t mask = 0U; mask < sizeof( g_flash_batch.byte_mask ); mask++ )
+        {
+            if ( 0xFFU != g_flash_batch.byte_mask[mask] )
+            {
+                is_full = false;
+                break;
+            }
+        }
+
+        return is_full;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Flush staged row if it overlaps memory range
+    *
+    * @note     Keeps reads, erases and unbuffered writes consistent with
+    *           previously batched writes.
+    *
+    * @param[in]    addr        - Start address of memory range
+    * @param[in]    size        - Size of memory range in bytes
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static flash_status_t flash_batch_sync(const uint32_t addr, const uint32_t size)
+    {
+        flash_status_t status = eFLASH_OK;
+
+        if  (   ( true == g_flash_batch.is_used )
+            &&  ( addr < ( g_flash_batch.addr + FLASH_ROW_SIZE ))
+            &&  (( addr + size ) > g_flash_batch.addr ))
+        {
+            status = flash_batch_flush_internal();
+        }
+
+        return status;
+    }
+
+#endif // ( 1 == FLASH_CFG_BATCH_EN )
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+* @} <!-- END GROUP -->
+*/
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*@addtogroup FLASH_API
+* @{ <!-- BEGIN GROUP -->
+*
+* 	Following function are part of Flash API.
+*/
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Initialize STM32 internal flash
+*
+* @return       status - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_init(void)
+{
+    flash_status_t status = eFLASH_OK;
+
+    if ( false == gb_is_init )
+    {
+        // Enable flash clock
+        __HAL_RCC_FLASH_CLK_ENABLE();
+
+        // Wait for flash to be ready, OS may not run yet
+        while(__HAL_FLASH_GET_FLAG(FLASH_FLAG_BSY) != RESET);
+
+        // Create OS resources
+        if ( eFLASH_OK != flash_os_init())
+        {
+            status = eFLASH_ERROR;
+        }
+
+        // Detect size and bank mode
+        else if ( eFLASH_OK != flash_geo_init())
+        {
+            status = eFLASH_ERROR;
+        }
+
+        // Unlock flash
+        else if ( HAL_OK != HAL_FLASH_Unlock())
+        {
+            status = eFLASH_ERROR;
+        }
+        else
+        {
+            #if (( 1 == FLASH_CFG_BENCHMARK_EN ) || (( 1 == FLASH_CFG_JOB_EN ) && ( FLASH_CFG_FAMILY_G0 != FLASH_CFG_FAMILY )))
+
+                // Enable cycle counter
+                CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+                DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+            #endif
+
+            #if (( 1 == FLASH_CFG_ASYNC_ERASE_EN ) || ( 1 == FLASH_CFG_ECC_EN ))
+
+                // Enable flash interrupt
+                HAL_NVIC_SetPriority( FLASH_IRQn, FLASH_CFG_IRQ_PRIORITY, 0U );
+                HAL_NVIC_EnableIRQ( FLASH_IRQn );
+
+            #endif
+
+            #if ( 1 == FLASH_CFG_ECC_EN )
+
+                // Interrupt on corrected ECC error
+                WRITE_REG( FLASH->ECCR, ( FLASH_ECCR_ECCC | FLASH_ECCR_ECCD ));
+                SET_BIT( FLASH->ECCR, FLASH_ECCR_ECCCIE );
+
+                #if ( 1 == FLASH_CFG_ECC_REMAP_EN )
+
+                    // Restore relocations
+                    flash_ecc_load();
+
+                #endif
+
+            #endif
+
+            #if ( 1 == FLASH_CFG_POOL_EN )
+
+                // Find pre-erased pages
+                flash_pool_init();
+
+            #endif
+
+            #if ( 1 == FLASH_CFG_ATOMIC_EN )
+
+                // Recover newest committed copies
+                flash_atomic_init();
+
+            #endif
+
+            // Init success
+            gb_is_init = true;
+        }
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       De-Initialize STM32 internal flash
+*
+* @note     Rejected with eFLASH_ERROR_BUSY while interrupt driven erase
+*           is in progress in bare-metal configuration.
+*
+* @return       status - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_deinit(void)
+{
+    flash_status_t status = eFLASH_OK;
+
+    if ( true == gb_is_init )
+    {
+        // Busy with interrupt driven erase in bare-metal configuration
+        status = flash_lock();
+
+        if ( eFLASH_OK == status )
+        {
+            #if ( 1 == FLASH_CFG_ECC_EN )
+
+                // Disable ECC interrupt
+                CLEAR_BIT( FLASH->ECCR, FLASH_ECCR_ECCCIE );
+
+            #endif
+
+            #if (( 1 == FLASH_CFG_ASYNC_ERASE_EN ) || ( 1 == FLASH_CFG_ECC_EN ))
+
+                // Disable flash interrupt
+                HAL_NVIC_DisableIRQ( FLASH_IRQn );
+
+            #endif
+
+            // Lock flash
+            if ( HAL_OK != HAL_FLASH_Lock())
+            {
+                status = eFLASH_ERROR;
+            }
+            else
+            {
+                // Disable flash clock
+                __HAL_RCC_FLASH_CLK_DISABLE();
+
+                // De-init success
+                gb_is_init = false;
+            }
+
+            flash_unlock();
+        }
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Get Flash initialization flag
+*
+* @param[out]   p_is_init   - Pointer to init flag
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_is_init(bool * const p_is_init)
+{
+    flash_status_t status = eFLASH_OK;
+
+    FLASH_ASSERT( NULL != p_is_init );
+
+    if ( NULL != p_is_init )
+    {
+        *p_is_init = gb_is_init;
+    }
+    else
+    {
+        status = eFLASH_ERROR;
+    }
+
+    return status;
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Write to flash
+*
+* @param[in]    addr        - Flash address
+* @param[in]    size        - Size of data to write in bytes
+* @param[in]    p_data      - Data to write
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_write(const uint32_t addr, const uint32_t size, const uint8_t * const p_data)
+{
+    flash_status_t status = eFLASH_OK;
+
+    FLASH_ASSERT( true == gb_is_init );
+    FLASH_ASSERT( true == flash_is_in_region( addr, size ));
+    FLASH_ASSERT( NULL != p_data );
+
+    if  (   ( true == gb_is_init )
+        &&  ( true == flash_is_in_region( addr, size ))
+        &&  ( NULL != p_data )
+        &&  ( eFLASH_OK == flash_lock()))
+    {
+        #if ( 1 == FLASH_CFG_BATCH_EN )
+            status = flash_batch_sync( addr, size );
+        #endif
+
+        // Write all program units
+        if ( eFLASH_OK == status )
+        {
+            status = flash_program( addr, size, p_data );
+        }
+
+        flash_unlock();
+    }
+    else
+    {
+        status = (( false == flash_is_in_region( addr, size )) ? eFLASH_ERROR_RANGE : flash_lock_error());
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Scatter-gather write to flash
+*
+* @note     Fragments are written to consecutive flash addresses in single
+*           pass, in runs up to next row boundary. Run completely inside
+*           single fragment is programmed straight from fragment memory,
+*           otherwise it is assembled from fragments. Each run is programmed
+*           with single call, complete rows with fast programming.
+*
+* @param[in]    addr        - Flash address
+* @param[in]    p_iov       - I/O vector fragments
+* @param[in]    count       - Number of fragments
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_writev(const uint32_t addr, const flash_iovec_t * const p_iov, const uint32_t count)
+{
+    flash_status_t  status                      = eFLASH_OK;
+    uint32_t        size                        = 0U;
+    uint32_t        offset                      = 0U;
+    uint32_t        idx                         = 0U;
+    uint32_t        frag_offset                 = 0U;
+    uint32_t        row[FLASH_ROW_SIZE / sizeof( uint32_t )];
+
+    FLASH_ASSERT( true == gb_is_init );
+    FLASH_ASSERT( NULL != p_iov );
+
+    // Validate fragments and get total size
+    if ( NULL != p_iov )
+    {
+        for ( uint32_t frag = 0U; ( frag < count ) && ( eFLASH_OK == status ); frag++ )
+        {
+            FLASH_ASSERT(( NULL != p_iov[frag].p_data ) || ( 0U == p_iov[frag].size ));
+
+            if (( NULL == p_iov[frag].p_data ) && ( 0U != p_iov[frag].size ))
+            {
+                status = eFLASH_ERROR;
+            }
+
+            // Total size overflow
+            else if ( p_iov[frag].size > ( UINT32_MAX - size ))
+            {
+                status = eFLASH_ERROR_RANGE;
+            }
+            else
+            {
+                size += p_iov[frag].size;
+            }
+        }
+    }
+    else
+    {
+        status = eFLASH_ERROR;
+    }
+
+    FLASH_ASSERT( eFLASH_ERROR_RANGE != status );
+    FLASH_ASSERT( true == flash_is_in_region( addr, size ));
+
+    if ( eFLASH_OK == status )
+    {
+        if  (   ( true == gb_is_init )
+            &&  ( true == flash_is_in_region( addr, size ))
+            &&  ( eFLASH_OK == flash_lock()))
+        {
+            #if ( 1 == FLASH_CFG_BATCH_EN )
+                status = flash_batch_sync( addr, size );
+            #endif
+
+            while (( offset < size ) && ( eFLASH_OK == status ))
+            {
+                const uint32_t  flash_addr  = ( addr + offset );
+                const uint32_t  row_left    = ( FLASH_ROW_SIZE - ( flash_addr & ( FLASH_ROW_SIZE - 1U )));
+                const uint32_t  chunk       = ((( size - offset ) < row_left ) ? ( size - offset ) : row_left );
+
+                // Skip empty fragments
+                while (( idx < count ) && ( frag_offset >= p_iov[idx].size ))
+                {
+                    idx++;
+                    frag_offset = 0U;
+                }
+
+                // Run inside single fragment, word aligned for fast programmed row
+                if  (   (( p_iov[idx].size - frag_offset ) >= chunk )
+                    &&  (   ( chunk < FLASH_ROW_SIZE )
+                        ||  ( 0U == ((uint32_t) &p_iov[idx].p_data[frag_offset] & 0x3U ))))
+                {
+                    status = flash_program( flash_addr, chunk, &p_iov[idx].p_data[frag_offset] );
+
+                    frag_offset += chunk;
+                }
+
+                // Assemble run from fragments
+                else
+                {
+                    (void) flash_iov_gather( p_iov, count, &idx, &frag_offset, (uint8_t*) row, chunk );
+
+                    status = flash_program( flash_addr, chunk, (const uint8_t*) row );
+                }
+
+                offset += chunk;
+            }
+
+            flash_unlock();
+        }
+        else
+        {
+            status = (( false == flash_is_in_region( addr, size )) ? eFLASH_ERROR_RANGE : flash_lock_error());
+        }
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Read data from flash
+*
+* @param[in]    addr        - Flash address
+* @param[in]    size        - Size of data to read in bytes
+* @param[out]   p_data      - Data to write
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_read(const uint32_t addr, const uint32_t size, uint8_t * const p_data)
+{
+    flash_status_t status = eFLASH_OK;
+
+    FLASH_ASSERT( true == gb_is_init );
+    FLASH_ASSERT( true == flash_is_in_region( addr, size ));
+    FLASH_ASSERT( NULL != p_data );
+
+    if  (   ( true == gb_is_init )
+        &&  ( true == flash_is_in_region( addr, size ))
+        &&  ( NULL != p_data ))
+    {
+        #if ( 1 == FLASH_CFG_BATCH_EN )
+
+            // Make batched writes visible
+            if ( true == g_flash_batch.is_used )
+            {
+                status = flash_lock();
+
+                if ( eFLASH_OK == status )
+                {
+                    status = flash_batch_sync( addr, size );
+
+                    flash_unlock();
+                }
+            }
+
+        #endif
+
+        #if ( 1 == FLASH_CFG_ECC_EN )
+            const uint32_t ecc_uncorr_num = g_flash_stats.ecc_uncorr_num;
+        #endif
+
+        // Read data
+        flash_read_internal( addr, size, p_data );
+
+        #if ( 1 == FLASH_CFG_ECC_EN )
+
+            // Uncorrectable error reported by NMI during read
+            if ( ecc_uncorr_num != g_flash_stats.ecc_uncorr_num )
+            {
+                status = eFLASH_ERROR_ECC;
+            }
+
+        #endif
+    }
+    else
+    {
+        status = (( false == flash_is_in_region( addr, size )) ? eFLASH_ERROR_RANGE : eFLASH_ERROR );
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Vectored read of multiple flash ranges
+*
+* @note     All descriptors are validated once up-front, then sorted by
+*           flash address for prefetch locality. Descriptor list order is
+*           changed!
+*
+* @param[in,out]p_desc      - Read descriptors
+* @param[in]    count       - Number of descriptors
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_readv(flash_read_desc_t * const p_desc, const uint32_t count)
+{
+    flash_status_t status = eFLASH_OK;
+
+    FLASH_ASSERT( true == gb_is_init );
+    FLASH_ASSERT( NULL != p_desc );
+
+    if  (   ( true == gb_is_init )
+        &&  ( NULL != p_desc ))
+    {
+        // Validate all descriptors
+        for ( uint32_t desc = 0U; desc < count; desc++ )
+        {
+            FLASH_ASSERT( true == flash_is_in_region( p_desc[desc].addr, p_desc[desc].size ));
+            FLASH_ASSERT( NULL != p_desc[desc].p_data );
+
+            if ( NULL == p_desc[desc].p_data )
+            {
+                status = eFLASH_ERROR;
+                break;
+            }
+            else if ( false == flash_is_in_region( p_desc[desc].addr, p_desc[desc].size ))
+            {
+                status = eFLASH_ERROR_RANGE;
+                break;
+            }
+            else
+            {
+                // Valid descriptor
+            }
+        }
+
+        #if ( 1 == FLASH_CFG_BATCH_EN )
+
+            // Make batched writes visible
+            if  (   ( eFLASH_OK == status )
+                &&  ( true == g_flash_batch.is_used ))
+            {
+                status = flash_lock();
+
+                if ( eFLASH_OK == status )
+                {
+                    status = flash_batch_flush_internal();
+
+                    flash_unlock();
+                }
+            }
+
+        #endif
+
+        if ( eFLASH_OK == status )
+        {
+            #if ( 1 == FLASH_CFG_ECC_EN )
+                const uint32_t ecc_uncorr_num = g_flash_stats.ecc_uncorr_num;
+            #endif
+
+            flash_read_desc_sort( p_desc, count );
+
+            for ( uint32_t desc = 0U; desc < count; desc++ )
+            {
+                flash_read_internal( p_desc[desc].addr, p_desc[desc].size, p_desc[desc].p_data );
+            }
+
+            #if ( 1 == FLASH_CFG_ECC_EN )
+
+                // Uncorrectable error reported by NMI during read
+                if ( ecc_uncorr_num != g_flash_stats.ecc_uncorr_num )
+                {
+                    status = eFLASH_ERROR_ECC;
+                }
+
+            #endif
+        }
+    }
+    else
+    {
+        status = eFLASH_ERROR;
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Copy flash range to another flash location
+*
+* @note     Source is streamed row by row through internal staging buffer
+*           straight from memory mapped flash, complete destination rows
+*           are fast programmed. Destination rows already holding source
+*           data are skipped. Ranges may cross bank boundary.
+*
+* @note     Destination must be erased, except rows that already match.
+*           Overlapping ranges are rejected, programming cannot overwrite
+*           source data already written.
+*
+* @param[in]    dst         - Destination flash address, program unit aligned
+* @param[in]    src         - Source flash address
+* @param[in]    size        - Size of data to copy in bytes
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_copy(const uint32_t dst, const uint32_t src, const uint32_t size)
+{
+    flash_status_t  status  = eFLASH_OK;
+    uint32_t        done    = 0U;
+    uint32_t        row[FLASH_ROW_SIZE / sizeof( uint32_t )];
+
+    // Overflow safe, both ranges are inside user region
+    const bool is_overlap = ((( dst >= src ) ? ( dst - src ) : ( src - dst )) < size );
+
+    FLASH_ASSERT( true == gb_is_init );
+    FLASH_ASSERT( true == flash_is_in_region( dst, size ));
+    FLASH_ASSERT( true == flash_is_in_region( src, size ));
+    FLASH_ASSERT( 0U == ( dst & ( FLASH_PROG_SIZE - 1U )));
+    FLASH_ASSERT( false == is_overlap );
+
+    if  (   ( true == gb_is_init )
+        &&  ( true == flash_is_in_region( dst, size ))
+        &&  ( true == flash_is_in_region( src, size ))
+        &&  ( 0U == ( dst & ( FLASH_PROG_SIZE - 1U )))
+        &&  ( false == is_overlap )
+        &&  ( eFLASH_OK == flash_lock()))
+    {
+        #if ( 1 == FLASH_CFG_BATCH_EN )
+
+            status = flash_batch_sync( src, size );
+
+            if ( eFLASH_OK == status )
+            {
+                status = flash_batch_sync( dst, size );
+            }
+
+        #endif
+
+        #if ( 1 == FLASH_CFG_ECC_EN )
+            const uint32_t ecc_uncorr_num = g_flash_stats.ecc_uncorr_num;
+        #endif
+
+        while (( done < size ) && ( eFLASH_OK == status ))
+        {
+            // Chunks end at destination row boundaries
+            uint32_t chunk = ( FLASH_ROW_SIZE - (( dst + done ) & ( FLASH_ROW_SIZE - 1U )));
+
+            chunk = ((( size - done ) < chunk ) ? ( size - done ) : chunk );
+
+            // Stage source
+            flash_read_internal( src + done, chunk, (uint8_t*) row );
+
+            // Destination already holds data
+            if ( chunk == flash_compare_mem( flash_mem_addr( dst + done ), chunk, (const uint8_t*) row ))
+            {
+                g_flash_stats.copy_skip_num++;
+            }
+            else
+            {
+                status = flash_program( dst + done, chunk, (const uint8_t*) row );
+            }
+
+            done += chunk;
+        }
+
+        #if ( 1 == FLASH_CFG_ECC_EN )
+
+            // Uncorrectable error reported by NMI during read
+            if  (   ( eFLASH_OK == status )
+                &&  ( ecc_uncorr_num != g_flash_stats.ecc_uncorr_num ))
+            {
+                status = eFLASH_ERROR_ECC;
+            }
+
+        #endif
+
+        flash_unlock();
+    }
+    else if (( false == flash_is_in_region( dst, size )) || ( false == flash_is_in_region( src, size )))
+    {
+        status = eFLASH_ERROR_RANGE;
+    }
+    else if ( 0U != ( dst & ( FLASH_PROG_SIZE - 1U )))
+    {
+        status = eFLASH_ERROR_ALIGN;
+    }
+    else if ( true == is_overlap )
+    {
+        status = eFLASH_ERROR_OVERLAP;
+    }
+    else
+    {
+        status = flash_lock_error();
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Fill flash range with repeated double word pattern
+*
+* @note     Programmed from single row of pattern, no buffer of region
+*           size needed. Head up to first row boundary and tail after
+*           last one are programmed unit by unit. Complete erased rows are
+*           fast programmed, rows holding data (e.g. zero invalidation)
+*           unit by unit.
+*
+* @param[in]    addr        - Flash address, program unit aligned
+* @param[in]    size        - Size to fill in bytes
+* @param[in]    pattern     - Double word pattern
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_fill(const uint32_t addr, const uint32_t size, const uint64_t pattern)
+{
+    flash_status_t  status  = eFLASH_OK;
+    uint32_t        head    = 0U;
+    uint32_t        row_num = 0U;
+    uint32_t        tail    = 0U;
+    uint64_t        row[FLASH_ROW_SIZE / sizeof( uint64_t )];
+
+    FLASH_ASSERT( true == gb_is_init );
+    FLASH_ASSERT( true == flash_is_in_region( addr, size ));
+    FLASH_ASSERT( 0U == ( addr & ( FLASH_PROG_SIZE - 1U )));
+
+    if  (   ( true == gb_is_init )
+        &&  ( true == flash_is_in_region( addr, size ))
+        &&  ( 0U == ( addr & ( FLASH_PROG_SIZE - 1U )))
+        &&  ( eFLASH_OK == flash_lock()))
+    {
+        // Every unit aligned segment starts with same content
+        for ( uint32_t dw = 0U; dw < ( FLASH_ROW_SIZE / sizeof( uint64_t )); dw++ )
+        {
+            row[dw] = pattern;
+        }
+
+        // Head up to first row boundary, complete rows, tail after last row
+        head    = (( FLASH_ROW_SIZE - ( addr & ( FLASH_ROW_SIZE - 1U ))) & ( FLASH_ROW_SIZE - 1U ));
+        head    = (( size < head ) ? size : head );
+        row_num = (( size - head ) / FLASH_ROW_SIZE );
+        tail    = (( size - head ) & ( FLASH_ROW_SIZE - 1U ));
+
+        #if ( 1 == FLASH_CFG_BATCH_EN )
+            status = flash_batch_sync( addr, size );
+        #endif
+
+        if (( head > 0U ) && ( eFLASH_OK == status ))
+        {
+            status = flash_program( addr, head, (const uint8_t*) row );
+        }
+
+        for ( uint32_t r = 0U; ( r < row_num ) && ( eFLASH_OK == status ); r++ )
+        {
+            const uint32_t  row_addr    = ( addr + head + ( r * FLASH_ROW_SIZE ));
+            bool            is_blank    = false;
+
+            #if ( 1 == FLASH_CFG_FAST_PROGRAM_EN )
+
+                // Fast programming requires erased row
+                is_blank = true;
+
+                for ( uint32_t unit = 0U; ( unit < ( FLASH_ROW_SIZE / FLASH_PROG_SIZE )) && ( true == is_blank ); unit++ )
+                {
+                    is_blank = flash_unit_is_blank( row_addr + ( unit * FLASH_PROG_SIZE ));
+                }
+
+            #endif
+
+            status = flash_program_sel( row_addr, FLASH_ROW_SIZE, (const uint8_t*) row, is_blank );
+        }
+
+        if (( tail > 0U ) && ( eFLASH_OK == status ))
+        {
+            status = flash_program(( addr + size ) - tail, tail, (const uint8_t*) row );
+        }
+
+        flash_unlock();
+    }
+    else if ( false == flash_is_in_region( addr, size ))
+    {
+        status = eFLASH_ERROR_RANGE;
+    }
+    else if ( 0U != ( addr & ( FLASH_PROG_SIZE - 1U )))
+    {
+        status = eFLASH_ERROR_ALIGN;
+    }
+    else
+    {
+        status = flash_lock_error();
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Find first erased program unit in flash range
+*
+* @note     With is_monotonic set range is treated as append-only log and
+*           searched with logarithmic number of probes.
+*
+* @param[in]    addr            - Start address, program unit aligned
+* @param[in]    size            - Size of range in bytes, multiple of program unit
+* @param[in]    is_monotonic    - Range is append-only, written units precede erased units
+* @param[out]   p_addr          - Address of first erased unit, FLASH_FIND_NONE if range is full
+* @return       status          - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_find_first_blank(const uint32_t addr, const uint32_t size, const bool is_monotonic, uint32_t * const p_addr)
+{
+    flash_status_t status = flash_find_prepare( addr, size, FLASH_PROG_SIZE, p_addr );
+
+    if ( eFLASH_OK == status )
+    {
+        #if ( 1 == FLASH_CFG_ECC_EN )
+            const uint32_t ecc_uncorr_num = g_flash_stats.ecc_uncorr_num;
+        #endif
+
+        const uint32_t unit_num = ( size / FLASH_PROG_SIZE );
+        const uint32_t unit     = flash_find_blank( addr, unit_num, is_monotonic );
+
+        *p_addr = (( unit < unit_num ) ? ( addr + ( unit * FLASH_PROG_SIZE )) : FLASH_FIND_NONE );
+
+        #if ( 1 == FLASH_CFG_ECC_EN )
+
+            // Uncorrectable error reported by NMI during search
+            if ( ecc_uncorr_num != g_flash_stats.ecc_uncorr_num )
+            {
+                status = eFLASH_ERROR_ECC;
+            }
+
+        #endif
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Find last written program unit in flash range
+*
+* @note     With is_monotonic set range is treated as append-only log and
+*           searched with logarithmic number of probes. Otherwise range is
+*           scanned backwards from its end.
+*
+* @param[in]    addr            - Start address, program unit aligned
+* @param[in]    size            - Size of range in bytes, multiple of program unit
+* @param[in]    is_monotonic    - Range is append-only, written units precede erased units
+* @param[out]   p_addr          - Address of last written unit, FLASH_FIND_NONE if range is erased
+* @return       status          - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_find_last_written(const uint32_t addr, const uint32_t size, const bool is_monotonic, uint32_t * const p_addr)
+{
+    flash_status_t status = flash_find_prepare( addr, size, FLASH_PROG_SIZE, p_addr );
+
+    if ( eFLASH_OK == status )
+    {
+        #if ( 1 == FLASH_CFG_ECC_EN )
+            const uint32_t ecc_uncorr_num = g_flash_stats.ecc_uncorr_num;
+        #endif
+
+        uint32_t unit = ( size / FLASH_PROG_SIZE );
+
+        if ( true == is_monotonic )
+        {
+            // Unit preceding first erased unit
+            unit = flash_find_blank( addr, unit, true );
+        }
+        else
+        {
+            while (( unit > 0U ) && ( true == flash_unit_is_blank( addr + (( unit - 1U ) * FLASH_PROG_SIZE ))))
+            {
+                unit--;
+            }
+        }
+
+        *p_addr = (( unit > 0U ) ? ( addr + (( unit - 1U ) * FLASH_PROG_SIZE )) : FLASH_FIND_NONE );
+
+        #if ( 1 == FLASH_CFG_ECC_EN )
+
+            // Uncorrectable error reported by NMI during search
+            if ( ecc_uncorr_num != g_flash_stats.ecc_uncorr_num )
+            {
+                status = eFLASH_ERROR_ECC;
+            }
+
+        #endif
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Find first double word matching pattern in flash range
+*
+* @note     Double word aligned positions are compared, two word loads per
+*           position.
+*
+* @param[in]    addr        - Start address, double word aligned
+* @param[in]    size        - Size of range in bytes, multiple of double word
+* @param[in]    pattern     - Searched double word, e.g. magic marker
+* @param[out]   p_addr      - Address of first match, FLASH_FIND_NONE if not found
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_find_pattern(const uint32_t addr, const uint32_t size, const uint64_t pattern, uint32_t * const p_addr)
+{
+    flash_status_t status = flash_find_prepare( addr, size, sizeof( uint64_t ), p_addr );
+
+    if ( eFLASH_OK == status )
+    {
+        #if ( 1 == FLASH_CFG_ECC_EN )
+            const uint32_t ecc_uncorr_num = g_flash_stats.ecc_uncorr_num;
+        #endif
+
+        const uint32_t  lo      = (uint32_t) pattern;
+        const uint32_t  hi      = (uint32_t)( pattern >> 32U );
+        uint32_t        offset  = 0U;
+
+        *p_addr = FLASH_FIND_NONE;
+
+        while ( offset < size )
+        {
+            const volatile uint32_t * const p_word = (const volatile uint32_t *) flash_mem_addr( addr + offset );
+
+            if ( 0U == (( p_word[0] ^ lo ) | ( p_word[1] ^ hi )))
+            {
+                *p_addr = ( addr + offset );
+                break;
+            }
+
+            offset += sizeof( uint64_t );
+        }
+
+        #if ( 1 == FLASH_CFG_ECC_EN )
+
+            // Uncorrectable error reported by NMI during search
+            if ( ecc_uncorr_num != g_flash_stats.ecc_uncorr_num )
+            {
+                status = eFLASH_ERROR_ECC;
+            }
+
+        #endif
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Compare flash content against RAM buffer
+*
+* @note     Compared directly from memory mapped flash without copy, stops
+*           at first difference.
+*
+* @param[in]    addr        - Flash address
+* @param[in]    size        - Size to compare in bytes
+* @param[in]    p_data      - RAM data
+* @param[out]   p_offset    - Offset of first mismatching byte, FLASH_FIND_NONE if equal
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_compare(const uint32_t addr, const uint32_t size, const uint8_t * const p_data, uint32_t * const p_offset)
+{
+    flash_status_t status = flash_find_prepare( addr, size, 1U, p_offset );
+
+    FLASH_ASSERT( NULL != p_data );
+
+    if (( eFLASH_OK == status ) && ( NULL == p_data ))
+    {
+        status = eFLASH_ERROR;
+    }
+
+    if ( eFLASH_OK == status )
+    {
+        #if ( 1 == FLASH_CFG_ECC_EN )
+            const uint32_t ecc_uncorr_num = g_flash_stats.ecc_uncorr_num;
+        #endif
+
+        uint32_t offset = 0U;
+
+        *p_offset = FLASH_FIND_NONE;
+
+        // Page by page, relocated pages are not contiguous
+        while ( offset < size )
+        {
+            const uint32_t page_left    = ( FLASH_CFG_PAGE_SIZE_BYTE - (( addr + offset ) & FLASH_PAGE_MASK ));
+            const uint32_t chunk        = ((( size - offset ) < page_left ) ? ( size - offset ) : page_left );
+            const uint32_t diff         = flash_compare_mem( flash_mem_addr( addr + offset ), chunk, &p_data[offset] );
+
+            if ( diff < chunk )
+            {
+                *p_offset = ( offset + diff );
+                break;
+            }
+
+            offset += chunk;
+        }
+
+        #if ( 1 == FLASH_CFG_ECC_EN )
+
+            // Uncorrectable error reported by NMI during compare
+            if ( ecc_uncorr_num != g_flash_stats.ecc_uncorr_num )
+            {
+                status = eFLASH_ERROR_ECC;
+            }
+
+        #endif
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Erase data from flash
+*
+* @param[in]    addr        - Flash address
+* @param[in]    size        - Size of data to read in bytes
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_erase(const uint32_t addr, const uint32_t size)
+{
+    flash_status_t          status                      = eFLASH_OK;
+    FLASH_EraseInitTypeDef  job[eFLASH_BANK_NUM_OF]     = {0};
+    uint8_t                 job_num                     = 0U;
+
+    FLASH_ASSERT( true == gb_is_init );
+    FLASH_ASSERT( true == flash_is_in_region( addr, size ));
+
+    if  (   ( true == gb_is_init )
+        &&  ( true == flash_is_in_region( addr, size ))
+        &&  ( eFLASH_OK == flash_lock()))
+    {
+        job_num = flash_erase_plan( addr, size, job );
+
+        #if ( 1 == FLASH_CFG_BATCH_EN )
+            status = flash_batch_sync( addr, size );
+        #endif
+
+        if ( eFLASH_OK == status )
+        {
+            status = flash_erase_execute( job, job_num );
+        }
+
+        #if (( 1 == FLASH_CFG_ECC_EN ) && ( 1 == FLASH_CFG_ECC_REMAP_EN ))
+
+            // Erase spares of relocated pages
+            if ( eFLASH_OK == status )
+            {
+                status = flash_ecc_erase_remapped( addr, size );
+            }
+
+        #endif
+
+        flash_unlock();
+    }
+    else
+    {
+        status = (( false == flash_is_in_region( addr, size )) ? eFLASH_ERROR_RANGE : flash_lock_error());
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Erase complete flash bank
+*
+* @note     Bank is erased with single mass erase operation instead of
+*           erasing it page by page. In single-bank mode whole flash is
+*           erased, therefore only eFLASH_BANK_1 is valid.
+*
+* @note     Bank must be completely inside user flash region, otherwise
+*           request is rejected in order to protect application code!
+*
+* @param[in]    bank        - Flash bank to erase
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_erase_bank(const flash_bank_t bank)
+{
+    flash_status_t          status      = eFLASH_OK;
+    FLASH_EraseInitTypeDef  job         = {0};
+    uint32_t                bank_addr   = 0U;
+    uint32_t                bank_size   = 0U;
+
+    FLASH_ASSERT( true == gb_is_init );
+    FLASH_ASSERT( bank < (( true == g_flash_geo.is_dual_bank ) ? eFLASH_BANK_NUM_OF : 1U ));
+
+    if  (   ( true == gb_is_init )
+        &&  ( bank < (( true == g_flash_geo.is_dual_bank ) ? eFLASH_BANK_NUM_OF : 1U ))
+        &&  ( eFLASH_OK == flash_lock()))
+    {
+        flash_get_bank_region( bank, &bank_addr, &bank_size );
+
+        // Bank must be part of user flash region
+        if ( true == flash_is_in_region( bank_addr, bank_size ))
+        {
+            // Setup flash mass erase
+            flash_job_set( &job, FLASH_TYPEERASE_MASSERASE, (( eFLASH_BANK_1 == bank ) ? FLASH_BANK_1 : FLASH_BANK_2 ), 0U, 0U );
+
+            #if ( 1 == FLASH_CFG_BATCH_EN )
+                status = flash_batch_sync( bank_addr, bank_size );
+            #endif
+
+            if ( eFLASH_OK == status )
+            {
+                status = flash_erase_execute( &job, 1U );
+            }
+
+            #if (( 1 == FLASH_CFG_ECC_EN ) && ( 1 == FLASH_CFG_ECC_REMAP_EN ))
+
+                // Erase spares of relocated pages
+                if ( eFLASH_OK == status )
+                {
+                    status = flash_ecc_erase_remapped( bank_addr, bank_size );
+                }
+
+            #endif
+        }
+        else
+        {
+            status = eFLASH_ERROR_RANGE;
+        }
+
+        flash_unlock();
+    }
+    else
+    {
+        status = flash_lock_error();
+    }
+
+    return status;
+}
+
+#if ( 1 == FLASH_CFG_ASYNC_ERASE_EN )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Start interrupt driven (non-blocking) erase
+    *
+    * @note     Erase of range across both banks is scheduled as chain of
+    *           bank jobs started one after another from flash interrupt.
+    *           If both banks are erased completely they are erased in
+    *           parallel with single operation.
+    *
+    * @note     Completion callback is called from interrupt context!
+    *
+    * @param[in]    addr        - Flash address
+    * @param[in]    size        - Size of data to erase in bytes
+    * @param[in]    pf_done     - Completion callback, can be NULL
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_erase_async(const uint32_t addr, const uint32_t size, pf_flash_erase_cb_t pf_done)
+    {
+        flash_status_t          status                      = eFLASH_OK;
+        FLASH_EraseInitTypeDef  job[eFLASH_BANK_NUM_OF]     = {0};
+        uint8_t                 job_num                     = 0U;
+
+        FLASH_ASSERT( true == gb_is_init );
+        FLASH_ASSERT( true == flash_is_in_region( addr, size ));
+
+        if  (   ( true == gb_is_init )
+            &&  ( true == flash_is_in_region( addr, size ))
+            &&  ( eFLASH_OK == flash_lock()))
+        {
+            job_num = flash_erase_plan( addr, size, job );
+
+            #if ( 1 == FLASH_CFG_BATCH_EN )
+                status = flash_batch_sync( addr, size );
+            #endif
+
+            #if (( 1 == FLASH_CFG_ECC_EN ) && ( 1 == FLASH_CFG_ECC_REMAP_EN ))
+
+                // Spares of relocated pages are erased upfront
+                if ( eFLASH_OK == status )
+                {
+                    status = flash_ecc_erase_remapped( addr, size );
+                }
+
+            #endif
+
+            if ( eFLASH_OK == status )
+            {
+                status = flash_async_start( job, job_num, pf_done );
+            }
+
+            flash_unlock();
+        }
+        else
+        {
+            status = (( false == flash_is_in_region( addr, size )) ? eFLASH_ERROR_RANGE : flash_lock_error());
+        }
+
+        return status;
+    }
+
+#endif // ( 1 == FLASH_CFG_ASYNC_ERASE_EN )
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Get flash busy state
+*
+* @note     Only interrupt driven erase keeps flash busy after API returns.
+*
+* @param[out]   p_is_busy   - Pointer to busy flag
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_is_busy(bool * const p_is_busy)
+{
+    flash_status_t status = eFLASH_OK;
+
+    FLASH_ASSERT( NULL != p_is_busy );
+
+    if ( NULL != p_is_busy )
+    {
+        *p_is_busy = flash_is_busy_internal();
+    }
+    else
+    {
+        status = eFLASH_ERROR;
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Get flash statistics
+*
+* @param[out]   p_stats     - Pointer to statistics
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_get_stats(flash_stats_t * const p_stats)
+{
+    flash_status_t status = eFLASH_OK;
+
+    FLASH_ASSERT( NULL != p_stats );
+
+    if ( NULL != p_stats )
+    {
+        *p_stats = g_flash_stats;
+
+        #if ( 1 == FLASH_CFG_SCHED_EN )
+            p_stats->sched_drop_num = atomic_load_explicit( &g_flash_sched_drop_num, memory_order_relaxed );
+        #endif
+    }
+    else
+    {
+        status = eFLASH_ERROR;
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Get details of last failed flash operation
+*
+* @note     Failing address and HAL page/sector error are kept until next
+*           failed operation.
+*
+* @param[out]   p_error     - Last flash error
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_get_error(flash_error_t * const p_error)
+{
+    flash_status_t status = eFLASH_OK;
+
+    FLASH_ASSERT( NULL != p_error );
+
+    if ( NULL != p_error )
+    {
+        *p_error = g_flash_error;
+    }
+    else
+    {
+        status = eFLASH_ERROR;
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Get flash accelerator settings
+*
+* @param[out]   p_accel     - Accelerator settings
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_accel_get(flash_accel_t * const p_accel)
+{
+    flash_status_t status = eFLASH_OK;
+
+    FLASH_ASSERT( NULL != p_accel );
+
+    if ( NULL != p_accel )
+    {
+        #if ( FLASH_CFG_FAMILY_H7 != FLASH_CFG_FAMILY )
+
+            p_accel->icache_en      = ( 0U != READ_BIT( FLASH->ACR, FLASH_ACR_ICEN ));
+            p_accel->prefetch_en    = ( 0U != READ_BIT( FLASH->ACR, FLASH_ACR_PRFTEN ));
+
+            #if defined( FLASH_ACR_DCEN )
+                p_accel->dcache_en  = ( 0U != READ_BIT( FLASH->ACR, FLASH_ACR_DCEN ));
+            #else
+                p_accel->dcache_en  = false;
+            #endif
+
+        #else
+
+            p_accel->icache_en      = ( 0U != ( SCB->CCR & SCB_CCR_IC_Msk ));
+            p_accel->dcache_en      = ( 0U != ( SCB->CCR & SCB_CCR_DC_Msk ));
+            p_accel->prefetch_en    = false;
+
+        #endif
+
+        p_accel->latency = __HAL_FLASH_GET_LATENCY();
+    }
+    else
+    {
+        status = eFLASH_ERROR;
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Set flash accelerator settings
+*
+* @note     Caches are reset when enabled. Latency must suit current HCLK,
+*           raise it before increasing clock and lower it afterwards!
+*
+*           G0 has no data cache, H7 has no prefetch and uses core caches.
+*
+* @param[in]    p_accel     - Accelerator settings
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_accel_set(const flash_accel_t * const p_accel)
+{
+    flash_status_t status = eFLASH_OK;
+
+    FLASH_ASSERT( true == gb_is_init );
+    FLASH_ASSERT( NULL != p_accel );
+    FLASH_ASSERT( p_accel->latency <= ( FLASH_ACR_LATENCY >> FLASH_ACR_LATENCY_Pos ));
+
+    if  (   ( true == gb_is_init )
+        &&  ( NULL != p_accel )
+        &&  ( p_accel->latency <= ( FLASH_ACR_LATENCY >> FLASH_ACR_LATENCY_Pos ))
+        &&  ( eFLASH_OK == flash_lock()))
+    {
+        __HAL_FLASH_SET_LATENCY( p_accel->latency << FLASH_ACR_LATENCY_Pos );
+
+        // New latency must be in effect before continuing
+        if (( p_accel->latency << FLASH_ACR_LATENCY_Pos ) != __HAL_FLASH_GET_LATENCY())
+        {
+            status = eFLASH_ERROR;
+        }
+
+        #if ( FLASH_CFG_FAMILY_H7 != FLASH_CFG_FAMILY )
+
+            __HAL_FLASH_INSTRUCTION_CACHE_DISABLE();
+            __HAL_FLASH_INSTRUCTION_CACHE_RESET();
+
+            if ( true == p_accel->icache_en )
+            {
+                __HAL_FLASH_INSTRUCTION_CACHE_ENABLE();
+            }
+
+            #if defined( FLASH_ACR_DCEN )
+
+                __HAL_FLASH_DATA_CACHE_DISABLE();
+                __HAL_FLASH_DATA_CACHE_RESET();
+
+                if ( true == p_accel->dcache_en )
+                {
+                    __HAL_FLASH_DATA_CACHE_ENABLE();
+                }
+
+            #endif
+
+            if ( true == p_accel->prefetch_en )
+            {
+                __HAL_FLASH_PREFETCH_BUFFER_ENABLE();
+            }
+            else
+            {
+                __HAL_FLASH_PREFETCH_BUFFER_DISABLE();
+            }
+
+        #else
+
+            // Core caches, enable invalidates them
+            if ( true == p_accel->icache_en )
+            {
+                SCB_EnableICache();
+            }
+            else
+            {
+                SCB_DisableICache();
+            }
+
+            if ( true == p_accel->dcache_en )
+            {
+                SCB_EnableDCache();
+            }
+            else
+            {
+                SCB_DisableDCache();
+            }
+
+        #endif
+
+        flash_unlock();
+    }
+    else
+    {
+        status = flash_lock_error();
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Get flash geometry detected at initialization
+*
+* @param[out]   p_geo       - Flash geometry
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_get_geometry(flash_geometry_t * const p_geo)
+{
+    flash_status_t status = eFLASH_OK;
+
+    FLASH_ASSERT( true == gb_is_init );
+    FLASH_ASSERT( NULL != p_geo );
+
+    if  (   ( true == gb_is_init )
+        &&  ( NULL != p_geo ))
+    {
+        *p_geo = g_flash_geo;
+    }
+    else
+    {
+        status = eFLASH_ERROR;
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Get bank mode configured in option bytes
+*
+* @note     Configured mode becomes active after next reset, active mode is
+*           reported by flash_get_geometry().
+*
+* @param[out]   p_is_dual   - Dual-bank mode configured
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_bank_mode_get(bool * const p_is_dual)
+{
+    flash_status_t status = eFLASH_OK;
+
+    FLASH_ASSERT( true == gb_is_init );
+    FLASH_ASSERT( NULL != p_is_dual );
+
+    if  (   ( true == gb_is_init )
+        &&  ( NULL != p_is_dual ))
+    {
+        #if ( 1 == FLASH_BANK_MODE_SUPPORTED )
+            *p_is_dual = ( 0U != READ_BIT( FLASH->OPTR, FLASH_OPTR_DBANK ));
+        #else
+            *p_is_dual = g_flash_geo.is_dual_bank;
+        #endif
+    }
+    else
+    {
+        status = eFLASH_ERROR;
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/*!
+* @brief        Switch between dual-bank and single bank mode
+*
+* @note     Programs DBANK option bit and reloads option bytes, which resets
+*           the device. Page size and bank split follow new mode at next
+*           flash_init(). Data organization of whole flash changes, flash
+*           content must be reprogrammed in new mode!
+*
+* @note     Rejected while erase is in progress or firmware runs from
+*           bank 2. Nothing is done if mode is already configured.
+*
+* @param[in]    is_dual     - Dual-bank (2 kB pages) or single bank (4 kB pages) mode
+* @return       status      - Status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+flash_status_t flash_bank_mode_set(const bool is_dual)
+{
+    flash_status_t status = eFLASH_OK;
+
+    FLASH_ASSERT( true == gb_is_init );
+
+    if  (   ( true == gb_is_init )
+        &&  ( eFLASH_OK == flash_lock()))
+    {
+        #if ( 1 == FLASH_BANK_MODE_SUPPORTED )
+
+            FLASH_OBProgramInitTypeDef ob = {0};
+
+            // Mode already configured
+            if ( is_dual == ( 0U != READ_BIT( FLASH->OPTR, FLASH_OPTR_DBANK )))
+            {
+                // No actions...
+            }
+
+            // Running bank must survive mode change
+            else if (   ( true == flash_is_busy_internal())
+                    ||  ( true == flash_bank_is_running_bank2()))
+            {
+                status = eFLASH_ERROR;
+            }
+            else
+            {
+                #if ( 1 == FLASH_CFG_BATCH_EN )
+
+                    // Staged data would be lost by reset
+                    status = flash_batch_flush_internal();
+
+                #endif
+
+                if ( eFLASH_OK == status )
+                {
+                    ob.OptionType   = OPTIONBYTE_USER;
+                    ob.USERType     = OB_USER_DBANK;
+                    ob.USERConfig   = FLASH_OB_BANK_MODE( is_dual );
+
+                    if ( HAL_OK != HAL_FLASH_OB_Unlock())
+                    {
+                        status = eFLASH_ERROR;
+                    }
+                    else
+                    {
+                        const HAL_StatusTypeDef hal_status = HAL_FLASHEx_OBProgram( &ob );
+
+                        if ( HAL_OK != hal_status )
+                        {
+                            status = flash_error( hal_status, HAL_FLASH_GetError(), FLASH_BASE, 0xFFFFFFFFU );
+                        }
+
+                        // Reload option bytes, device resets
+                        else if ( HAL_OK != HAL_FLASH_OB_Launch())
+                        {
+                            status = eFLASH_ERROR;
+                        }
+                        else
+                        {
+                            // No actions...
+                        }
+
+                        (void) HAL_FLASH_OB_Lock();
+                    }
+                }
+            }
+
+        #else
+
+            (void) is_dual;
+
+            // No bank mode option bit on selected device
+            status = eFLASH_ERROR;
+
+        #endif
+
+        flash_unlock();
+    }
+    else
+    {
+        status = flash_lock_error();
+    }
+
+    return status;
+}
+
+#if ( 1 == FLASH_CFG_ECC_EN )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Handle flash ECC failure from NMI
+    *
+    * @note     Uncorrectable ECC errors raise NMI. Call from NMI_Handler,
+    *           application decides how to continue if error belongs
+    *           to flash.
+    *
+    * @param[out]   p_is_ecc    - NMI caused by flash ECC
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_ecc_nmi_hndl(bool * const p_is_ecc)
+    {
+        flash_status_t status = eFLASH_OK;
+
+        FLASH_ASSERT( NULL != p_is_ecc );
+
+        if ( NULL != p_is_ecc )
+        {
+            *p_is_ecc = ( 0U != READ_BIT( FLASH->ECCR, FLASH_ECCR_ECCD ));
+
+            if ( true == *p_is_ecc )
+            {
+                flash_ecc_isr();
+            }
+        }
+        else
+        {
+            status = eFLASH_ERROR;
+        }
+
+        return status;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Get ECC monitoring info
+    *
+    * @param[out]   p_info      - ECC info
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_ecc_get_info(flash_ecc_info_t * const p_info)
+    {
+        flash_status_t status = eFLASH_OK;
+
+        FLASH_ASSERT( NULL != p_info );
+
+        if ( NULL != p_info )
+        {
+            p_info->corr_addr   = g_flash_ecc.corr_addr;
+            p_info->uncorr_addr = g_flash_ecc.uncorr_addr;
+
+            #if ( 1 == FLASH_CFG_ECC_REMAP_EN )
+                p_info->remap_num = g_flash_ecc.map_num;
+            #else
+                p_info->remap_num = 0U;
+            #endif
+        }
+        else
+        {
+            status = eFLASH_ERROR;
+        }
+
+        return status;
+    }
+
+    #if ( 1 == FLASH_CFG_ECC_REMAP_EN )
+
+        ////////////////////////////////////////////////////////////////////////////////
+        /*!
+        * @brief        ECC relocation handler
+        *
+        * @note     Relocates page with corrected ECC error to spare page.
+        *           Call periodically from thread context, never from ISR.
+        *
+        * @return       status      - Status of operation
+        */
+        ////////////////////////////////////////////////////////////////////////////////
+        flash_status_t flash_ecc_hndl(void)
+        {
+            flash_status_t status = eFLASH_OK;
+
+            FLASH_ASSERT( true == gb_is_init );
+
+            if ( true == gb_is_init )
+            {
+                if  (   ( true == g_flash_ecc.is_pending )
+                    &&  ( eFLASH_OK == flash_lock()))
+                {
+                    status = flash_ecc_relocate( g_flash_ecc.pending_addr );
+
+                    // Allow next report
+                    g_flash_ecc.is_pending = false;
+
+                    flash_unlock();
+                }
+            }
+            else
+            {
+                status = eFLASH_ERROR;
+            }
+
+            return status;
+        }
+
+    #endif // ( 1 == FLASH_CFG_ECC_REMAP_EN )
+
+#endif // ( 1 == FLASH_CFG_ECC_EN )
+
+#if ( 1 == FLASH_CFG_ATOMIC_EN )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Power-loss safe update of atomic slot
+    *
+    * @note     New content is written to shadow page of slot and commit
+    *           marker is programmed last. Power loss at any point leaves
+    *           either old or new content committed.
+    *
+    * @param[in]    slot        - Atomic slot
+    * @param[in]    size        - Size of data in bytes, up to FLASH_ATOMIC_DATA_SIZE
+    * @param[in]    p_data      - Data to write
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_atomic_write(const uint32_t slot, const uint32_t size, const uint8_t * const p_data)
+    {
+        flash_status_t status = eFLASH_OK;
+
+        FLASH_ASSERT( true == gb_is_init );
+        FLASH_ASSERT( slot < FLASH_CFG_ATOMIC_SLOT_NUM );
+        FLASH_ASSERT( size <= FLASH_ATOMIC_DATA_SIZE );
+        FLASH_ASSERT( NULL != p_data );
+
+        if  (   ( true == gb_is_init )
+            &&  ( slot < FLASH_CFG_ATOMIC_SLOT_NUM )
+            &&  ( size <= FLASH_ATOMIC_DATA_SIZE )
+            &&  ( NULL != p_data )
+            &&  ( eFLASH_OK == flash_lock()))
+        {
+            const uint8_t   copy        = (( true == g_flash_atomic[slot].is_valid ) ? ( 1U - g_flash_atomic[slot].copy ) : 0U );
+            const uint32_t  page_addr   = FLASH_ATOMIC_PAGE_ADDR( slot, copy );
+            const uint32_t  seq         = (( true == g_flash_atomic[slot].is_valid ) ? ( g_flash_atomic[slot].seq + 1U ) : 1U );
+            uint32_t        commit[ FLASH_PROG_SIZE / 4U ];
+
+            #if ( 1 == FLASH_CFG_BATCH_EN )
+                status = flash_batch_sync( page_addr, FLASH_CFG_PAGE_SIZE_BYTE );
+            #endif
+
+            // Shadow page
+            if ( eFLASH_OK == status )
+            {
+                status = flash_atomic_page_erase( page_addr );
+            }
+
+            if ( eFLASH_OK == status )
+            {
+                status = flash_program( page_addr, size, p_data );
+            }
+
+            // Commit marker last
+            if ( eFLASH_OK == status )
+            {
+                memset( commit, 0xFF, sizeof( commit ));
+                commit[0] = seq;
+                commit[1] = ~seq;
+
+                status = flash_program( page_addr + FLASH_ATOMIC_COMMIT_OFFSET, FLASH_PROG_SIZE, (const uint8_t*) commit );
+            }
+
+            if ( eFLASH_OK == status )
+            {
+                g_flash_atomic[slot].seq        = seq;
+                g_flash_atomic[slot].copy       = copy;
+                g_flash_atomic[slot].is_valid   = true;
+
+                g_flash_stats.atomic_commit_num++;
+            }
+
+            flash_unlock();
+        }
+        else
+        {
+            status = flash_lock_error();
+        }
+
+        return status;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Read committed content of atomic slot
+    *
+    * @param[in]    slot        - Atomic slot
+    * @param[in]    size        - Size of data to read in bytes, up to FLASH_ATOMIC_DATA_SIZE
+    * @param[out]   p_data      - Read data
+    * @return       status      - Status of operation, error if slot was never written
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_atomic_read(const uint32_t slot, const uint32_t size, uint8_t * const p_data)
+    {
+        flash_status_t status = eFLASH_OK;
+
+        FLASH_ASSERT( true == gb_is_init );
+        FLASH_ASSERT( slot < FLASH_CFG_ATOMIC_SLOT_NUM );
+        FLASH_ASSERT( size <= FLASH_ATOMIC_DATA_SIZE );
+        FLASH_ASSERT( NULL != p_data );
+
+        if  (   ( true == gb_is_init )
+            &&  ( slot < FLASH_CFG_ATOMIC_SLOT_NUM )
+            &&  ( size <= FLASH_ATOMIC_DATA_SIZE )
+            &&  ( NULL != p_data )
+            &&  ( eFLASH_OK == flash_lock()))
+        {
+            if ( true == g_flash_atomic[slot].is_valid )
+            {
+                flash_read_internal( FLASH_ATOMIC_PAGE_ADDR( slot, g_flash_atomic[slot].copy ), size, p_data );
+            }
+            else
+            {
+                status = eFLASH_ERROR;
+            }
+
+            flash_unlock();
+        }
+        else
+        {
+            status = flash_lock_error();
+        }
+
+        return status;
+    }
+
+#endif // ( 1 == FLASH_CFG_ATOMIC_EN )
+
+#if ( 1 == FLASH_CFG_FAULT_INJECT_EN )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Arm power cut fault injection
+    *
+    * @note     After op_num program/erase units complete, next one is cut:
+    *           pf_cut is called while it is in progress. Callback shall
+    *           emulate power loss, e.g. by system reset. Cut points of
+    *           a scenario are counted by fault_op_num statistics.
+    *
+    * @param[in]    op_num      - Number of operations before cut
+    * @param[in]    pf_cut      - Power cut callback, NULL fails operation only
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_fault_arm(const uint32_t op_num, pf_flash_fault_cb_t pf_cut)
+    {
+        flash_status_t status = eFLASH_OK;
+
+        FLASH_ASSERT( true == gb_is_init );
+
+        if  (   ( true == gb_is_init )
+            &&  ( eFLASH_OK == flash_lock()))
+        {
+            g_flash_fault.op_num    = op_num;
+            g_flash_fault.pf_cut    = pf_cut;
+            g_flash_fault.is_armed  = true;
+
+            flash_unlock();
+        }
+        else
+        {
+            status = flash_lock_error();
+        }
+
+        return status;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Disarm power cut fault injection
+    *
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_fault_disarm(void)
+    {
+        flash_status_t status = eFLASH_OK;
+
+        FLASH_ASSERT( true == gb_is_init );
+
+        if  (   ( true == gb_is_init )
+            &&  ( eFLASH_OK == flash_lock()))
+        {
+            g_flash_fault.is_armed = false;
+
+            flash_unlock();
+        }
+        else
+        {
+            status = flash_lock_error();
+        }
+
+        return status;
+    }
+
+#endif // ( 1 == FLASH_CFG_FAULT_INJECT_EN )
+
+#if ( 1 == FLASH_CFG_LATENCY_EN )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Prepare wait states for clock change
+    *
+    * @note     Call before increasing HCLK or voltage range change. Latency
+    *           is only raised here, so flash stays accessible with both old
+    *           and new clock. Call flash_latency_tune() after clock change.
+    *
+    * @param[in]    hclk        - New HCLK frequency in Hz
+    * @param[in]    vrange      - New voltage range, PWR_REGULATOR_VOLTAGE_SCALEx
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_latency_prepare(const uint32_t hclk, const uint32_t vrange)
+    {
+        flash_status_t  status  = eFLASH_OK;
+        const uint32_t  latency = flash_latency_calc( hclk, vrange );
+
+        FLASH_ASSERT( true == gb_is_init );
+        FLASH_ASSERT( 0xFFFFFFFFU != latency );
+
+        if  (   ( true == gb_is_init )
+            &&  ( 0xFFFFFFFFU != latency )
+            &&  ( eFLASH_OK == flash_lock()))
+        {
+            if (( latency << FLASH_ACR_LATENCY_Pos ) > __HAL_FLASH_GET_LATENCY())
+            {
+                status = flash_latency_apply( latency );
+            }
+
+            flash_unlock();
+        }
+        else
+        {
+            status = flash_lock_error();
+        }
+
+        return status;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Set minimal wait states for current clock
+    *
+    * @note     Call after clock change, HCLK and voltage range are read
+    *           from HAL.
+    *
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_latency_tune(void)
+    {
+        flash_status_t  status  = eFLASH_OK;
+        const uint32_t  latency = flash_latency_calc( HAL_RCC_GetHCLKFreq(), HAL_PWREx_GetVoltageRange());
+
+        FLASH_ASSERT( true == gb_is_init );
+        FLASH_ASSERT( 0xFFFFFFFFU != latency );
+
+        if  (   ( true == gb_is_init )
+            &&  ( 0xFFFFFFFFU != latency )
+            &&  ( eFLASH_OK == flash_lock()))
+        {
+            status = flash_latency_apply( latency );
+
+            flash_unlock();
+        }
+        else
+        {
+            status = flash_lock_error();
+        }
+
+        return status;
+    }
+
+#endif // ( 1 == FLASH_CFG_LATENCY_EN )
+
+#if ( 1 == FLASH_CFG_POOL_EN )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Allocate pre-erased page from pool
+    *
+    * @note     Never waits for erase. If no pre-erased page is available
+    *           error is returned and caller shall retry after pool handler
+    *           has been executed.
+    *
+    * @param[out]   p_addr      - Start address of allocated page
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_pool_alloc(uint32_t * const p_addr)
+    {
+        flash_status_t status = eFLASH_ERROR;
+
+        FLASH_ASSERT( true == gb_is_init );
+        FLASH_ASSERT( NULL != p_addr );
+
+        if  (   ( true == gb_is_init )
+            &&  ( NULL != p_addr ))
+        {
+            // Pool access only, must not wait for erase in progress
+            flash_os_mutex_lock();
+
+            // Round-robin search for wear leveling
+            for ( uint32_t cnt = 0U; cnt < FLASH_CFG_POOL_PAGE_NUM; cnt++ )
+            {
+                const uint32_t page = g_flash_pool.alloc_idx;
+
+                g_flash_pool.alloc_idx = (( g_flash_pool.alloc_idx + 1U ) % FLASH_CFG_POOL_PAGE_NUM );
+
+                if ( eFLASH_POOL_PAGE_ERASED == g_flash_pool.state[page] )
+                {
+                    g_flash_pool.state[page] = eFLASH_POOL_PAGE_USED;
+
+                    *p_addr = flash_pool_page_addr( page );
+                    status = eFLASH_OK;
+                    break;
+                }
+            }
+
+            if ( eFLASH_OK != status )
+            {
+                g_flash_stats.pool_empty_num++;
+            }
+
+            flash_os_mutex_unlock();
+        }
+
+        return status;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Release page back to pool
+    *
+    * @note     Page is erased later by pool handler.
+    *
+    * @param[in]    addr        - Start address of page
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_pool_free(const uint32_t addr)
+    {
+        flash_status_t status = eFLASH_OK;
+
+        FLASH_ASSERT( true == gb_is_init );
+        FLASH_ASSERT( addr >= FLASH_CFG_POOL_START_ADDR );
+        FLASH_ASSERT( 0U == ( addr & FLASH_PAGE_MASK ));
+
+        if  (   ( true == gb_is_init )
+            &&  ( addr >= FLASH_CFG_POOL_START_ADDR )
+            &&  ( 0U == ( addr & FLASH_PAGE_MASK )))
+        {
+            const uint32_t page = (( addr - FLASH_CFG_POOL_START_ADDR ) >> FLASH_PAGE_SHIFT );
+
+            flash_os_mutex_lock();
+
+            if  (   ( page < FLASH_CFG_POOL_PAGE_NUM )
+                &&  ( eFLASH_POOL_PAGE_USED == g_flash_pool.state[page] ))
+            {
+                g_flash_pool.state[page] = eFLASH_POOL_PAGE_DIRTY;
+            }
+            else
+            {
+                status = eFLASH_ERROR;
+            }
+
+            flash_os_mutex_unlock();
+        }
+        else
+        {
+            status = eFLASH_ERROR;
+        }
+
+        return status;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Get number of pre-erased pages in pool
+    *
+    * @param[out]   p_num       - Number of pre-erased pages
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_pool_get_erased(uint32_t * const p_num)
+    {
+        flash_status_t status = eFLASH_OK;
+
+        FLASH_ASSERT( NULL != p_num );
+
+        if ( NULL != p_num )
+        {
+            *p_num = flash_pool_count_erased();
+        }
+        else
+        {
+            status = eFLASH_ERROR;
+        }
+
+        return status;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Pre-erased page pool handler
+    *
+    * @note     Shall be called from idle hook or low priority task. Erases
+    *           single released page per call until FLASH_CFG_POOL_PREERASE_NUM
+    *           pages are erased. With FLASH_CFG_ASYNC_ERASE_EN erase is
+    *           started in background and handler returns immediately.
+    *
+    * @note     In bare-metal configuration background erase locks flash,
+    *           other write and erase requests return eFLASH_ERROR_BUSY
+    *           until it completes.
+    *
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_pool_hndl(void)
+    {
+        flash_status_t status = eFLASH_OK;
+
+        FLASH_ASSERT( true == gb_is_init );
+
+        if ( true == gb_is_init )
+        {
+            if  (   ( flash_pool_count_erased() < FLASH_CFG_POOL_PREERASE_NUM )
+                &&  ( false == flash_is_busy_internal())
+                &&  ( eFLASH_OK == flash_lock()))
+            {
+                for ( uint32_t page = 0U; page < FLASH_CFG_POOL_PAGE_NUM; page++ )
+                {
+                    if ( eFLASH_POOL_PAGE_DIRTY == g_flash_pool.state[page] )
+                    {
+                        g_flash_pool.erase_idx      = page;
+                        g_flash_pool.state[page]    = eFLASH_POOL_PAGE_ERASING;
+
+                        #if ( 1 == FLASH_CFG_ASYNC_ERASE_EN )
+
+                            status = flash_erase_async( flash_pool_page_addr( page ), FLASH_CFG_PAGE_SIZE_BYTE, flash_pool_erase_done );
+
+                            if ( eFLASH_OK != status )
+                            {
+                                g_flash_pool.state[page] = eFLASH_POOL_PAGE_DIRTY;
+                            }
+
+                        #else
+
+                            status = flash_erase( flash_pool_page_addr( page ), FLASH_CFG_PAGE_SIZE_BYTE );
+
+                            flash_pool_erase_done( status );
+
+                        #endif
+
+                        break;
+                    }
+                }
+
+                flash_unlock();
+            }
+        }
+        else
+        {
+            status = eFLASH_ERROR;
+        }
+
+        return status;
+    }
+
+#endif // ( 1 == FLASH_CFG_POOL_EN )
+
+#if ( 1 == FLASH_CFG_RING_EN )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Post command to flash command ring
+    *
+    * @note     Lock-free, safe to call from interrupt context. There must be
+    *           only single producer context (e.g. one ISR or ISRs that
+    *           do not preempt each other).
+    *
+    * @note     Write data is not copied, thus it must stay valid until
+    *           command is processed by flash_ring_process!
+    *
+    * @param[in]    p_cmd       - Command descriptor
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_ring_post(const flash_cmd_t * const p_cmd)
+    {
+        flash_status_t status = eFLASH_OK;
+
+        FLASH_ASSERT( NULL != p_cmd );
+
+        if ( NULL != p_cmd )
+        {
+            const uint32_t head = atomic_load_explicit( &g_flash_ring.head, memory_order_relaxed );
+            const uint32_t tail = atomic_load_explicit( &g_flash_ring.tail, memory_order_acquire );
+
+            // Ring full
+            if (( head - tail ) >= FLASH_CFG_RING_SIZE )
+            {
+                g_flash_stats.ring_drop_num++;
+                status = eFLASH_ERROR;
+            }
+            else
+            {
+                g_flash_ring.cmd[ head & FLASH_RING_MASK ] = *p_cmd;
+
+                // Publish command to consumer
+                atomic_store_explicit( &g_flash_ring.head, ( head + 1U ), memory_order_release );
+            }
+        }
+        else
+        {
+            status = eFLASH_ERROR;
+        }
+
+        return status;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Process commands from flash command ring
+    *
+    * @note     Shall be called from single consumer context (flash service
+    *           task or main loop). Commands are executed in batch while
+    *           holding flash access for the whole batch.
+    *
+    * @param[in]    max_num     - Maximum number of commands to process
+    * @param[out]   p_num       - Number of processed commands, can be NULL
+    * @return       status      - Status of operation, error if any command failed
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_ring_process(const uint32_t max_num, uint32_t * const p_num)
+    {
+        flash_status_t  status  = eFLASH_OK;
+        uint32_t        num     = 0U;
+
+        FLASH_ASSERT( true == gb_is_init );
+
+        if  (   ( true == gb_is_init )
+            &&  ( eFLASH_OK == flash_lock()))
+        {
+            uint32_t        tail = atomic_load_explicit( &g_flash_ring.tail, memory_order_relaxed );
+            const uint32_t  head = atomic_load_explicit( &g_flash_ring.head, memory_order_acquire );
+
+            while (( tail != head ) && ( num < max_num ))
+            {
+                const flash_cmd_t * const p_cmd = &g_flash_ring.cmd[ tail & FLASH_RING_MASK ];
+
+                const flash_status_t cmd_status = (( eFLASH_CMD_WRITE == p_cmd->type ) ? flash_write( p_cmd->addr, p_cmd->size, p_cmd->p_data ) : flash_erase( p_cmd->addr, p_cmd->size ));
+
+                if ( eFLASH_OK != cmd_status )
+                {
+                    status = cmd_status;
+                }
+
+                tail++;
+                num++;
+
+                // Release slot to producer
+                atomic_store_explicit( &g_flash_ring.tail, tail, memory_order_release );
+            }
+
+            flash_unlock();
+        }
+        else
+        {
+            status = flash_lock_error();
+        }
+
+        if ( NULL != p_num )
+        {
+            *p_num = num;
+        }
+
+        return status;
+    }
+
+#endif // ( 1 == FLASH_CFG_RING_EN )
+
+#if ( 1 == FLASH_CFG_JOB_EN )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Get step budget clock
+    *
+    * @note     DWT cycles, microseconds derived from 1 ms SysTick on G0.
+    *
+    * @return       ticks       - Free running clock ticks
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static uint32_t flash_job_clock(void)
+    {
+        #if ( FLASH_CFG_FAMILY_G0 == FLASH_CFG_FAMILY )
+
+            uint32_t tick   = 0U;
+            uint32_t val    = 0U;
+
+            // Consistent tick and counter pair
+            do
+            {
+                tick    = HAL_GetTick();
+                val     = SysTick->VAL;
+            } while ( tick != HAL_GetTick());
+
+            return (( tick * 1000U ) + (uint32_t)(((uint64_t)( SysTick->LOAD - val ) * 1000U ) / ( SysTick->LOAD + 1U )));
+
+        #else
+
+            return DWT->CYCCNT;
+
+        #endif
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Get next step operation of job
+    *
+    * @note     Page erase, fast programmed row when aligned and enabled,
+    *           otherwise single program unit.
+    *
+    * @param[in]    p_job       - Job with remaining data
+    * @param[out]   pp_ticks    - Last measured duration of selected operation
+    * @return       chunk       - Size of operation in bytes
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static uint32_t flash_job_next(const flash_job_t * const p_job, uint32_t ** const pp_ticks)
+    {
+        const uint32_t  addr        = ( p_job->cmd.addr + p_job->offset );
+        const uint32_t  remaining   = ( p_job->cmd.size - p_job->offset );
+        uint32_t        chunk       = FLASH_PROG_SIZE;
+
+        *pp_ticks = &g_flash_job_ticks.unit;
+
+        if ( eFLASH_CMD_ERASE == p_job->cmd.type )
+        {
+            chunk       = ( g_flash_geo.page_size - ( addr & ( g_flash_geo.page_size - 1U )));
+            *pp_ticks   = &g_flash_job_ticks.page;
+        }
+
+        #if ( 1 == FLASH_CFG_FAST_PROGRAM_EN )
+            else if (( 0U == ( addr & ( FLASH_ROW_SIZE - 1U ))) && ( remaining >= FLASH_ROW_SIZE ))
+            {
+                chunk       = FLASH_ROW_SIZE;
+                *pp_ticks   = &g_flash_job_ticks.row;
+            }
+        #endif
+
+        else
+        {
+            // Single program unit
+        }
+
+        return (( remaining < chunk ) ? remaining : chunk );
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Execute next step operation of job
+    *
+    * @note     Flash access must be locked by caller.
+    *
+    * @param[in]    p_job       - Job with remaining data
+    * @param[in]    chunk       - Size of operation, from flash_job_next
+    * @param[out]   p_ticks     - Measured duration of operation
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static flash_status_t flash_job_exec(flash_job_t * const p_job, const uint32_t chunk, uint32_t * const p_ticks)
+    {
+        flash_status_t  status      = eFLASH_OK;
+        const uint32_t  addr        = ( p_job->cmd.addr + p_job->offset );
+        const uint32_t  op_start    = flash_job_clock();
+
+        if ( eFLASH_CMD_ERASE == p_job->cmd.type )
+        {
+            FLASH_EraseInitTypeDef  job[eFLASH_BANK_NUM_OF] = {0};
+            const uint8_t           job_num                 = flash_erase_plan( addr, chunk, job );
+
+            status = flash_erase_execute( job, job_num );
+
+            #if (( 1 == FLASH_CFG_ECC_EN ) && ( 1 == FLASH_CFG_ECC_REMAP_EN ))
+
+                // Erase spare of relocated page
+                if ( eFLASH_OK == status )
+                {
+                    status = flash_ecc_erase_remapped( addr, chunk );
+                }
+
+            #endif
+        }
+        else
+        {
+            status = flash_program( addr, chunk, &p_job->cmd.p_data[ p_job->offset ] );
+        }
+
+        *p_ticks = ( flash_job_clock() - op_start );
+
+        p_job->offset += chunk;
+
+        return status;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Start time budgeted write or erase job
+    *
+    * @note     Job is processed by flash_job_step() calls. Other flash
+    *           operations may run between steps.
+    *
+    * @param[in]    p_cmd       - Write or erase command, write data must stay valid until job is done
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_job_start(const flash_cmd_t * const p_cmd)
+    {
+        flash_status_t status = eFLASH_OK;
+
+        FLASH_ASSERT( true == gb_is_init );
+        FLASH_ASSERT( NULL != p_cmd );
+        FLASH_ASSERT( false == g_flash_job.is_active );
+
+        if  (   ( true == gb_is_init )
+            &&  ( NULL != p_cmd )
+            &&  ( false == g_flash_job.is_active )
+            &&  ( eFLASH_OK == flash_lock()))
+        {
+            if ( false == flash_is_in_region( p_cmd->addr, p_cmd->size ))
+            {
+                status = eFLASH_ERROR_RANGE;
+            }
+            else if (( eFLASH_CMD_WRITE == p_cmd->type ) && ( NULL == p_cmd->p_data ))
+            {
+                status = eFLASH_ERROR;
+            }
+            else
+            {
+                #if ( 1 == FLASH_CFG_BATCH_EN )
+                    status = flash_batch_sync( p_cmd->addr, p_cmd->size );
+                #endif
+
+                if ( eFLASH_OK == status )
+                {
+                    g_flash_job.cmd         = *p_cmd;
+                    g_flash_job.offset      = 0U;
+                    g_flash_job.is_active   = true;
+                }
+            }
+
+            flash_unlock();
+        }
+        else
+        {
+            status = flash_lock_error();
+        }
+
+        return status;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Process step job within time budget
+    *
+    * @note     Programs units or fast programmed rows, or erases pages, as
+    *           long as next operation fits into budget according to its
+    *           last measured duration. At least one operation is done per
+    *           step, so single page erase may exceed small budget.
+    *
+    * @note     Job ends on first error, error is returned.
+    *
+    * @param[in]    budget_us   - Time budget of step. Unit: us
+    * @param[out]   p_is_done   - Job completed or failed, may be NULL
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_job_step(const uint32_t budget_us, bool * const p_is_done)
+    {
+        flash_status_t status = eFLASH_OK;
+
+        FLASH_ASSERT( true == gb_is_init );
+
+        if  (   ( true == gb_is_init )
+            &&  ( eFLASH_OK == flash_lock()))
+        {
+            const uint32_t  start   = flash_job_clock();
+            const uint32_t  budget  = FLASH_JOB_US_TO_TICKS( budget_us );
+            uint32_t        op_num  = 0U;
+
+            while   (   ( true == g_flash_job.is_active )
+                    &&  ( g_flash_job.offset < g_flash_job.cmd.size )
+                    &&  ( eFLASH_OK == status ))
+            {
+                uint32_t *      p_ticks = NULL;
+                const uint32_t  chunk   = flash_job_next( &g_flash_job, &p_ticks );
+
+                // Budget exhausted
+                if  (   ( op_num > 0U )
+                    &&  ((( flash_job_clock() - start ) + *p_ticks ) > budget ))
+                {
+                    break;
+                }
+
+                status = flash_job_exec( &g_flash_job, chunk, p_ticks );
+                op_num++;
+            }
+
+            // Job completed or failed
+            if  (   ( g_flash_job.offset >= g_flash_job.cmd.size )
+                ||  ( eFLASH_OK != status ))
+            {
+                g_flash_job.is_active = false;
+            }
+
+            g_flash_stats.job_step_num++;
+
+            if (( flash_job_clock() - start ) > budget )
+            {
+                g_flash_stats.job_overrun_num++;
+            }
+
+            flash_unlock();
+        }
+        else
+        {
+            status = flash_lock_error();
+        }
 
-    FLASH_ASSERT( true == gb_is_init );
-    FLASH_ASSERT(( addr >= FLASH_CFG_START_ADDR ) && ( size <= FLASH_CFG_SIZE_BYTE ));
-    FLASH_ASSERT( NULL != p_data );
+        if ( NULL != p_is_done )
+        {
+            *p_is_done = ( false == g_flash_job.is_active );
+        }
 
-    if  (   ( true == gb_is_init )
-        &&  (( addr >= FLASH_CFG_START_ADDR ) && ( size <= FLASH_CFG_SIZE_BYTE ))
-        &&  ( NULL != p_data ))
+        return status;
+    }
+
+#endif // ( 1 == FLASH_CFG_JOB_EN )
+
+#if ( 1 == FLASH_CFG_SCHED_EN )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Get time since scheduler request submit
+    *
+    * @note     Step budget clock wraps after 25 s at 170 MHz, longer times
+    *           are taken from 1 ms system tick. Saturates at UINT32_MAX.
+    *
+    * @param[in]    p_slot      - Request
+    * @param[in]    now         - Current clock
+    * @param[in]    now_ms      - Current system tick
+    * @return       elapsed     - Time since submit. Unit: us
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static uint32_t flash_sched_elapsed_us(const flash_sched_slot_t * const p_slot, const uint32_t now, const uint32_t now_ms)
     {
-        // Write all double words - 64bit
-        for ( uint32_t dword = 0; dword < size; dword+=8U )
+        const uint32_t  elapsed_ms  = ( now_ms - p_slot->submit_ms );
+        uint32_t        elapsed     = 0U;
+
+        if ( elapsed_ms < FLASH_SCHED_FINE_MS )
+        {
+            elapsed = FLASH_JOB_TICKS_TO_US( now - p_slot->submit );
+        }
+        else
         {
-            // Calculate address
-            const uint32_t flash_addr = ( addr + dword );
+            elapsed = (( elapsed_ms > ( UINT32_MAX / 1000U )) ? UINT32_MAX : ( elapsed_ms * 1000U ));
+        }
+
+        return elapsed;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Pick most urgent pending scheduler request
+    *
+    * @note     Highest priority first. Within same priority requests with
+    *           deadline go before requests without one, earliest deadline
+    *           first, then in submit order.
+    *
+    * @param[in]    now         - Current clock
+    * @param[in]    now_ms      - Current system tick
+    * @return       p_slot      - Selected request, NULL if none pending
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static flash_sched_slot_t * flash_sched_pick(const uint32_t now, const uint32_t now_ms)
+    {
+        flash_sched_slot_t * p_best = NULL;
 
-            // Copy data
-            flash_data = 0UL;
-            memcpy( &flash_data, &p_data[dword], sizeof( uint64_t ));
+        for ( uint32_t i = 0; i < FLASH_CFG_SCHED_SIZE; i++ )
+        {
+            flash_sched_slot_t * const p_slot = &g_flash_sched[i];
 
-            // Program flash
-            if ( HAL_OK != HAL_FLASH_Program( FLASH_TYPEPROGRAM_DOUBLEWORD, flash_addr, flash_data ))
+            if ( eFLASH_SLOT_READY != atomic_load_explicit( &p_slot->state, memory_order_acquire ))
             {
-                status = eFLASH_ERROR;
-                break;
+                // Free or being filled
+            }
+            else if ( NULL == p_best )
+            {
+                p_best = p_slot;
+            }
+            else if ( p_slot->prio != p_best->prio )
+            {
+                p_best = (( p_slot->prio > p_best->prio ) ? p_slot : p_best );
+            }
+            else if ( p_slot->has_deadline != p_best->has_deadline )
+            {
+                p_best = (( true == p_slot->has_deadline ) ? p_slot : p_best );
+            }
+            else if ( true == p_slot->has_deadline )
+            {
+                // Remaining time, negative when already missed
+                const int64_t slot_left = ((int64_t) p_slot->deadline_us - flash_sched_elapsed_us( p_slot, now, now_ms ));
+                const int64_t best_left = ((int64_t) p_best->deadline_us - flash_sched_elapsed_us( p_best, now, now_ms ));
 
-                FLASH_ASSERT(0);
+                if ( slot_left != best_left )
+                {
+                    p_best = (( slot_left < best_left ) ? p_slot : p_best );
+                }
+                else
+                {
+                    p_best = ((( int32_t )( p_slot->seq - p_best->seq ) < 0 ) ? p_slot : p_best );
+                }
+            }
+            else
+            {
+                p_best = ((( int32_t )( p_slot->seq - p_best->seq ) < 0 ) ? p_slot : p_best );
             }
         }
+
+        return p_best;
     }
-    else
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /**
+    *       Complete scheduler request
+    *
+    * @note     Accounts latency and deadline statistics, releases slot and
+    *           reports status to requester.
+    *
+    * @param[in]    p_slot      - Completed request
+    * @param[in]    status      - Status of request
+    * @return       void
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    static void flash_sched_complete(flash_sched_slot_t * const p_slot, const flash_status_t status)
     {
-        status = eFLASH_ERROR;
-    }
+        const uint32_t              latency_us  = flash_sched_elapsed_us( p_slot, flash_job_clock(), HAL_GetTick());
+        const pf_flash_sched_cb_t   pf_done     = p_slot->pf_done;
 
-    return status;
-}
+        if ( latency_us > g_flash_stats.sched_latency_max_us[ p_slot->prio ] )
+        {
+            g_flash_stats.sched_latency_max_us[ p_slot->prio ] = latency_us;
+        }
 
-////////////////////////////////////////////////////////////////////////////////
-/*!
-* @brief        Read data from flash
-*
-* @param[in]    addr        - Flash address
-* @param[in]    size        - Size of data to read in bytes
-* @param[out]   p_data      - Data to write
-* @return       status      - Status of operation
-*/
-////////////////////////////////////////////////////////////////////////////////
-flash_status_t flash_read(const uint32_t addr, const uint32_t size, uint8_t * const p_data)
-{
-    flash_status_t status = eFLASH_OK;
+        if  (   ( true == p_slot->has_deadline )
+            &&  ( latency_us > p_slot->deadline_us ))
+        {
+            g_flash_stats.sched_miss_num++;
+        }
 
-    FLASH_ASSERT( true == gb_is_init );
-    FLASH_ASSERT(( addr >= FLASH_CFG_START_ADDR ) && ( size <= FLASH_CFG_SIZE_BYTE ));
-    FLASH_ASSERT( NULL != p_data );
+        // Release slot to producers
+        atomic_store_explicit( &p_slot->state, eFLASH_SLOT_FREE, memory_order_release );
 
-    if  (   ( true == gb_is_init )
-        &&  (( addr >= FLASH_CFG_START_ADDR ) && ( size <= FLASH_CFG_SIZE_BYTE ))
-        &&  ( NULL != p_data ))
+        if ( NULL != pf_done )
+        {
+            pf_done( status );
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Submit prioritized write or erase request to scheduler
+    *
+    * @note     Lock-free, does not wait for flash access. Safe to call from
+    *           any task or interrupt while flash_sched_process is running.
+    *
+    * @note     Write data is not copied, thus it must stay valid until
+    *           request completion callback!
+    *
+    * @param[in]    p_req       - Request descriptor
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_sched_submit(const flash_sched_req_t * const p_req)
     {
-        for ( uint32_t word = 0; word < size; word+=4U )
+        flash_status_t status = eFLASH_OK;
+
+        FLASH_ASSERT( true == gb_is_init );
+        FLASH_ASSERT( NULL != p_req );
+
+        if  (   ( true == gb_is_init )
+            &&  ( NULL != p_req )
+            &&  ( p_req->prio < eFLASH_PRIO_NUM_OF ))
         {
-            // Calculate flash address
-            const uint32_t flash_addr = (uint32_t) ( addr + word );
+            if ( false == flash_is_in_region( p_req->cmd.addr, p_req->cmd.size ))
+            {
+                status = eFLASH_ERROR_RANGE;
+            }
+            else if (( eFLASH_CMD_WRITE == p_req->cmd.type ) && ( NULL == p_req->cmd.p_data ))
+            {
+                status = eFLASH_ERROR;
+            }
+            else
+            {
+                flash_sched_slot_t * p_slot = NULL;
+
+                // Claim free slot
+                for ( uint32_t i = 0; ( i < FLASH_CFG_SCHED_SIZE ) && ( NULL == p_slot ); i++ )
+                {
+                    uint32_t expected = eFLASH_SLOT_FREE;
+
+                    if ( true == atomic_compare_exchange_strong_explicit( &g_flash_sched[i].state, &expected, eFLASH_SLOT_CLAIMED, memory_order_acquire, memory_order_relaxed ))
+                    {
+                        p_slot = &g_flash_sched[i];
+                    }
+                }
 
-            // Get flash data
-            const uint32_t flash_data = *(__IO uint32_t*)( flash_addr );
+                if ( NULL == p_slot )
+                {
+                    (void) atomic_fetch_add_explicit( &g_flash_sched_drop_num, 1U, memory_order_relaxed );
+                    status = eFLASH_ERROR;
+                }
+                else
+                {
+                    p_slot->job.cmd         = p_req->cmd;
+                    p_slot->job.offset      = 0U;
+                    p_slot->job.is_active   = false;
+                    p_slot->pf_done         = p_req->pf_done;
+                    p_slot->prio            = p_req->prio;
+                    p_slot->seq             = atomic_fetch_add_explicit( &g_flash_sched_seq, 1U, memory_order_relaxed );
+                    p_slot->submit          = flash_job_clock();
+                    p_slot->submit_ms       = HAL_GetTick();
+                    p_slot->deadline_us     = p_req->deadline_us;
+                    p_slot->has_deadline    = ( 0U != p_req->deadline_us );
 
-            // Copy data
-            memcpy( &p_data[word], &flash_data, 4U );
+                    // Publish request to scheduler
+                    atomic_store_explicit( &p_slot->state, eFLASH_SLOT_READY, memory_order_release );
+                }
+            }
+        }
+        else
+        {
+            status = eFLASH_ERROR;
         }
+
+        return status;
     }
-    else
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Process scheduled requests within time budget
+    *
+    * @note     Most urgent request is selected again before every page
+    *           erase, fast programmed row or program unit, thus newly
+    *           submitted urgent request waits at most one such operation
+    *           of lower priority request. Operations are done as long as
+    *           next one fits into budget according to its last measured
+    *           duration, at least one per call.
+    *
+    * @note     Shall be called from single consumer context (flash service
+    *           task or main loop). Completion callbacks are called from
+    *           this context while flash access is locked, thus they must
+    *           not call blocking flash functions.
+    *
+    * @note     Latency statistics include time between process calls.
+    *
+    * @param[in]    budget_us   - Time budget of call. Unit: us
+    * @param[out]   p_pending   - Number of pending requests, can be NULL
+    * @return       status      - Status of operation, error if any request failed
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_sched_process(const uint32_t budget_us, uint32_t * const p_pending)
     {
-        status = eFLASH_ERROR;
+        flash_status_t  status  = eFLASH_OK;
+        uint32_t        pending = 0U;
+
+        FLASH_ASSERT( true == gb_is_init );
+
+        if  (   ( true == gb_is_init )
+            &&  ( eFLASH_OK == flash_lock()))
+        {
+            const uint32_t  start   = flash_job_clock();
+            const uint32_t  budget  = FLASH_JOB_US_TO_TICKS( budget_us );
+            uint32_t        op_num  = 0U;
+            bool            is_over = false;
+
+            while ( false == is_over )
+            {
+                flash_sched_slot_t * const  p_slot      = flash_sched_pick( flash_job_clock(), HAL_GetTick());
+                flash_status_t              req_status  = eFLASH_OK;
+
+                if ( NULL == p_slot )
+                {
+                    is_over = true;
+                }
+                else if ( p_slot->job.offset < p_slot->job.cmd.size )
+                {
+                    uint32_t *      p_ticks = NULL;
+                    const uint32_t  chunk   = flash_job_next( &p_slot->job, &p_ticks );
+
+                    // Budget exhausted
+                    if  (   ( op_num > 0U )
+                        &&  ((( flash_job_clock() - start ) + *p_ticks ) > budget ))
+                    {
+                        is_over = true;
+                    }
+                    else
+                    {
+                        // First operation of request
+                        if ( false == p_slot->job.is_active )
+                        {
+                            const uint32_t wait_us = flash_sched_elapsed_us( p_slot, flash_job_clock(), HAL_GetTick());
+
+                            if ( wait_us > g_flash_stats.sched_wait_max_us[ p_slot->prio ] )
+                            {
+                                g_flash_stats.sched_wait_max_us[ p_slot->prio ] = wait_us;
+                            }
+
+                            p_slot->job.is_active = true;
+
+                            #if ( 1 == FLASH_CFG_BATCH_EN )
+                                req_status = flash_batch_sync( p_slot->job.cmd.addr, p_slot->job.cmd.size );
+                            #endif
+                        }
+
+                        if ( eFLASH_OK == req_status )
+                        {
+                            req_status = flash_job_exec( &p_slot->job, chunk, p_ticks );
+                        }
+
+                        op_num++;
+                    }
+                }
+                else
+                {
+                    // Empty request
+                }
+
+                // Request completed or failed
+                if  (   ( NULL != p_slot )
+                    &&  ( false == is_over )
+                    &&  (   ( p_slot->job.offset >= p_slot->job.cmd.size )
+                        ||  ( eFLASH_OK != req_status )))
+                {
+                    flash_sched_complete( p_slot, req_status );
+
+                    if ( eFLASH_OK != req_status )
+                    {
+                        status = req_status;
+                    }
+                }
+            }
+
+            flash_unlock();
+
+            for ( uint32_t i = 0; i < FLASH_CFG_SCHED_SIZE; i++ )
+            {
+                if ( eFLASH_SLOT_READY == atomic_load_explicit( &g_flash_sched[i].state, memory_order_relaxed ))
+                {
+                    pending++;
+                }
+            }
+        }
+        else
+        {
+            status = flash_lock_error();
+        }
+
+        if ( NULL != p_pending )
+        {
+            *p_pending = pending;
+        }
+
+        return status;
     }
 
-    return status;
-}
+#endif // ( 1 == FLASH_CFG_SCHED_EN )
 
-////////////////////////////////////////////////////////////////////////////////
-/*!
-* @brief        Erase data from flash
-*
-* @param[in]    addr        - Flash address
-* @param[in]    size        - Size of data to read in bytes
-* @return       status      - Status of operation
-*/
-////////////////////////////////////////////////////////////////////////////////
-flash_status_t flash_erase(const uint32_t addr, const uint32_t size)
-{
-    flash_status_t status = eFLASH_OK;
+#if ( 1 == FLASH_CFG_BATCH_EN )
 
-    FLASH_ASSERT( true == gb_is_init );
-    FLASH_ASSERT(( addr >= FLASH_CFG_START_ADDR ) && ( size <= FLASH_CFG_SIZE_BYTE ));
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Batched write to flash
+    *
+    * @note     Data is staged in RAM and merged with adjacent or overlapping
+    *           writes into the same row. Staged row is programmed when
+    *           completely filled (fast programming), when write targets
+    *           another row, on timeout (flash_batch_hndl) or explicitly
+    *           (flash_batch_flush).
+    *
+    * @note     Every program unit can be programmed only once after erase,
+    *           therefore data staged into already flushed program unit fails.
+    *
+    * @param[in]    addr        - Flash address
+    * @param[in]    size        - Size of data to write in bytes
+    * @param[in]    p_data      - Data to write
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_batch_write(const uint32_t addr, const uint32_t size, const uint8_t * const p_data)
+    {
+        flash_status_t  status  = eFLASH_OK;
+        uint32_t        offset  = 0U;
 
-    if  (   ( true == gb_is_init )
-        &&  (( addr >= FLASH_CFG_START_ADDR ) && ( size <= FLASH_CFG_SIZE_BYTE )))
+        FLASH_ASSERT( true == gb_is_init );
+        FLASH_ASSERT( true == flash_is_in_region( addr, size ));
+        FLASH_ASSERT( NULL != p_data );
+
+        if  (   ( true == gb_is_init )
+            &&  ( true == flash_is_in_region( addr, size ))
+            &&  ( NULL != p_data )
+            &&  ( eFLASH_OK == flash_lock()))
+        {
+            g_flash_stats.batch_write_num++;
+
+            while (( offset < size ) && ( eFLASH_OK == status ))
+            {
+                const uint32_t flash_addr   = ( addr + offset );
+                const uint32_t row_addr     = ( flash_addr & ~( FLASH_ROW_SIZE - 1U ));
+                const uint32_t row_offset   = ( flash_addr - row_addr );
+                const uint32_t chunk        = ((( size - offset ) < ( FLASH_ROW_SIZE - row_offset )) ? ( size - offset ) : ( FLASH_ROW_SIZE - row_offset ));
+
+                // Write to another row
+                if  (   ( true == g_flash_batch.is_used )
+                    &&  ( row_addr != g_flash_batch.addr ))
+                {
+                    status = flash_batch_flush_internal();
+                }
+
+                if ( eFLASH_OK == status )
+                {
+                    // Start new staging row
+                    if ( false == g_flash_batch.is_used )
+                    {
+                        memset( &g_flash_batch.row, 0xFF, sizeof( g_flash_batch.row ));
+                        memset( &g_flash_batch.byte_mask, 0U, sizeof( g_flash_batch.byte_mask ));
+
+                        g_flash_batch.addr      = row_addr;
+                        g_flash_batch.tick      = HAL_GetTick();
+                        g_flash_batch.is_used   = true;
+                    }
+
+                    // Stage data
+                    memcpy( &((uint8_t*) g_flash_batch.row )[row_offset], &p_data[offset], chunk );
+
+                    // Mark staged bytes
+                    for ( uint32_t byte = row_offset; byte < ( row_offset + chunk ); byte++ )
+                    {
+                        g_flash_batch.byte_mask[ byte / 8U ] |= (uint8_t)( 1U << ( byte % 8U ));
+                    }
+
+                    // Row completely staged
+                    if ( true == flash_batch_is_row_full())
+                    {
+                        status = flash_batch_flush_internal();
+                    }
+
+                    offset += chunk;
+                }
+            }
+
+            flash_unlock();
+        }
+        else
+        {
+            status = (( false == flash_is_in_region( addr, size )) ? eFLASH_ERROR_RANGE : flash_lock_error());
+        }
+
+        return status;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Flush batched writes to flash
+    *
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_batch_flush(void)
     {
-        #if ( 0 == FLASH_CFG_DUAL_BANK_MODE_EN )
+        flash_status_t status = eFLASH_OK;
 
-            // Single bank operation
-            status = flash_erase_single_bank( addr, size );
+        FLASH_ASSERT( true == gb_is_init );
 
-        #else
+        if  (   ( true == gb_is_init )
+            &&  ( eFLASH_OK == flash_lock()))
+        {
+            status = flash_batch_flush_internal();
 
-            // Dual-bank operation
-            status = flash_erase_dual_bank( addr, size );
+            flash_unlock();
+        }
+        else
+        {
+            status = flash_lock_error();
+        }
 
-        #endif
+        return status;
     }
-    else
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /*!
+    * @brief        Batched writes handler
+    *
+    * @note     Shall be called periodically. Flushes staged row after
+    *           FLASH_CFG_BATCH_TIMEOUT_MS from first staged write.
+    *
+    * @return       status      - Status of operation
+    */
+    ////////////////////////////////////////////////////////////////////////////////
+    flash_status_t flash_batch_hndl(void)
     {
-        status = eFLASH_ERROR;
+        flash_status_t status = eFLASH_OK;
+
+        FLASH_ASSERT( true == gb_is_init );
+
+        if ( true == gb_is_init )
+        {
+            if  (   ( true == g_flash_batch.is_used )
+                &&  (( HAL_GetTick() - g_flash_batch.tick ) >= FLASH_CFG_BATCH_TIMEOUT_MS ))
+            {
+                status = flash_batch_flush();
+            }
+        }
+        else
+        {
+            status = eFLASH_ERROR;
+        }
+
+        return status;
     }
 
-    return status;
-}
+#endif // ( 1 == FLASH_CFG_BATCH_EN )
 
 ////////////////////////////////////////////////////////////////////////////////
 /**
@@ -7,7 +7,7 @@
 *@author    Ziga Miklosic
 *@email		ziga.miklosic@gmail.si
 *@date      17.05.2023
-*@version   V0.1.0
+*@version   V0.2.0
 */
 ////////////////////////////////////////////////////////////////////////////////
 /**
@@ -27,6 +27,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "../../flash_cfg.h"
+
 ////////////////////////////////////////////////////////////////////////////////
 // Definitions
 ////////////////////////////////////////////////////////////////////////////////
@@ -35,18 +37,221 @@
  *  Module version
  */
 #define FLASH_VER_MAJOR          ( 0 )
-#define FLASH_VER_MINOR          ( 1 )
+#define FLASH_VER_MINOR          ( 2 )
 #define FLASH_VER_DEVELOP        ( 0 )
 
+/**
+ *  Compile time checked flash address
+ *
+ *  @note   Intended for constant addresses. Build fails if memory range
+ *          [addr, addr + size) is not inside user flash region.
+ */
+#define FLASH_ADDR(addr,size)    ((uint32_t)(addr) + ( 0U * sizeof( struct { int flash_addr_check : (((( addr ) >= FLASH_CFG_START_ADDR ) && ((( addr ) + ( size )) <= ( FLASH_CFG_START_ADDR + FLASH_CFG_SIZE_BYTE ))) ? 1 : -1 ); } )))
+
+/**
+ *  Search result when nothing is found
+ */
+#define FLASH_FIND_NONE          ( 0xFFFFFFFFU )
+
+#if ( 1 == FLASH_CFG_ATOMIC_EN )
+
+    /**
+     *  Usable data size of atomic slot
+     *
+     *  @note   Last 32 bytes of page are reserved for commit marker.
+     */
+    #define FLASH_ATOMIC_DATA_SIZE   ( FLASH_CFG_PAGE_SIZE_BYTE - 32U )
+
+#endif
+
 /**
  *  Flash status
  */
 typedef enum
 {
-    eFLASH_OK        = 0x00U,    /**<Normal operation */
-    eFLASH_ERROR     = 0x01U,    /**<General error code */
+    eFLASH_OK                   = 0x00U,    /**<Normal operation */
+    eFLASH_ERROR                = 0x01U,    /**<General error code */
+    eFLASH_ERROR_RANGE          = 0x02U,    /**<Memory range outside user flash region */
+    eFLASH_ERROR_ALIGN          = 0x03U,    /**<Programming alignment or size error */
+    eFLASH_ERROR_WRP            = 0x04U,    /**<Write protected area */
+    eFLASH_ERROR_NOT_ERASED     = 0x05U,    /**<Programming of not erased memory */
+    eFLASH_ERROR_SEQ            = 0x06U,    /**<Programming sequence error */
+    eFLASH_ERROR_ECC            = 0x07U,    /**<Uncorrectable ECC error */
+    eFLASH_ERROR_TIMEOUT        = 0x08U,    /**<Flash operation timeout */
+    eFLASH_ERROR_BUSY           = 0x09U,    /**<Flash busy with interrupt driven erase, bare-metal only */
+    eFLASH_ERROR_OVERLAP        = 0x0AU,    /**<Source and destination ranges overlap */
 } flash_status_t;
 
+/**
+ *  Details of last failed flash operation
+ */
+typedef struct
+{
+    flash_status_t  status;         /**<Status of failed operation */
+    uint32_t        addr;           /**<Failing address, program unit or start of erase unit */
+    uint32_t        sector_error;   /**<Failing page/sector reported by HAL erase, 0xFFFFFFFF otherwise */
+    uint32_t        hal_error;      /**<Raw HAL error flags */
+} flash_error_t;
+
+/**
+ *  ECC error information
+ */
+typedef struct
+{
+    uint32_t    corr_addr;      /**<Address of last corrected ECC error */
+    uint32_t    uncorr_addr;    /**<Address of last uncorrectable ECC error */
+    uint32_t    remap_num;      /**<Number of relocated pages in remap table */
+} flash_ecc_info_t;
+
+/**
+ *  Flash banks
+ *
+ *  @note   In single-bank mode whole flash is treated as bank 1!
+ */
+typedef enum
+{
+    eFLASH_BANK_1 = 0,      /**<Bank 1 */
+    eFLASH_BANK_2,          /**<Bank 2 - only in dual-bank mode */
+
+    eFLASH_BANK_NUM_OF
+} flash_bank_t;
+
+/**
+ *  Scheduler request priorities
+ */
+typedef enum
+{
+    eFLASH_PRIO_LOW = 0,    /**<Background work, e.g. firmware update */
+    eFLASH_PRIO_NORMAL,     /**<Regular data, e.g. configuration */
+    eFLASH_PRIO_HIGH,       /**<Urgent data, e.g. fault records */
+
+    eFLASH_PRIO_NUM_OF
+} flash_prio_t;
+
+/**
+ *  Flash statistics
+ */
+typedef struct
+{
+    uint32_t erase_page_num;        /**<Number of pages erased with page erase */
+    uint32_t erase_mass_num;        /**<Number of mass erase operations */
+    uint32_t erase_parallel_num;    /**<Number of mass erase operations erasing both banks in parallel */
+    uint32_t erase_async_num;       /**<Number of interrupt driven erase requests */
+    uint32_t erase_async_time_ms;   /**<Total duration of interrupt driven erases, CPU available meanwhile. Unit: ms */
+    uint32_t pool_empty_num;        /**<Number of pool allocations without pre-erased page available */
+    uint32_t ring_drop_num;         /**<Number of commands dropped due to full command ring */
+    uint32_t program_unit_num;      /**<Number of programmed units (double word, H7 flash word) */
+    uint32_t program_row_num;       /**<Number of rows programmed with fast programming */
+    uint32_t program_ll_num;        /**<Number of program units programmed by register level engine */
+    uint32_t program_fallback_num;  /**<Number of register level program runs completed by HAL after error */
+    uint32_t program_cycle_num;     /**<CPU cycles spent programming (FLASH_CFG_BENCHMARK_EN) */
+    uint32_t ecc_corr_num;          /**<Number of corrected (single bit) ECC errors */
+    uint32_t ecc_uncorr_num;        /**<Number of detected uncorrectable (double bit) ECC errors */
+    uint32_t ecc_remap_num;         /**<Number of pages relocated due to corrected ECC errors */
+    uint32_t atomic_commit_num;     /**<Number of committed atomic slot updates */
+    uint32_t fault_op_num;          /**<Number of operations passed fault injection point (FLASH_CFG_FAULT_INJECT_EN) */
+    uint32_t copy_skip_num;         /**<Number of rows skipped by flash copy, destination already matched */
+    uint32_t job_step_num;          /**<Number of step job steps */
+    uint32_t job_overrun_num;       /**<Number of step job steps exceeding time budget, single operation longer than budget */
+    uint32_t sched_drop_num;        /**<Number of scheduler requests rejected due to no free slot */
+    uint32_t sched_miss_num;        /**<Number of scheduler requests completed after their deadline */
+    uint32_t sched_wait_max_us[eFLASH_PRIO_NUM_OF];     /**<Worst-case time from request submit to its first operation, per priority. Unit: us */
+    uint32_t sched_latency_max_us[eFLASH_PRIO_NUM_OF];  /**<Worst-case time from request submit to its completion, per priority. Unit: us */
+    uint32_t batch_write_num;       /**<Number of batched write requests */
+    uint32_t batch_flush_num;       /**<Number of batched write flushes */
+} flash_stats_t;
+
+/**
+ *  Flash command types
+ */
+typedef enum
+{
+    eFLASH_CMD_WRITE = 0,   /**<Write command */
+    eFLASH_CMD_ERASE,       /**<Erase command */
+} flash_cmd_type_t;
+
+/**
+ *  Flash command descriptor
+ */
+typedef struct
+{
+    const uint8_t *     p_data; /**<Data to write, must stay valid until processed */
+    uint32_t            addr;   /**<Flash address */
+    uint32_t            size;   /**<Size in bytes */
+    flash_cmd_type_t    type;   /**<Command type */
+} flash_cmd_t;
+
+/**
+ *  I/O vector fragment
+ */
+typedef struct
+{
+    const uint8_t * p_data; /**<Fragment data */
+    uint32_t        size;   /**<Fragment size in bytes */
+} flash_iovec_t;
+
+/**
+ *  Read descriptor
+ */
+typedef struct
+{
+    uint32_t    addr;   /**<Flash address */
+    uint32_t    size;   /**<Size to read in bytes */
+    uint8_t *   p_data; /**<Destination buffer */
+} flash_read_desc_t;
+
+/**
+ *  Flash accelerator settings
+ */
+typedef struct
+{
+    bool        icache_en;      /**<Instruction cache enabled */
+    bool        dcache_en;      /**<Data cache enabled (not on G0) */
+    bool        prefetch_en;    /**<Prefetch enabled (not on H7) */
+    uint32_t    latency;        /**<Wait states */
+} flash_accel_t;
+
+/**
+ *  Flash geometry, detected at initialization
+ */
+typedef struct
+{
+    uint32_t    size;           /**<Total flash size in bytes */
+    uint32_t    bank_size;      /**<Size of single bank in bytes */
+    uint32_t    bank2_addr;     /**<Start address of bank 2, 0 in single bank mode */
+    uint32_t    page_size;      /**<Erase unit size in bytes */
+    uint32_t    page_num;       /**<Number of erase units per bank */
+    bool        is_dual_bank;   /**<Dual-bank mode active */
+} flash_geometry_t;
+
+/**
+ *  Erase completion callback
+ */
+typedef void (*pf_flash_erase_cb_t)(const flash_status_t status);
+
+/**
+ *  Scheduler request completion callback
+ */
+typedef void (*pf_flash_sched_cb_t)(const flash_status_t status);
+
+/**
+ *  Scheduler request
+ */
+typedef struct
+{
+    flash_cmd_t         cmd;            /**<Write or erase command */
+    pf_flash_sched_cb_t pf_done;        /**<Completion callback, can be NULL */
+    uint32_t            deadline_us;    /**<Deadline relative to submit, 0 for none, up to UINT32_MAX. Unit: us */
+    flash_prio_t        prio;           /**<Request priority */
+} flash_sched_req_t;
+
+/**
+ *  Fault injection power cut callback
+ *
+ *  @note   Called while flash operation at addr is in progress.
+ */
+typedef void (*pf_flash_fault_cb_t)(const uint32_t addr);
+
 ////////////////////////////////////////////////////////////////////////////////
 // Functions
 ////////////////////////////////////////////////////////////////////////////////
@@ -54,8 +259,81 @@ flash_status_t flash_init       (void);
 flash_status_t flash_deinit     (void);
 flash_status_t flash_is_init    (bool * const p_is_init);
 flash_status_t flash_write      (const uint32_t addr, const uint32_t size, const uint8_t * const p_data);
+flash_status_t flash_writev     (const uint32_t addr, const flash_iovec_t * const p_iov, const uint32_t count);
 flash_status_t flash_read       (const uint32_t addr, const uint32_t size, uint8_t * const p_data);
+flash_status_t flash_readv      (flash_read_desc_t * const p_desc, const uint32_t count);
+flash_status_t flash_copy       (const uint32_t dst, const uint32_t src, const uint32_t size);
+flash_status_t flash_fill       (const uint32_t addr, const uint32_t size, const uint64_t pattern);
+flash_status_t flash_find_first_blank   (const uint32_t addr, const uint32_t size, const bool is_monotonic, uint32_t * const p_addr);
+flash_status_t flash_find_last_written  (const uint32_t addr, const uint32_t size, const bool is_monotonic, uint32_t * const p_addr);
+flash_status_t flash_find_pattern       (const uint32_t addr, const uint32_t size, const uint64_t pattern, uint32_t * const p_addr);
+flash_status_t flash_compare            (const uint32_t addr, const uint32_t size, const uint8_t * const p_data, uint32_t * const p_offset);
 flash_status_t flash_erase      (const uint32_t addr, const uint32_t size);
+flash_status_t flash_erase_bank (const flash_bank_t bank);
+flash_status_t flash_is_busy    (bool * const p_is_busy);
+flash_status_t flash_get_stats  (flash_stats_t * const p_stats);
+flash_status_t flash_get_error  (flash_error_t * const p_error);
+flash_status_t flash_accel_get  (flash_accel_t * const p_accel);
+flash_status_t flash_accel_set  (const flash_accel_t * const p_accel);
+flash_status_t flash_get_geometry(flash_geometry_t * const p_geo);
+flash_status_t flash_bank_mode_get(bool * const p_is_dual);
+flash_status_t flash_bank_mode_set(const bool is_dual);
+
+#if ( 1 == FLASH_CFG_ASYNC_ERASE_EN )
+    flash_status_t flash_erase_async(const uint32_t addr, const uint32_t size, pf_flash_erase_cb_t pf_done);
+#endif
+
+#if ( 1 == FLASH_CFG_ECC_EN )
+    flash_status_t flash_ecc_nmi_hndl       (bool * const p_is_ecc);
+    flash_status_t flash_ecc_get_info       (flash_ecc_info_t * const p_info);
+
+    #if ( 1 == FLASH_CFG_ECC_REMAP_EN )
+        flash_status_t flash_ecc_hndl       (void);
+    #endif
+#endif
+
+#if ( 1 == FLASH_CFG_ATOMIC_EN )
+    flash_status_t flash_atomic_write       (const uint32_t slot, const uint32_t size, const uint8_t * const p_data);
+    flash_status_t flash_atomic_read        (const uint32_t slot, const uint32_t size, uint8_t * const p_data);
+#endif
+
+#if ( 1 == FLASH_CFG_FAULT_INJECT_EN )
+    flash_status_t flash_fault_arm          (const uint32_t op_num, pf_flash_fault_cb_t pf_cut);
+    flash_status_t flash_fault_disarm       (void);
+#endif
+
+#if ( 1 == FLASH_CFG_LATENCY_EN )
+    flash_status_t flash_latency_prepare    (const uint32_t hclk, const uint32_t vrange);
+    flash_status_t flash_latency_tune       (void);
+#endif
+
+#if ( 1 == FLASH_CFG_POOL_EN )
+    flash_status_t flash_pool_alloc         (uint32_t * const p_addr);
+    flash_status_t flash_pool_free          (const uint32_t addr);
+    flash_status_t flash_pool_get_erased    (uint32_t * const p_num);
+    flash_status_t flash_pool_hndl          (void);
+#endif
+
+#if ( 1 == FLASH_CFG_BATCH_EN )
+    flash_status_t flash_batch_write        (const uint32_t addr, const uint32_t size, const uint8_t * const p_data);
+    flash_status_t flash_batch_flush        (void);
+    flash_status_t flash_batch_hndl         (void);
+#endif
+
+#if ( 1 == FLASH_CFG_RING_EN )
+    flash_status_t flash_ring_post          (const flash_cmd_t * const p_cmd);
+    flash_status_t flash_ring_process       (const uint32_t max_num, uint32_t * const p_num);
+#endif
+
+#if ( 1 == FLASH_CFG_JOB_EN )
+    flash_status_t flash_job_start          (const flash_cmd_t * const p_cmd);
+    flash_status_t flash_job_step           (const uint32_t budget_us, bool * const p_is_done);
+#endif
+
+#if ( 1 == FLASH_CFG_SCHED_EN )
+    flash_status_t flash_sched_submit       (const flash_sched_req_t * const p_req);
+    flash_status_t flash_sched_process      (const uint32_t budget_us, uint32_t * const p_pending);
+#endif
 
 #endif // __FLASH_H
 
@@ -0,0 +1,1273 @@
+// Copyright (c) 2026  Ziga Miklosic
+// All Rights Reserved
+////////////////////////////////////////////////////////////////////////////////
+/**
+*@file      flash_sim.c
+*@brief     Host simulator of STM32G4 flash for driver tests
+*@author    Ziga Miklosic
+*@email		ziga.miklosic@gmail.si
+*@date      16.10.2026
+*@version   V0.2.0
+*/
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <signal.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "flash_sim.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+#include "cmsis_os2.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ *  System memory page holding flash size and UID
+ */
+#define FLASH_SIM_SYS_ADDR                  ( 0x1FFF0000UL )
+#define FLASH_SIM_SYS_SIZE                  ( 0x10000UL )
+
+/**
+ *  Test thread stack size
+ */
+#define FLASH_SIM_STACK_SIZE                ( 8U * 1024U * 1024U )
+
+/**
+ *  Number of status polls page erase keeps BSY set
+ */
+#define FLASH_SIM_ERASE_BUSY_POLLS          ( 3U )
+
+/**
+ *  Double words of flash array
+ */
+#define FLASH_SIM_DW_NUM                    ( FLASH_SIZE / sizeof( uint64_t ))
+
+/**
+ *  Offset of bank 2 in dual-bank mode
+ *
+ *  @note   Fixed for all device sizes (RM0440), smaller devices leave
+ *          gap after bank 1.
+ */
+#define FLASH_SIM_BANK2_OFFSET              ( 0x40000U )
+
+/**
+ *  Bank mode, category 2 device (FLASH_SIM_CAT2) is single bank only
+ */
+#if defined( FLASH_OPTR_DBANK )
+    #define FLASH_SIM_IS_DUAL()             ( 0U != ( g_sim_flash_regs.OPTR & FLASH_OPTR_DBANK ))
+    #define FLASH_SIM_SINGLE_PAGE_SIZE      ( FLASH_PAGE_SIZE_128_BITS )
+#else
+    #define FLASH_SIM_IS_DUAL()             ( false )
+    #define FLASH_SIM_SINGLE_PAGE_SIZE      ( FLASH_PAGE_SIZE )
+#endif
+
+/**
+ *  Host page size, granule of ECC trap
+ */
+#define FLASH_SIM_HOST_PAGE_SIZE            ( 4096U )
+
+/**
+ *  Trap flag of x86 EFLAGS, single steps faulting access
+ */
+#define FLASH_SIM_EFLAGS_TF                 ( 0x100U )
+
+/**
+ *  Simulated CPU cycles per operation
+ */
+#define FLASH_SIM_CYC_PROG                  ( 170U * 80U )
+#define FLASH_SIM_CYC_FAST                  ( 170U * 1500U )
+#define FLASH_SIM_CYC_ERASE                 ( 170U * 20000U )
+
+/**
+ *  State surviving power cut, shared between forked boots
+ */
+typedef struct
+{
+    uint8_t             corrupt[FLASH_SIM_DW_NUM / 8U];     /**<ECC corrupt double words */
+    flash_sim_stats_t   stats;                              /**<Operation counters */
+} flash_sim_nv_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ *  Peripherals
+ */
+FLASH_TypeDef   g_sim_flash_regs    = { 0 };
+SYSCFG_TypeDef  g_sim_syscfg        = { 0 };
+DWT_Type        g_sim_dwt           = { 0 };
+CoreDebug_Type  g_sim_core_debug    = { 0 };
+SysTick_Type    g_sim_systick       = { 0 };
+uint32_t        SystemCoreClock     = 170000000U;
+
+/**
+ *  Simulator state
+ */
+static uint8_t *                gp_flash_mem        = NULL;
+static uint32_t                 gu32_tick           = 0;
+static uint32_t                 gu32_hal_error      = 0;
+static uint32_t                 gu32_busy_polls     = 0;
+static flash_sim_nv_t *         gp_nv               = NULL;
+
+/**
+ *  Page erase started via registers, executed when BSY clears
+ */
+static bool                     gb_erase_pending    = false;
+static uint32_t                 gu32_erase_bank     = 0;
+static uint32_t                 gu32_erase_page     = 0;
+
+/**
+ *  Saved flash content and corruption
+ */
+static uint8_t *                gp_save_mem         = NULL;
+static flash_sim_nv_t *         gp_save_nv          = NULL;
+
+/**
+ *  ECC trap: host pages holding corrupt double words are inaccessible
+ *  inside boot, access faults and raises NMI if double word is corrupt
+ */
+static bool                     gb_ecc_trap         = false;
+static uintptr_t                g_ecc_step_page     = 0;
+static pf_flash_sim_nmi_t       gpf_nmi             = NULL;
+
+/**
+ *  Interrupt driven erase
+ */
+static FLASH_EraseInitTypeDef   g_it_erase          = { 0 };
+static bool                     gb_it_pending       = false;
+static uint32_t                 gu32_it_left        = 0;
+
+/**
+ *  Test runner
+ */
+static pf_flash_sim_test_t      gpf_test            = NULL;
+static int                      g_test_rc           = 0;
+
+/**
+ *  RTOS mutex
+ */
+static pthread_mutex_t          g_os_mutex;
+
+////////////////////////////////////////////////////////////////////////////////
+// Function prototypes
+////////////////////////////////////////////////////////////////////////////////
+static uint32_t             flash_sim_bank_size (void);
+static uint32_t             flash_sim_page_size (void);
+static uint32_t             flash_sim_page_addr (const uint32_t bank, const uint32_t page);
+static void                 flash_sim_corrupt_set(const uint32_t addr, const bool is_corrupt);
+static void                 flash_sim_ecc_open  (const uint32_t addr, const uint32_t size);
+static void                 flash_sim_ecc_close (const uint32_t addr, const uint32_t size);
+static void                 flash_sim_ecc_fault (int sig, siginfo_t * p_info, void * p_ctx);
+static void                 flash_sim_ecc_step  (int sig, siginfo_t * p_info, void * p_ctx);
+static HAL_StatusTypeDef    flash_sim_prog_dw   (const uint32_t addr, const uint64_t data);
+static void                 flash_sim_erase_page(const uint32_t bank, const uint32_t page);
+static void                 flash_sim_erase     (const FLASH_EraseInitTypeDef * const p_erase);
+static void *               flash_sim_runner    (void * p_arg);
+static void *               flash_sim_os_mutex  (void);
+static void                 flash_sim_reset     (void);
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Page size of active bank mode
+*
+* @return       page size in bytes
+*/
+////////////////////////////////////////////////////////////////////////////////
+static uint32_t flash_sim_page_size(void)
+{
+    return ( FLASH_SIM_IS_DUAL() ? FLASH_PAGE_SIZE : FLASH_SIM_SINGLE_PAGE_SIZE );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Bank size of simulated device in dual-bank mode
+*
+* @return       bank size in bytes
+*/
+////////////////////////////////////////////////////////////////////////////////
+static uint32_t flash_sim_bank_size(void)
+{
+    return ((uint32_t)( *(volatile uint16_t*) FLASHSIZE_BASE ) << 9U );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Address of page
+*
+* @param[in]    bank    - Bank
+* @param[in]    page    - Page number inside bank
+* @return       page address
+*/
+////////////////////////////////////////////////////////////////////////////////
+static uint32_t flash_sim_page_addr(const uint32_t bank, const uint32_t page)
+{
+    uint32_t addr = FLASH_BASE + ( page * flash_sim_page_size());
+
+    if ( FLASH_SIM_IS_DUAL() && ( FLASH_BANK_2 == bank ))
+    {
+        addr += FLASH_SIM_BANK2_OFFSET;
+    }
+
+    return addr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Mark double word ECC corrupt or consistent
+*
+* @param[in]    addr        - Flash address
+* @param[in]    is_corrupt  - Corrupt
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void flash_sim_corrupt_set(const uint32_t addr, const bool is_corrupt)
+{
+    const uint32_t dw = (( addr - FLASH_BASE ) / sizeof( uint64_t ));
+
+    if ( is_corrupt )
+    {
+        gp_nv->corrupt[ dw / 8U ] |= (uint8_t)( 1U << ( dw % 8U ));
+    }
+    else
+    {
+        gp_nv->corrupt[ dw / 8U ] &= (uint8_t) ~( 1U << ( dw % 8U ));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Make flash range accessible for simulator update
+*
+* @param[in]    addr    - Flash address
+* @param[in]    size    - Size in bytes
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void flash_sim_ecc_open(const uint32_t addr, const uint32_t size)
+{
+    if ( gb_ecc_trap )
+    {
+        const uintptr_t start   = ( addr & ~( FLASH_SIM_HOST_PAGE_SIZE - 1U ));
+        const uintptr_t end     = ((( addr + size ) + FLASH_SIM_HOST_PAGE_SIZE - 1U ) & ~( FLASH_SIM_HOST_PAGE_SIZE - 1U ));
+
+        mprotect((void*) start, ( end - start ), ( PROT_READ | PROT_WRITE ));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Arm ECC trap on host pages of range holding corrupt double words
+*
+* @param[in]    addr    - Flash address
+* @param[in]    size    - Size in bytes
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void flash_sim_ecc_close(const uint32_t addr, const uint32_t size)
+{
+    if ( gb_ecc_trap )
+    {
+        const uint32_t start    = ( addr & ~( FLASH_SIM_HOST_PAGE_SIZE - 1U ));
+        const uint32_t end      = ((( addr + size ) + FLASH_SIM_HOST_PAGE_SIZE - 1U ) & ~( FLASH_SIM_HOST_PAGE_SIZE - 1U ));
+
+        for ( uint32_t page = start; page < end; page += FLASH_SIM_HOST_PAGE_SIZE )
+        {
+            bool is_corrupt = false;
+
+            for ( uint32_t dw = page; ( dw < ( page + FLASH_SIM_HOST_PAGE_SIZE )) && ( false == is_corrupt ); dw += sizeof( uint64_t ))
+            {
+                is_corrupt = flash_sim_is_corrupt( dw );
+            }
+
+            mprotect((void*)(uintptr_t) page, FLASH_SIM_HOST_PAGE_SIZE, ( is_corrupt ? PROT_NONE : ( PROT_READ | PROT_WRITE )));
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Access to trapped host page
+*
+* @note     Read of corrupt double word sets ECCD with address of double
+*           word and enters NMI. Host page is opened and faulting access
+*           single stepped, trap is re-armed after it (flash_sim_ecc_step).
+*           Only double word at fault address is checked, wide access
+*           spanning several double words reports first one.
+*
+* @param[in]    sig     - Signal
+* @param[in]    p_info  - Fault info
+* @param[in]    p_ctx   - Interrupted context
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void flash_sim_ecc_fault(int sig, siginfo_t * p_info, void * p_ctx)
+{
+    const uintptr_t     addr    = (uintptr_t) p_info->si_addr;
+    ucontext_t * const  p_uc    = (ucontext_t*) p_ctx;
+
+    (void) sig;
+
+    // Not simulated flash, crash
+    if (( false == gb_ecc_trap ) || ( addr < FLASH_BASE ) || ( addr >= ( FLASH_BASE + FLASH_SIZE )))
+    {
+        signal( SIGSEGV, SIG_DFL );
+    }
+    else
+    {
+        g_ecc_step_page = ( addr & ~((uintptr_t) FLASH_SIM_HOST_PAGE_SIZE - 1U ));
+        mprotect((void*) g_ecc_step_page, FLASH_SIM_HOST_PAGE_SIZE, ( PROT_READ | PROT_WRITE ));
+        p_uc->uc_mcontext.gregs[REG_EFL] |= FLASH_SIM_EFLAGS_TF;
+
+        if ( flash_sim_is_corrupt((uint32_t) addr ))
+        {
+            uint32_t offset = ((uint32_t) addr - FLASH_BASE ) & ~7U;
+
+            if ( FLASH_SIM_IS_DUAL() && ( offset >= FLASH_SIM_BANK2_OFFSET ))
+            {
+                offset = (( offset - FLASH_SIM_BANK2_OFFSET ) | FLASH_ECCR_BK_ECC );
+            }
+
+            g_sim_flash_regs.ECCR = ( FLASH_ECCR_ECCD | offset );
+            gp_nv->stats.nmi_num++;
+
+            if ( NULL != gpf_nmi )
+            {
+                gpf_nmi();
+            }
+
+            // Pending NMI re-enters forever on device
+            if ( g_sim_flash_regs.ECCR & FLASH_ECCR_ECCD )
+            {
+                fprintf( stderr, "flash_sim: unhandled ECC NMI at 0x%08X\n", (unsigned) addr );
+                abort();
+            }
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Faulting access completed, re-arm ECC trap of its host page
+*
+* @param[in]    sig     - Signal
+* @param[in]    p_info  - Trap info
+* @param[in]    p_ctx   - Interrupted context
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void flash_sim_ecc_step(int sig, siginfo_t * p_info, void * p_ctx)
+{
+    ucontext_t * const p_uc = (ucontext_t*) p_ctx;
+
+    (void) sig;
+    (void) p_info;
+
+    p_uc->uc_mcontext.gregs[REG_EFL] &= ~FLASH_SIM_EFLAGS_TF;
+
+    if ( 0U != g_ecc_step_page )
+    {
+        flash_sim_ecc_close((uint32_t) g_ecc_step_page, FLASH_SIM_HOST_PAGE_SIZE );
+        g_ecc_step_page = 0U;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Program double word
+*
+* @note     As on device, only erased double word can be programmed,
+*           except writing all zeros.
+*
+* @param[in]    addr    - Flash address
+* @param[in]    data    - Double word
+* @return       status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+static HAL_StatusTypeDef flash_sim_prog_dw(const uint32_t addr, const uint64_t data)
+{
+    HAL_StatusTypeDef   status  = HAL_OK;
+    uint64_t * const    p_dw    = (uint64_t*)(uintptr_t) addr;
+
+    gp_nv->stats.prog_num++;
+
+    if ( g_sim_flash_regs.ACR & FLASH_ACR_DCEN )
+    {
+        gp_nv->stats.cached_op_num++;
+    }
+
+    if ( addr & 7U )
+    {
+        gu32_hal_error = FLASH_SR_PGAERR;
+        status = HAL_ERROR;
+    }
+    else if (( UINT64_MAX != *p_dw ) && ( 0U != data ))
+    {
+        gu32_hal_error = FLASH_SR_PROGERR;
+        g_sim_flash_regs.SR |= FLASH_SR_PROGERR;
+        status = HAL_ERROR;
+    }
+    else
+    {
+        flash_sim_ecc_open( addr, sizeof( uint64_t ));
+        *p_dw = data;
+        flash_sim_ecc_close( addr, sizeof( uint64_t ));
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Erase single page
+*
+* @param[in]    bank    - Bank
+* @param[in]    page    - Page number inside bank
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void flash_sim_erase_page(const uint32_t bank, const uint32_t page)
+{
+    const uint32_t  page_size   = flash_sim_page_size();
+    const uint32_t  addr        = flash_sim_page_addr( bank, page );
+
+    gp_nv->stats.erase_num++;
+    gu32_tick += 20U;
+
+    if ( g_sim_flash_regs.ACR & FLASH_ACR_ICEN )
+    {
+        gp_nv->stats.cached_op_num++;
+    }
+
+    g_sim_dwt.CYCCNT += FLASH_SIM_CYC_ERASE;
+
+    flash_sim_ecc_open( addr, page_size );
+    memset((void*)(uintptr_t) addr, 0xFF, page_size );
+
+    for ( uint32_t offset = 0U; offset < page_size; offset += sizeof( uint64_t ))
+    {
+        flash_sim_corrupt_set( addr + offset, false );
+    }
+
+    flash_sim_ecc_close( addr, page_size );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Execute erase request
+*
+* @param[in]    p_erase - Erase request
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void flash_sim_erase(const FLASH_EraseInitTypeDef * const p_erase)
+{
+    if ( FLASH_TYPEERASE_MASSERASE == p_erase->TypeErase )
+    {
+        flash_sim_ecc_open( FLASH_BASE, FLASH_SIZE );
+
+        if (( false == FLASH_SIM_IS_DUAL()) || ( FLASH_BANK_BOTH == p_erase->Banks ))
+        {
+            memset( gp_flash_mem, 0xFF, FLASH_SIZE );
+        }
+        else
+        {
+            memset( gp_flash_mem + (( FLASH_BANK_2 == p_erase->Banks ) ? FLASH_SIM_BANK2_OFFSET : 0U ), 0xFF, flash_sim_bank_size());
+        }
+
+        memset( gp_nv->corrupt, 0, sizeof( gp_nv->corrupt ));
+        flash_sim_ecc_close( FLASH_BASE, FLASH_SIZE );
+
+        gp_nv->stats.erase_num++;
+    }
+    else
+    {
+        for ( uint32_t i = 0; i < p_erase->NbPages; i++ )
+        {
+            flash_sim_erase_page( p_erase->Banks, p_erase->Page + i );
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Test thread
+*
+* @param[in]    p_arg   - Unused
+* @return       NULL
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void * flash_sim_runner(void * p_arg)
+{
+    (void) p_arg;
+
+    g_test_rc = gpf_test();
+
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Create recursive mutex standing in for RTOS mutex
+*
+* @return       mutex handle
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void * flash_sim_os_mutex(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init( &attr );
+    pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_RECURSIVE );
+    pthread_mutex_init( &g_os_mutex, &attr );
+
+    return &g_os_mutex;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Initialize flash simulator
+*
+* @note     Flash content is erased, option bytes select dual-bank mode.
+*
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+void flash_sim_init(void)
+{
+    void *              p_sys   = NULL;
+    struct sigaction    sa      = { 0 };
+
+    gp_flash_mem = mmap((void*) FLASH_BASE, FLASH_SIZE, ( PROT_READ | PROT_WRITE ), ( MAP_FIXED | MAP_SHARED | MAP_ANONYMOUS ), -1, 0 );
+    p_sys        = mmap((void*) FLASH_SIM_SYS_ADDR, FLASH_SIM_SYS_SIZE, ( PROT_READ | PROT_WRITE ), ( MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS ), -1, 0 );
+    gp_nv        = mmap( NULL, sizeof( flash_sim_nv_t ), ( PROT_READ | PROT_WRITE ), ( MAP_SHARED | MAP_ANONYMOUS ), -1, 0 );
+
+    if (( (void*) FLASH_BASE != gp_flash_mem ) || ( (void*) FLASH_SIM_SYS_ADDR != p_sys ) || ( MAP_FAILED == gp_nv ))
+    {
+        perror( "flash_sim: mmap" );
+        exit( 1 );
+    }
+
+    memset( gp_flash_mem, 0xFF, FLASH_SIZE );
+    memset( gp_nv, 0, sizeof( flash_sim_nv_t ));
+    *(volatile uint16_t*) FLASHSIZE_BASE = (uint16_t)( FLASH_SIZE / 1024U );
+
+    #if defined( FLASH_OPTR_DBANK )
+        g_sim_flash_regs.OPTR = FLASH_OPTR_DBANK;
+    #else
+        g_sim_flash_regs.OPTR = 0U;
+    #endif
+    flash_sim_reset();
+
+    // ECC trap
+    sa.sa_flags     = SA_SIGINFO;
+    sa.sa_sigaction = flash_sim_ecc_fault;
+    sigaction( SIGSEGV, &sa, NULL );
+    sa.sa_sigaction = flash_sim_ecc_step;
+    sigaction( SIGTRAP, &sa, NULL );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Reset flash controller
+*
+* @note     Flash content and option bytes are kept.
+*
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void flash_sim_reset(void)
+{
+    const uint32_t optr = g_sim_flash_regs.OPTR;
+
+    memset( &g_sim_flash_regs, 0, sizeof( g_sim_flash_regs ));
+    g_sim_flash_regs.OPTR   = optr;
+    g_sim_flash_regs.CR     = ( FLASH_CR_LOCK | FLASH_CR_OPTLOCK );
+    gb_it_pending           = false;
+    gb_erase_pending        = false;
+    gu32_busy_polls         = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Run test
+*
+* @note     Driver keeps addresses as 32-bit values, so test (and all its
+*           stack buffers) runs on a thread with stack in lower 4 GB.
+*
+* @param[in]    pf_test - Test entry
+* @return       test result, 0 on success
+*/
+////////////////////////////////////////////////////////////////////////////////
+int flash_sim_run(pf_flash_sim_test_t pf_test)
+{
+    pthread_attr_t  attr;
+    pthread_t       thread;
+    void *          p_stack = mmap( NULL, FLASH_SIM_STACK_SIZE, ( PROT_READ | PROT_WRITE ), ( MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT ), -1, 0 );
+
+    if ( MAP_FAILED == p_stack )
+    {
+        perror( "flash_sim: stack" );
+        exit( 1 );
+    }
+
+    gpf_test = pf_test;
+
+    pthread_attr_init( &attr );
+    pthread_attr_setstack( &attr, p_stack, FLASH_SIM_STACK_SIZE );
+    pthread_create( &thread, &attr, flash_sim_runner, NULL );
+    pthread_join( thread, NULL );
+
+    printf( "%s\n", ( 0 == g_test_rc ) ? "PASS" : "FAIL" );
+
+    return g_test_rc;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Report failed check and terminate
+*
+* @param[in]    p_file  - Source file
+* @param[in]    line    - Source line
+* @param[in]    p_expr  - Failed expression
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+void flash_sim_fail(const char * const p_file, const int line, const char * const p_expr)
+{
+    fprintf( stderr, "%s:%d: check failed: %s\n", p_file, line, p_expr );
+    fflush( stdout );
+    _exit( 1 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Interrupt driven erase in progress
+*
+* @return       true when flash interrupt is pending
+*/
+////////////////////////////////////////////////////////////////////////////////
+bool flash_sim_it_pending(void)
+{
+    return gb_it_pending;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Get simulator operation counters
+*
+* @param[out]   p_stats - Counters
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+void flash_sim_get_stats(flash_sim_stats_t * const p_stats)
+{
+    *p_stats = gp_nv->stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Boot simulated device
+*
+* @note     Boot runs in forked process with flash controller reset, flash
+*           content and corruption are shared with caller. Reads of ECC
+*           corrupt double words raise NMI inside boot. Boot ends with
+*           return from pf_boot, power cut or crash.
+*
+* @param[in]    pf_boot - Boot entry
+* @return       exit code of boot, FLASH_SIM_BOOT_CUT or FLASH_SIM_BOOT_CRASH
+*/
+////////////////////////////////////////////////////////////////////////////////
+int flash_sim_boot(pf_flash_sim_boot_t pf_boot)
+{
+    int     rc      = FLASH_SIM_BOOT_CRASH;
+    int     wstatus = 0;
+    pid_t   pid     = 0;
+
+    fflush( stdout );
+    pid = fork();
+
+    if ( 0 == pid )
+    {
+        flash_sim_reset();
+
+        gb_ecc_trap = true;
+        flash_sim_ecc_close( FLASH_BASE, FLASH_SIZE );
+
+        rc = pf_boot();
+        fflush( stdout );
+        _exit( rc );
+    }
+    else if (( pid > 0 ) && ( pid == waitpid( pid, &wstatus, 0 )) && ( WIFEXITED( wstatus )))
+    {
+        rc = WEXITSTATUS( wstatus );
+    }
+    else
+    {
+        rc = FLASH_SIM_BOOT_CRASH;
+    }
+
+    return rc;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Cut power
+*
+* @note     Operation in progress is torn: double word being programmed
+*           keeps random subset of its programmed bits, page being erased
+*           random part of its content. Torn double words are marked ECC
+*           corrupt. Boot ends with FLASH_SIM_BOOT_CUT.
+*
+* @param[in]    addr    - Address of operation in progress
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+void flash_sim_power_cut(const uint32_t addr)
+{
+    flash_sim_ecc_open( FLASH_BASE, FLASH_SIZE );
+
+    // Double word being programmed
+    if ( g_sim_flash_regs.CR & FLASH_CR_PG )
+    {
+        uint64_t * const    p_dw    = (uint64_t*)(uintptr_t)( addr & ~7U );
+        const uint64_t      data    = *p_dw;
+        uint64_t            torn    = ( data | ((((uint64_t) rand() << 32 ) | (uint64_t) rand()) & ~data ));
+
+        // At least one bit not programmed yet
+        if (( torn == data ) && ( UINT64_MAX != data ))
+        {
+            torn |= (( ~data ) & ( data + 1U ));
+        }
+
+        *p_dw = torn;
+        flash_sim_corrupt_set((uint32_t)(uintptr_t) p_dw, true );
+    }
+
+    // Page being erased
+    else if ( gb_erase_pending )
+    {
+        const uint32_t  page_size   = flash_sim_page_size();
+        const uint32_t  page_addr   = flash_sim_page_addr( gu32_erase_bank, gu32_erase_page );
+        uint8_t * const p_page      = (uint8_t*)(uintptr_t) page_addr;
+        const uint32_t  erased      = (((uint32_t) rand() % page_size ) & ~7U );
+
+        memset( p_page, 0xFF, erased );
+
+        for ( uint32_t i = erased; i < page_size; i++ )
+        {
+            p_page[i] |= (uint8_t) rand();
+        }
+
+        for ( uint32_t offset = 0U; offset < page_size; offset += sizeof( uint64_t ))
+        {
+            flash_sim_corrupt_set( page_addr + offset, ( UINT64_MAX != *(const uint64_t*) &p_page[offset] ));
+        }
+    }
+    else
+    {
+        // No actions...
+    }
+
+    gp_nv->stats.cut_num++;
+    fflush( stdout );
+    _exit( FLASH_SIM_BOOT_CUT );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Check ECC corruption of double word
+*
+* @param[in]    addr    - Flash address
+* @return       true if double word is corrupt
+*/
+////////////////////////////////////////////////////////////////////////////////
+bool flash_sim_is_corrupt(const uint32_t addr)
+{
+    const uint32_t dw = (( addr - FLASH_BASE ) / sizeof( uint64_t ));
+
+    return ( 0U != ( gp_nv->corrupt[ dw / 8U ] & ( 1U << ( dw % 8U ))));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Save flash content and corruption
+*
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+void flash_sim_save(void)
+{
+    if ( NULL == gp_save_mem )
+    {
+        gp_save_mem = malloc( FLASH_SIZE );
+        gp_save_nv  = malloc( sizeof( flash_sim_nv_t ));
+    }
+
+    memcpy( gp_save_mem, gp_flash_mem, FLASH_SIZE );
+    memcpy( gp_save_nv->corrupt, gp_nv->corrupt, sizeof( gp_nv->corrupt ));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Restore flash content and corruption saved by flash_sim_save
+*
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+void flash_sim_restore(void)
+{
+    if ( NULL != gp_save_mem )
+    {
+        memcpy( gp_flash_mem, gp_save_mem, FLASH_SIZE );
+        memcpy( gp_nv->corrupt, gp_save_nv->corrupt, sizeof( gp_nv->corrupt ));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Register NMI handler of booted device
+*
+* @param[in]    pf_nmi  - NMI handler, NULL leaves ECC NMI unhandled
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+void flash_sim_nmi_set(pf_flash_sim_nmi_t pf_nmi)
+{
+    gpf_nmi = pf_nmi;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Set flash size of simulated device
+*
+* @note     Takes effect at next flash_init. Array stays mapped at full
+*           size, in dual-bank mode bank 2 starts at 0x08040000 regardless
+*           of size.
+*
+* @param[in]    size    - Flash size in bytes, up to FLASH_SIZE
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+void flash_sim_set_size(const uint32_t size)
+{
+    FLASH_SIM_CHECK(( size <= FLASH_SIZE ) && ( 0U == ( size % 1024U )));
+
+    *(volatile uint16_t*) FLASHSIZE_BASE = (uint16_t)( size / 1024U );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Register write
+*
+* @note     Status register and ECC flags are write 1 to clear.
+*
+* @param[in]    p_reg   - Register
+* @param[in]    val     - Value
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+void flash_sim_reg_write(__IO uint32_t * const p_reg, const uint32_t val)
+{
+    const uint32_t w1c = ( FLASH_ECCR_ECCC | FLASH_ECCR_ECCD | FLASH_ECCR_ECCC2 | FLASH_ECCR_ECCD2 );
+
+    if ( &g_sim_flash_regs.SR == p_reg )
+    {
+        *p_reg &= ~val;
+    }
+    else if ( &g_sim_flash_regs.ECCR == p_reg )
+    {
+        *p_reg = (( *p_reg & ~val ) & w1c ) | ( val & ~w1c );
+    }
+    else
+    {
+        *p_reg = val;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Register read
+*
+* @note     Page erase started via registers keeps BSY set for few polls,
+*           page is erased when BSY clears.
+*
+* @param[in]    p_reg   - Register
+* @return       register value
+*/
+////////////////////////////////////////////////////////////////////////////////
+uint32_t flash_sim_reg_read(__IO uint32_t * const p_reg)
+{
+    if (( &g_sim_flash_regs.SR == p_reg ) && ( gu32_busy_polls > 0U ))
+    {
+        gp_nv->stats.busy_poll_num++;
+        gu32_busy_polls--;
+
+        if ( 0U == gu32_busy_polls )
+        {
+            g_sim_flash_regs.SR &= ~FLASH_SR_BSY;
+
+            if ( gb_erase_pending )
+            {
+                gb_erase_pending = false;
+                flash_sim_erase_page( gu32_erase_bank, gu32_erase_page );
+            }
+        }
+    }
+
+    return *p_reg;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Register bit set
+*
+* @note     Setting STRT with PER selected erases page PNB of bank BKER.
+*           Cache resets are counted.
+*
+* @param[in]    p_reg   - Register
+* @param[in]    bits    - Bits to set
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+void flash_sim_reg_set(__IO uint32_t * const p_reg, const uint32_t bits)
+{
+    *p_reg |= bits;
+
+    if ( &g_sim_flash_regs.ACR == p_reg )
+    {
+        gp_nv->stats.dcache_rst_num += (( bits & FLASH_ACR_DCRST ) ? 1U : 0U );
+        gp_nv->stats.icache_rst_num += (( bits & FLASH_ACR_ICRST ) ? 1U : 0U );
+    }
+
+    if  (   ( &g_sim_flash_regs.CR == p_reg )
+        &&  ( bits & FLASH_CR_STRT )
+        &&  ( g_sim_flash_regs.CR & FLASH_CR_PER ))
+    {
+        g_sim_flash_regs.CR &= ~FLASH_CR_STRT;
+        gp_nv->stats.reg_erase_num++;
+
+        gu32_erase_bank     = (( g_sim_flash_regs.CR & FLASH_CR_BKER ) ? FLASH_BANK_2 : FLASH_BANK_1 );
+        gu32_erase_page     = (( g_sim_flash_regs.CR & FLASH_CR_PNB ) >> FLASH_CR_PNB_Pos );
+        gb_erase_pending    = true;
+
+        g_sim_flash_regs.SR |= FLASH_SR_BSY;
+        gu32_busy_polls = FLASH_SIM_ERASE_BUSY_POLLS;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// HAL
+////////////////////////////////////////////////////////////////////////////////
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+    g_sim_flash_regs.CR &= ~FLASH_CR_LOCK;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+    g_sim_flash_regs.CR |= FLASH_CR_LOCK;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_OB_Unlock(void)
+{
+    g_sim_flash_regs.CR &= ~FLASH_CR_OPTLOCK;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_OB_Lock(void)
+{
+    g_sim_flash_regs.CR |= FLASH_CR_OPTLOCK;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_OB_Launch(void)
+{
+    return HAL_OK;
+}
+
+uint32_t HAL_FLASH_GetError(void)
+{
+    return gu32_hal_error;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+    HAL_StatusTypeDef status = HAL_OK;
+
+    if ( g_sim_flash_regs.CR & FLASH_CR_LOCK )
+    {
+        status = HAL_ERROR;
+    }
+    else if ( FLASH_TYPEPROGRAM_DOUBLEWORD == TypeProgram )
+    {
+        gu32_tick++;
+        g_sim_dwt.CYCCNT += FLASH_SIM_CYC_PROG;
+        status = flash_sim_prog_dw( Address, Data );
+    }
+    else
+    {
+        const uint64_t * const p_src = (const uint64_t*)(uintptr_t)(uint32_t) Data;
+
+        gu32_tick++;
+        g_sim_dwt.CYCCNT += FLASH_SIM_CYC_FAST;
+        gp_nv->stats.fast_num++;
+
+        if ( Address & 0xFFU )
+        {
+            gu32_hal_error = FLASH_SR_PGAERR;
+            status = HAL_ERROR;
+        }
+
+        for ( uint32_t i = 0; ( HAL_OK == status ) && ( i < FLASH_NB_DOUBLE_WORDS_IN_ROW ); i++ )
+        {
+            status = flash_sim_prog_dw( Address + ( 8U * i ), p_src[i] );
+        }
+    }
+
+    return status;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program_IT(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+    return HAL_FLASH_Program( TypeProgram, Address, Data );
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef * pEraseInit, uint32_t * PageError)
+{
+    HAL_StatusTypeDef status = HAL_OK;
+
+    if ( g_sim_flash_regs.CR & FLASH_CR_LOCK )
+    {
+        status = HAL_ERROR;
+    }
+    else
+    {
+        *PageError = 0xFFFFFFFFU;
+        flash_sim_erase( pEraseInit );
+    }
+
+    return status;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase_IT(FLASH_EraseInitTypeDef * pEraseInit)
+{
+    HAL_StatusTypeDef status = HAL_OK;
+
+    if ( gb_it_pending )
+    {
+        status = HAL_BUSY;
+    }
+    else
+    {
+        g_it_erase      = *pEraseInit;
+        gu32_it_left    = pEraseInit->NbPages;
+        gb_it_pending   = true;
+    }
+
+    return status;
+}
+
+void HAL_FLASH_IRQHandler(void)
+{
+    FLASH_EraseInitTypeDef one;
+
+    if ( gb_it_pending )
+    {
+        if ( FLASH_TYPEERASE_MASSERASE == g_it_erase.TypeErase )
+        {
+            flash_sim_erase( &g_it_erase );
+            gb_it_pending = false;
+            HAL_FLASH_EndOfOperationCallback( g_it_erase.Banks );
+        }
+        else
+        {
+            one         = g_it_erase;
+            one.NbPages = 1U;
+            flash_sim_erase( &one );
+            gu32_it_left--;
+
+            if ( gu32_it_left > 0U )
+            {
+                HAL_FLASH_EndOfOperationCallback( g_it_erase.Page );
+                g_it_erase.Page++;
+            }
+            else
+            {
+                gb_it_pending = false;
+                HAL_FLASH_EndOfOperationCallback( 0xFFFFFFFFU );
+            }
+        }
+    }
+}
+
+__attribute__((weak)) void HAL_FLASH_EndOfOperationCallback(uint32_t ReturnValue)
+{
+    (void) ReturnValue;
+}
+
+__attribute__((weak)) void HAL_FLASH_OperationErrorCallback(uint32_t ReturnValue)
+{
+    (void) ReturnValue;
+}
+
+__attribute__((weak)) void FLASH_IRQHandler(void)
+{
+    HAL_FLASH_IRQHandler();
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_OBProgram(FLASH_OBProgramInitTypeDef * pOBInit)
+{
+    HAL_StatusTypeDef status = HAL_OK;
+
+    if ( g_sim_flash_regs.CR & FLASH_CR_OPTLOCK )
+    {
+        status = HAL_ERROR;
+    }
+#if defined( FLASH_OPTR_DBANK )
+    else if (( pOBInit->OptionType & OPTIONBYTE_USER ) && ( pOBInit->USERType & OB_USER_DBANK ))
+    {
+        MODIFY_REG( g_sim_flash_regs.OPTR, FLASH_OPTR_DBANK, ( pOBInit->USERConfig & FLASH_OPTR_DBANK ));
+    }
+#endif
+    else
+    {
+        // No actions...
+    }
+
+    return status;
+}
+
+void HAL_FLASHEx_OBGetConfig(FLASH_OBProgramInitTypeDef * pOBInit)
+{
+    pOBInit->USERConfig = g_sim_flash_regs.OPTR;
+}
+
+HAL_StatusTypeDef FLASH_WaitForLastOperation(uint32_t Timeout)
+{
+    (void) Timeout;
+    return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    // Called by concurrent scheduler producers
+    return __atomic_fetch_add( &gu32_tick, 1U, __ATOMIC_RELAXED );
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void)
+{
+    return SystemCoreClock;
+}
+
+uint32_t HAL_PWREx_GetVoltageRange(void)
+{
+    return PWR_REGULATOR_VOLTAGE_SCALE1_BOOST;
+}
+
+void HAL_NVIC_SetPriority(int IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+    (void) IRQn;
+    (void) PreemptPriority;
+    (void) SubPriority;
+}
+
+void HAL_NVIC_EnableIRQ(int IRQn)
+{
+    (void) IRQn;
+}
+
+void HAL_NVIC_DisableIRQ(int IRQn)
+{
+    (void) IRQn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// RTOS
+//
+// Mutex is recursive pthread mutex. Delay hands CPU to other threads and
+// services pending flash interrupt, as interrupt would fire while task sleeps.
+////////////////////////////////////////////////////////////////////////////////
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+    return flash_sim_os_mutex();
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t xMutex, TickType_t xTicksToWait)
+{
+    (void) xTicksToWait;
+    pthread_mutex_lock((pthread_mutex_t*) xMutex );
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t xMutex)
+{
+    pthread_mutex_unlock((pthread_mutex_t*) xMutex );
+    return pdTRUE;
+}
+
+void vTaskDelay(TickType_t xTicksToDelay)
+{
+    gu32_tick += xTicksToDelay;
+
+    if ( gb_it_pending )
+    {
+        FLASH_IRQHandler();
+    }
+
+    sched_yield();
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return gu32_tick;
+}
+
+osMutexId_t osMutexNew(const osMutexAttr_t * attr)
+{
+    (void) attr;
+    return flash_sim_os_mutex();
+}
+
+osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout)
+{
+    (void) timeout;
+    return pthread_mutex_lock((pthread_mutex_t*) mutex_id );
+}
+
+osStatus_t osMutexRelease(osMutexId_t mutex_id)
+{
+    return pthread_mutex_unlock((pthread_mutex_t*) mutex_id );
+}
+
+osStatus_t osDelay(uint32_t ticks)
+{
+    vTaskDelay( ticks );
+    return 0;
+}
+
+uint32_t osKernelGetTickCount(void)
+{
+    return gu32_tick;
+}
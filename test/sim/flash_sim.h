@@ -0,0 +1,107 @@
+// Copyright (c) 2026  Ziga Miklosic
+// All Rights Reserved
+////////////////////////////////////////////////////////////////////////////////
+/**
+*@file      flash_sim.h
+*@brief     Host simulator of STM32G4 flash for driver tests
+*@author    Ziga Miklosic
+*@email		ziga.miklosic@gmail.si
+*@date      16.10.2026
+*@version   V0.2.0
+*
+*@note      Flash array is mapped to its device address (0x0800_0000) as
+*           shared memory, so driver runs unmodified and content survives
+*           forked "boots" (see flash_sim_boot). Power cut tears operation
+*           in progress: double word being programmed is left with random
+*           subset of its bits programmed, page being erased is left
+*           partially erased. Such double words are marked ECC corrupt,
+*           inside boot their read sets ECCD and enters NMI handler
+*           registered with flash_sim_nmi_set, as uncorrectable error would
+*           on device. Boot without handler, or with handler leaving ECCD
+*           set, crashes.
+*           Driver casts pointers to 32-bit addresses,
+*           therefore tests are executed on a thread with stack in lower
+*           4 GB (see flash_sim_run).
+*/
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __FLASH_SIM_H
+#define __FLASH_SIM_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "stm32g4xx_hal.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ *  Test check, reports location and terminates test with failure
+ */
+#define FLASH_SIM_CHECK(x)                  do { if ( !( x )) { flash_sim_fail( __FILE__, __LINE__, #x ); }} while ( 0 )
+
+/**
+ *  Boot result of power cut and of crash (signal, e.g. failed assert)
+ */
+#define FLASH_SIM_BOOT_CUT                  ( 100 )
+#define FLASH_SIM_BOOT_CRASH                ( -1 )
+
+/**
+ *  Simulator operation counters
+ */
+typedef struct
+{
+    uint32_t prog_num;          /**<Number of double word programs */
+    uint32_t fast_num;          /**<Number of fast row programs */
+    uint32_t erase_num;         /**<Number of erased pages */
+    uint32_t reg_erase_num;     /**<Number of pages erased via registers */
+    uint32_t busy_poll_num;     /**<Number of status polls with BSY set */
+    uint32_t cut_num;           /**<Number of power cuts */
+    uint32_t nmi_num;           /**<Number of ECC NMIs raised */
+    uint32_t dcache_rst_num;    /**<Number of data cache resets */
+    uint32_t icache_rst_num;    /**<Number of instruction cache resets */
+    uint32_t cached_op_num;     /**<Number of programs with data cache or erases with instruction cache enabled */
+} flash_sim_stats_t;
+
+/**
+ *  Test entry
+ */
+typedef int (*pf_flash_sim_test_t)(void);
+
+/**
+ *  Boot entry, returns exit code of booted "device"
+ */
+typedef int (*pf_flash_sim_boot_t)(void);
+
+/**
+ *  NMI handler
+ */
+typedef void (*pf_flash_sim_nmi_t)(void);
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void    flash_sim_init      (void);
+int     flash_sim_run       (pf_flash_sim_test_t pf_test);
+void    flash_sim_fail      (const char * const p_file, const int line, const char * const p_expr);
+bool    flash_sim_it_pending(void);
+void    flash_sim_get_stats (flash_sim_stats_t * const p_stats);
+int     flash_sim_boot      (pf_flash_sim_boot_t pf_boot);
+void    flash_sim_power_cut (const uint32_t addr) __attribute__((noreturn));
+bool    flash_sim_is_corrupt(const uint32_t addr);
+void    flash_sim_save      (void);
+void    flash_sim_restore   (void);
+void    flash_sim_nmi_set   (pf_flash_sim_nmi_t pf_nmi);
+void    flash_sim_set_size  (const uint32_t size);
+
+/**
+ *  Flash interrupt vector, provided by driver or simulator
+ */
+void    FLASH_IRQHandler    (void);
+
+#endif // __FLASH_SIM_H
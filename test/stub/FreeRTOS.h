@@ -0,0 +1,9 @@
+#pragma once
+#include <stdint.h>
+typedef void * SemaphoreHandle_t; typedef uint32_t TickType_t; typedef long BaseType_t;
+#define portMAX_DELAY 0xFFFFFFFFU
+#define pdMS_TO_TICKS(x) ((TickType_t)(x))
+#define pdTRUE 1
+#define pdFALSE 0
+#define configASSERT(x)
+#define portYIELD_FROM_ISR(x) (void)(x)
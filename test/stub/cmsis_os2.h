@@ -0,0 +1,12 @@
+#pragma once
+#include <stdint.h>
+typedef void * osMutexId_t; typedef int osStatus_t;
+typedef struct { const char *name; uint32_t attr_bits; void *cb_mem; uint32_t cb_size; } osMutexAttr_t;
+#define osMutexRecursive 1U
+#define osMutexPrioInherit 2U
+#define osWaitForever 0xFFFFFFFFU
+osMutexId_t osMutexNew(const osMutexAttr_t *);
+osStatus_t osMutexAcquire(osMutexId_t, uint32_t);
+osStatus_t osMutexRelease(osMutexId_t);
+osStatus_t osDelay(uint32_t);
+uint32_t osKernelGetTickCount(void);
@@ -0,0 +1,21 @@
+// Copyright (c) 2026  Ziga Miklosic
+// All Rights Reserved
+////////////////////////////////////////////////////////////////////////////////
+/**
+*@file      proj_cfg.h
+*@brief     Host stub of project configuration for driver tests
+*@author    Ziga Miklosic
+*@email		ziga.miklosic@gmail.si
+*@date      16.10.2026
+*@version   V0.2.0
+*/
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __PROJ_CFG_H
+#define __PROJ_CFG_H
+
+#include <assert.h>
+
+#define PROJ_CFG_ASSERT(x)                  assert( x )
+
+#endif // __PROJ_CFG_H
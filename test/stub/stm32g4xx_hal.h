@@ -0,0 +1,350 @@
+// Copyright (c) 2026  Ziga Miklosic
+// All Rights Reserved
+////////////////////////////////////////////////////////////////////////////////
+/**
+*@file      stm32g4xx_hal.h
+*@brief     Host stub of STM32G4 HAL and flash registers for driver tests
+*@author    Ziga Miklosic
+*@email		ziga.miklosic@gmail.si
+*@date      16.10.2026
+*@version   V0.2.0
+*
+*@note      Only what flash driver uses is provided. Flash memory and
+*           controller behavior is modeled by flash simulator (flash_sim.c).
+*           Register accesses go through simulator hooks, so writes to
+*           control register start operations and status flags are
+*           write 1 to clear as on device.
+*/
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __STM32G4XX_HAL_STUB_H
+#define __STM32G4XX_HAL_STUB_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+#define __IO                                volatile
+
+typedef enum
+{
+    HAL_OK = 0,
+    HAL_ERROR,
+    HAL_BUSY,
+    HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+    RESET = 0,
+    SET
+} FlagStatus;
+
+/**
+ *  Flash controller registers
+ */
+typedef struct
+{
+    __IO uint32_t ACR;
+    __IO uint32_t PDKEYR;
+    __IO uint32_t KEYR;
+    __IO uint32_t OPTKEYR;
+    __IO uint32_t SR;
+    __IO uint32_t CR;
+    __IO uint32_t ECCR;
+    __IO uint32_t OPTR;
+} FLASH_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t MEMRMP;
+} SYSCFG_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CTRL;
+    __IO uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+    __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct
+{
+    __IO uint32_t CTRL;
+    __IO uint32_t LOAD;
+    __IO uint32_t VAL;
+} SysTick_Type;
+
+extern FLASH_TypeDef    g_sim_flash_regs;
+extern SYSCFG_TypeDef   g_sim_syscfg;
+extern DWT_Type         g_sim_dwt;
+extern CoreDebug_Type   g_sim_core_debug;
+extern SysTick_Type     g_sim_systick;
+
+#define FLASH                               ( &g_sim_flash_regs )
+#define SYSCFG                              ( &g_sim_syscfg )
+#define DWT                                 ( &g_sim_dwt )
+#define CoreDebug                           ( &g_sim_core_debug )
+#define SysTick                             ( &g_sim_systick )
+
+/**
+ *  Memory map, STM32G474xE: 512 kB, 2 kB pages in dual-bank mode
+ */
+#define FLASH_BASE                          ( 0x08000000UL )
+#define FLASH_SIZE                          ( 512U * 1024U )
+#define FLASH_BANK_SIZE                     ( FLASH_SIZE >> 1 )
+#define FLASH_PAGE_SIZE                     ( 0x800U )
+#define FLASH_PAGE_NB                       (( FLASH_SIZE / FLASH_PAGE_SIZE ) >> 1 )
+#define FLASHSIZE_BASE                      ( 0x1FFF75E0UL )
+#define UID_BASE                            ( 0x1FFF7590UL )
+
+/**
+ *  Erase and program types
+ */
+#define FLASH_TYPEERASE_PAGES               ( 0x00U )
+#define FLASH_TYPEERASE_MASSERASE           ( 0x01U )
+#define FLASH_BANK_1                        ( 0x01U )
+#define FLASH_BANK_2                        ( 0x02U )
+#define FLASH_BANK_BOTH                     ( 0x03U )
+#define FLASH_TYPEPROGRAM_DOUBLEWORD        ( 0x00U )
+#define FLASH_TYPEPROGRAM_FAST              ( 0x01U )
+#define FLASH_TYPEPROGRAM_FAST_AND_LAST     ( 0x02U )
+#define FLASH_NB_DOUBLE_WORDS_IN_ROW        ( 32U )
+
+typedef struct
+{
+    uint32_t TypeErase;
+    uint32_t Banks;
+    uint32_t Page;
+    uint32_t NbPages;
+} FLASH_EraseInitTypeDef;
+
+typedef struct
+{
+    uint32_t OptionType;
+    uint32_t WRPArea;
+    uint32_t WRPStartOffset;
+    uint32_t WRPEndOffset;
+    uint32_t RDPLevel;
+    uint32_t USERType;
+    uint32_t USERConfig;
+} FLASH_OBProgramInitTypeDef;
+
+/**
+ *  Status register
+ */
+#define FLASH_SR_EOP                        ( 1U << 0 )
+#define FLASH_SR_OPERR                      ( 1U << 1 )
+#define FLASH_SR_PROGERR                    ( 1U << 3 )
+#define FLASH_SR_WRPERR                     ( 1U << 4 )
+#define FLASH_SR_PGAERR                     ( 1U << 5 )
+#define FLASH_SR_SIZERR                     ( 1U << 6 )
+#define FLASH_SR_PGSERR                     ( 1U << 7 )
+#define FLASH_SR_MISERR                     ( 1U << 8 )
+#define FLASH_SR_FASTERR                    ( 1U << 9 )
+#define FLASH_SR_RDERR                      ( 1U << 14 )
+#define FLASH_SR_OPTVERR                    ( 1U << 15 )
+#define FLASH_SR_BSY                        ( 1U << 16 )
+
+#define FLASH_FLAG_EOP                      ( FLASH_SR_EOP )
+#define FLASH_FLAG_OPERR                    ( FLASH_SR_OPERR )
+#define FLASH_FLAG_PROGERR                  ( FLASH_SR_PROGERR )
+#define FLASH_FLAG_WRPERR                   ( FLASH_SR_WRPERR )
+#define FLASH_FLAG_PGAERR                   ( FLASH_SR_PGAERR )
+#define FLASH_FLAG_SIZERR                   ( FLASH_SR_SIZERR )
+#define FLASH_FLAG_PGSERR                   ( FLASH_SR_PGSERR )
+#define FLASH_FLAG_MISERR                   ( FLASH_SR_MISERR )
+#define FLASH_FLAG_FASTERR                  ( FLASH_SR_FASTERR )
+#define FLASH_FLAG_RDERR                    ( FLASH_SR_RDERR )
+#define FLASH_FLAG_OPTVERR                  ( FLASH_SR_OPTVERR )
+#define FLASH_FLAG_BSY                      ( FLASH_SR_BSY )
+#define FLASH_FLAG_ECCC                     ( FLASH_ECCR_ECCC | 0x80000000U )
+#define FLASH_FLAG_ECCD                     ( FLASH_ECCR_ECCD | 0x40000000U )
+#define FLASH_FLAG_SR_ERRORS                ( FLASH_SR_OPERR  | FLASH_SR_PROGERR | FLASH_SR_WRPERR \
+                                            | FLASH_SR_PGAERR | FLASH_SR_SIZERR  | FLASH_SR_PGSERR \
+                                            | FLASH_SR_MISERR | FLASH_SR_FASTERR | FLASH_SR_RDERR  \
+                                            | FLASH_SR_OPTVERR )
+#define FLASH_FLAG_ALL_ERRORS               ( FLASH_FLAG_SR_ERRORS | FLASH_FLAG_ECCC | FLASH_FLAG_ECCD )
+
+/**
+ *  Control register
+ */
+#define FLASH_CR_PG                         ( 1U << 0 )
+#define FLASH_CR_PER                        ( 1U << 1 )
+#define FLASH_CR_MER1                       ( 1U << 2 )
+#define FLASH_CR_PNB_Pos                    ( 3U )
+#define FLASH_CR_PNB                        ( 0x7FU << FLASH_CR_PNB_Pos )
+#define FLASH_CR_BKER                       ( 1U << 11 )
+#define FLASH_CR_MER2                       ( 1U << 15 )
+#define FLASH_CR_STRT                       ( 1U << 16 )
+#define FLASH_CR_OPTSTRT                    ( 1U << 17 )
+#define FLASH_CR_FSTPG                      ( 1U << 18 )
+#define FLASH_CR_EOPIE                      ( 1U << 24 )
+#define FLASH_CR_ERRIE                      ( 1U << 25 )
+#define FLASH_CR_OBL_LAUNCH                 ( 1U << 27 )
+#define FLASH_CR_OPTLOCK                    ( 1U << 30 )
+#define FLASH_CR_LOCK                       ( 1U << 31 )
+
+/**
+ *  ECC register
+ */
+#define FLASH_ECCR_ADDR_ECC                 ( 0x7FFFFU )
+#define FLASH_ECCR_BK_ECC                   ( 1U << 21 )
+#define FLASH_ECCR_SYSF_ECC                 ( 1U << 22 )
+#define FLASH_ECCR_ECCCIE                   ( 1U << 24 )
+#define FLASH_ECCR_ECCC2                    ( 1U << 28 )
+#define FLASH_ECCR_ECCD2                    ( 1U << 29 )
+#define FLASH_ECCR_ECCC                     ( 1U << 30 )
+#define FLASH_ECCR_ECCD                     ( 1U << 31 )
+
+/**
+ *  Option and access control registers
+ */
+#define FLASH_OPTR_BFB2                     ( 1U << 20 )
+
+/**
+ *  DBANK option bit and 4 kB single bank page exist on category 3 devices
+ *  only, FLASH_SIM_CAT2 builds category 2 device (G431/G441/G491/G4A1)
+ */
+#if !defined( FLASH_SIM_CAT2 )
+    #define FLASH_OPTR_DBANK                ( 1U << 22 )
+#endif
+
+#if defined( FLASH_OPTR_DBANK )
+    #define FLASH_PAGE_SIZE_128_BITS        ( 0x1000U )
+#endif
+
+#define FLASH_ACR_LATENCY_Pos               ( 0U )
+#define FLASH_ACR_LATENCY                   ( 0xFU << FLASH_ACR_LATENCY_Pos )
+#define FLASH_ACR_PRFTEN                    ( 1U << 8 )
+#define FLASH_ACR_ICEN                      ( 1U << 9 )
+#define FLASH_ACR_DCEN                      ( 1U << 10 )
+#define FLASH_ACR_ICRST                     ( 1U << 11 )
+#define FLASH_ACR_DCRST                     ( 1U << 12 )
+#define FLASH_LATENCY_0                     ( 0U )
+#define SYSCFG_MEMRMP_FB_MODE               ( 1U << 8 )
+
+#define FLASH_IT_EOP                        ( FLASH_CR_EOPIE )
+#define FLASH_IT_OPERR                      ( FLASH_CR_ERRIE )
+#define FLASH_IT_ECCC                       ( FLASH_ECCR_ECCCIE )
+#define FLASH_TIMEOUT_VALUE                 ( 1000U )
+
+#define OPTIONBYTE_USER                     ( 0x04U )
+#if defined( FLASH_OPTR_DBANK )
+    #define OB_USER_DBANK                   ( 0x400000U )
+    #define OB_DBANK_128_BITS               ( 0U )
+    #define OB_DBANK_64_BITS                ( FLASH_OPTR_DBANK )
+#endif
+#define OB_RDP                              ( 0x02U )
+#define OPTIONBYTE_WRP                      ( 0x01U )
+
+/**
+ *  HAL error codes equal status register bits
+ */
+#define HAL_FLASH_ERROR_NONE                ( 0U )
+#define HAL_FLASH_ERROR_OP                  ( FLASH_SR_OPERR )
+#define HAL_FLASH_ERROR_PROG                ( FLASH_SR_PROGERR )
+#define HAL_FLASH_ERROR_WRP                 ( FLASH_SR_WRPERR )
+#define HAL_FLASH_ERROR_PGA                 ( FLASH_SR_PGAERR )
+#define HAL_FLASH_ERROR_SIZ                 ( FLASH_SR_SIZERR )
+#define HAL_FLASH_ERROR_PGS                 ( FLASH_SR_PGSERR )
+#define HAL_FLASH_ERROR_MIS                 ( FLASH_SR_MISERR )
+#define HAL_FLASH_ERROR_FAST                ( FLASH_SR_FASTERR )
+#define HAL_FLASH_ERROR_ECCD                ( FLASH_FLAG_ECCD )
+
+#define PWR_REGULATOR_VOLTAGE_SCALE1_BOOST  ( 0x100U )
+#define PWR_REGULATOR_VOLTAGE_SCALE1        ( 0x200U )
+#define PWR_REGULATOR_VOLTAGE_SCALE2        ( 0x400U )
+
+#define FLASH_IRQn                          ( 4 )
+#define NonMaskableInt_IRQn                 ( -14 )
+#define DWT_CTRL_CYCCNTENA_Msk              ( 1U )
+#define CoreDebug_DEMCR_TRCENA_Msk          ( 1U << 24 )
+
+/**
+ *  Register access, routed to simulator
+ */
+void        flash_sim_reg_write (__IO uint32_t * const p_reg, const uint32_t val);
+uint32_t    flash_sim_reg_read  (__IO uint32_t * const p_reg);
+void        flash_sim_reg_set   (__IO uint32_t * const p_reg, const uint32_t bits);
+
+#define READ_REG(reg)                       flash_sim_reg_read( &( reg ))
+#define WRITE_REG(reg,val)                  flash_sim_reg_write( &( reg ), ( val ))
+#define SET_BIT(reg,bits)                   flash_sim_reg_set( &( reg ), ( bits ))
+#define CLEAR_BIT(reg,bits)                 (( reg ) &= ~( bits ))
+#define READ_BIT(reg,bits)                  (( reg ) & ( bits ))
+#define MODIFY_REG(reg,clr,set)             (( reg ) = ((( reg ) & ~( clr )) | ( set )))
+
+#define __HAL_FLASH_GET_FLAG(flag)          (( READ_REG( FLASH->SR ) & ( flag )) == ( flag ))
+#define __HAL_FLASH_CLEAR_FLAG(flag)        WRITE_REG( FLASH->SR, (( flag ) & FLASH_FLAG_SR_ERRORS ) | FLASH_SR_EOP )
+#define __HAL_FLASH_ENABLE_IT(it)           SET_BIT( FLASH->CR, ( it ))
+#define __HAL_FLASH_DISABLE_IT(it)          CLEAR_BIT( FLASH->CR, ( it ))
+#define __HAL_FLASH_GET_LATENCY()           ( READ_BIT( FLASH->ACR, FLASH_ACR_LATENCY ))
+#define __HAL_FLASH_SET_LATENCY(lat)        MODIFY_REG( FLASH->ACR, FLASH_ACR_LATENCY, ( lat ))
+#define __HAL_FLASH_INSTRUCTION_CACHE_ENABLE()  SET_BIT( FLASH->ACR, FLASH_ACR_ICEN )
+#define __HAL_FLASH_INSTRUCTION_CACHE_DISABLE() CLEAR_BIT( FLASH->ACR, FLASH_ACR_ICEN )
+#define __HAL_FLASH_INSTRUCTION_CACHE_RESET()   do { SET_BIT( FLASH->ACR, FLASH_ACR_ICRST ); CLEAR_BIT( FLASH->ACR, FLASH_ACR_ICRST ); } while ( 0 )
+#define __HAL_FLASH_DATA_CACHE_ENABLE()         SET_BIT( FLASH->ACR, FLASH_ACR_DCEN )
+#define __HAL_FLASH_DATA_CACHE_DISABLE()        CLEAR_BIT( FLASH->ACR, FLASH_ACR_DCEN )
+#define __HAL_FLASH_DATA_CACHE_RESET()          do { SET_BIT( FLASH->ACR, FLASH_ACR_DCRST ); CLEAR_BIT( FLASH->ACR, FLASH_ACR_DCRST ); } while ( 0 )
+#define __HAL_FLASH_PREFETCH_BUFFER_ENABLE()    SET_BIT( FLASH->ACR, FLASH_ACR_PRFTEN )
+#define __HAL_FLASH_PREFETCH_BUFFER_DISABLE()   CLEAR_BIT( FLASH->ACR, FLASH_ACR_PRFTEN )
+#define __HAL_RCC_FLASH_CLK_ENABLE()        do {} while ( 0 )
+#define __HAL_RCC_FLASH_CLK_DISABLE()       do {} while ( 0 )
+
+#define __DMB()                             __sync_synchronize()
+#define __DSB()                             __sync_synchronize()
+#define __ISB()                             __sync_synchronize()
+#define __disable_irq()                     do {} while ( 0 )
+#define __enable_irq()                      do {} while ( 0 )
+#define __NOP()                             do {} while ( 0 )
+#define __WFI()                             do {} while ( 0 )
+
+extern uint32_t SystemCoreClock;
+
+static inline uint32_t __get_PRIMASK(void)
+{
+    return 0U;
+}
+
+static inline void __set_PRIMASK(const uint32_t primask)
+{
+    (void) primask;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+HAL_StatusTypeDef   HAL_FLASH_Unlock                    (void);
+HAL_StatusTypeDef   HAL_FLASH_Lock                      (void);
+HAL_StatusTypeDef   HAL_FLASH_OB_Unlock                 (void);
+HAL_StatusTypeDef   HAL_FLASH_OB_Lock                   (void);
+HAL_StatusTypeDef   HAL_FLASH_OB_Launch                 (void);
+HAL_StatusTypeDef   HAL_FLASH_Program                   (uint32_t TypeProgram, uint32_t Address, uint64_t Data);
+HAL_StatusTypeDef   HAL_FLASH_Program_IT                (uint32_t TypeProgram, uint32_t Address, uint64_t Data);
+HAL_StatusTypeDef   HAL_FLASHEx_Erase                   (FLASH_EraseInitTypeDef * pEraseInit, uint32_t * PageError);
+HAL_StatusTypeDef   HAL_FLASHEx_Erase_IT                (FLASH_EraseInitTypeDef * pEraseInit);
+HAL_StatusTypeDef   HAL_FLASHEx_OBProgram               (FLASH_OBProgramInitTypeDef * pOBInit);
+void                HAL_FLASHEx_OBGetConfig             (FLASH_OBProgramInitTypeDef * pOBInit);
+HAL_StatusTypeDef   FLASH_WaitForLastOperation          (uint32_t Timeout);
+uint32_t            HAL_FLASH_GetError                  (void);
+void                HAL_FLASH_IRQHandler                (void);
+void                HAL_FLASH_EndOfOperationCallback    (uint32_t ReturnValue);
+void                HAL_FLASH_OperationErrorCallback    (uint32_t ReturnValue);
+uint32_t            HAL_GetTick                         (void);
+uint32_t            HAL_RCC_GetHCLKFreq                 (void);
+uint32_t            HAL_PWREx_GetVoltageRange           (void);
+void                HAL_NVIC_SetPriority                (int IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void                HAL_NVIC_EnableIRQ                  (int IRQn);
+void                HAL_NVIC_DisableIRQ                 (int IRQn);
+
+#endif // __STM32G4XX_HAL_STUB_H
@@ -0,0 +1,3 @@
+#pragma once
+void vTaskDelay(TickType_t);
+TickType_t xTaskGetTickCount(void);
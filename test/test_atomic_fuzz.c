@@ -0,0 +1,319 @@
+// Copyright (c) 2026  Ziga Miklosic
+// All Rights Reserved
+////////////////////////////////////////////////////////////////////////////////
+/**
+*@file      test_atomic_fuzz.c
+*@brief     Atomic slot update under random power cuts
+*@author    Ziga Miklosic
+*@email		ziga.miklosic@gmail.si
+*@date      16.10.2026
+*@version   V0.2.0
+*
+*@note      Each round writes new version of random size and content to
+*           random slot and cuts power at random cut point of the write,
+*           torn double words raise ECC NMI when read. Every eighth write
+*           completes. Next boot mounts slots and must find complete old
+*           or complete new version in updated slot and untouched content
+*           in the other, without unhandled NMI or reported ECC error.
+*           Following round writes over torn shadow page.
+*/
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "flash.h"
+#include "flash_sim.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define TEST_ATOMIC_ROUND_NUM               ( 400U )
+#define TEST_ATOMIC_SLOT_NUM                ( 2U )
+
+/**
+ *  Mount boot result: slot holds old or new version
+ */
+#define TEST_ATOMIC_OLD                     ( 10 )
+#define TEST_ATOMIC_NEW                     ( 11 )
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ *  Committed version of each slot, 0 when never written
+ */
+static uint32_t g_ver[TEST_ATOMIC_SLOT_NUM] = { 0 };
+
+/**
+ *  Round under test
+ */
+static uint32_t gu32_slot   = 0U;
+static uint32_t gu32_new    = 0U;
+static uint32_t gu32_cut_at = 0U;
+
+/**
+ *  Cut points of write, shared with boot as it exceeds exit code range
+ */
+static volatile uint32_t * gp_op_num = NULL;
+
+static uint8_t  g_data[FLASH_ATOMIC_DATA_SIZE];
+static uint8_t  g_rd[FLASH_ATOMIC_DATA_SIZE];
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Generate content of version
+*
+* @param[in]    ver     - Version
+* @param[out]   p_data  - Content, erased value past size
+* @return       size of version in bytes
+*/
+////////////////////////////////////////////////////////////////////////////////
+static uint32_t test_atomic_version(const uint32_t ver, uint8_t * const p_data)
+{
+    uint32_t seed = (( ver * 2654435761U ) | 1U );
+    uint32_t size = 0U;
+
+    seed ^= ( seed << 13 ); seed ^= ( seed >> 17 ); seed ^= ( seed << 5 );
+    size = (( seed % FLASH_ATOMIC_DATA_SIZE ) + 1U );
+
+    memset( p_data, 0xFF, FLASH_ATOMIC_DATA_SIZE );
+
+    for ( uint32_t i = 0U; i < size; i++ )
+    {
+        seed ^= ( seed << 13 ); seed ^= ( seed >> 17 ); seed ^= ( seed << 5 );
+        p_data[i] = (uint8_t) seed;
+    }
+
+    return size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Check content of slot
+*
+* @param[in]    slot    - Atomic slot
+* @param[in]    ver     - Expected version
+* @return       true if slot holds version
+*/
+////////////////////////////////////////////////////////////////////////////////
+static bool test_atomic_is_ver(const uint32_t slot, const uint32_t ver)
+{
+    bool is_ver = false;
+
+    if ( 0U == ver )
+    {
+        is_ver = ( eFLASH_ERROR == flash_atomic_read( slot, FLASH_ATOMIC_DATA_SIZE, g_rd ));
+    }
+    else if ( eFLASH_OK == flash_atomic_read( slot, FLASH_ATOMIC_DATA_SIZE, g_rd ))
+    {
+        (void) test_atomic_version( ver, g_data );
+        is_ver = ( 0 == memcmp( g_rd, g_data, FLASH_ATOMIC_DATA_SIZE ));
+    }
+    else
+    {
+        // No actions...
+    }
+
+    return is_ver;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       NMI handler of booted device
+*
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void test_atomic_nmi(void)
+{
+    bool is_ecc = false;
+
+    (void) flash_ecc_nmi_hndl( &is_ecc );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Power cut callback
+*
+* @param[in]    addr    - Address of operation in progress
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void test_atomic_power_cut(const uint32_t addr)
+{
+    flash_sim_power_cut( addr );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Boot: write new version with power cut armed
+*
+* @return       0 when write completed without cut
+*/
+////////////////////////////////////////////////////////////////////////////////
+static int test_atomic_boot_cut(void)
+{
+    const uint32_t size = test_atomic_version( gu32_new, g_data );
+
+    srand( gu32_new );
+
+    FLASH_SIM_CHECK( eFLASH_OK == flash_init());
+    FLASH_SIM_CHECK( eFLASH_OK == flash_fault_arm( gu32_cut_at, test_atomic_power_cut ));
+
+    return (( eFLASH_OK == flash_atomic_write( gu32_slot, size, g_data )) ? 0 : 1 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Boot: count cut points of write
+*
+* @return       0 on success
+*/
+////////////////////////////////////////////////////////////////////////////////
+static int test_atomic_boot_count(void)
+{
+    const uint32_t  size = test_atomic_version( gu32_new, g_data );
+    flash_stats_t   before;
+    flash_stats_t   after;
+
+    FLASH_SIM_CHECK( eFLASH_OK == flash_init());
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_stats( &before ));
+    FLASH_SIM_CHECK( eFLASH_OK == flash_atomic_write( gu32_slot, size, g_data ));
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_stats( &after ));
+
+    *gp_op_num = ( after.fault_op_num - before.fault_op_num );
+
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Boot: mount slots and identify version of updated slot
+*
+* @return       TEST_ATOMIC_OLD or TEST_ATOMIC_NEW
+*/
+////////////////////////////////////////////////////////////////////////////////
+static int test_atomic_boot_mount(void)
+{
+    flash_stats_t   stats;
+    int             rc = 1;
+
+    FLASH_SIM_CHECK( eFLASH_OK == flash_init());
+
+    // Other slots untouched
+    for ( uint32_t slot = 0U; slot < TEST_ATOMIC_SLOT_NUM; slot++ )
+    {
+        if ( slot != gu32_slot )
+        {
+            FLASH_SIM_CHECK( test_atomic_is_ver( slot, g_ver[slot] ));
+        }
+    }
+
+    if ( test_atomic_is_ver( gu32_slot, gu32_new ))
+    {
+        rc = TEST_ATOMIC_NEW;
+    }
+    else if ( test_atomic_is_ver( gu32_slot, g_ver[gu32_slot] ))
+    {
+        rc = TEST_ATOMIC_OLD;
+    }
+    else
+    {
+        fprintf( stderr, "slot %u: neither version %u nor %u\n", gu32_slot, g_ver[gu32_slot], gu32_new );
+    }
+
+    // Torn data seen while mounting is not an ECC error
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_stats( &stats ));
+    FLASH_SIM_CHECK( 0U == stats.ecc_uncorr_num );
+
+    return rc;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Test
+*
+* @return       0 on success
+*/
+////////////////////////////////////////////////////////////////////////////////
+static int test_atomic_fuzz(void)
+{
+    flash_sim_stats_t   stats;
+    uint32_t            old_num = 0U;
+    uint32_t            new_num = 0U;
+    uint32_t            cut_num = 0U;
+
+    gp_op_num = mmap( NULL, sizeof( uint32_t ), ( PROT_READ | PROT_WRITE ), ( MAP_SHARED | MAP_ANONYMOUS ), -1, 0 );
+    FLASH_SIM_CHECK( MAP_FAILED != gp_op_num );
+
+    flash_sim_init();
+    flash_sim_nmi_set( test_atomic_nmi );
+    srand( 1U );
+
+    for ( uint32_t round = 0U; round < TEST_ATOMIC_ROUND_NUM; round++ )
+    {
+        int op_num  = 0;
+        int rc      = 0;
+
+        gu32_slot   = ((uint32_t) rand() % TEST_ATOMIC_SLOT_NUM );
+        gu32_new    = ( round + 1U );
+
+        flash_sim_save();
+        FLASH_SIM_CHECK( 0 == flash_sim_boot( test_atomic_boot_count ));
+        op_num = (int) *gp_op_num;
+        FLASH_SIM_CHECK( op_num > 0 );
+        flash_sim_restore();
+
+        // Cut at random point, every fourth round at commit marker and
+        // every eighth past the write
+        if ( 0U == ( round % 8U ))
+        {
+            gu32_cut_at = (uint32_t) op_num;
+            FLASH_SIM_CHECK( 0 == flash_sim_boot( test_atomic_boot_cut ));
+        }
+        else
+        {
+            gu32_cut_at = ( 0U == ( round % 4U )) ? (uint32_t)( op_num - 1 ) : ((uint32_t) rand() % (uint32_t) op_num );
+            FLASH_SIM_CHECK( FLASH_SIM_BOOT_CUT == flash_sim_boot( test_atomic_boot_cut ));
+            cut_num++;
+        }
+
+        rc = flash_sim_boot( test_atomic_boot_mount );
+        FLASH_SIM_CHECK(( TEST_ATOMIC_OLD == rc ) || ( TEST_ATOMIC_NEW == rc ));
+
+        if ( TEST_ATOMIC_NEW == rc )
+        {
+            g_ver[gu32_slot] = gu32_new;
+            new_num++;
+        }
+        else
+        {
+            old_num++;
+        }
+    }
+
+    flash_sim_get_stats( &stats );
+    FLASH_SIM_CHECK( stats.cut_num == cut_num );
+    FLASH_SIM_CHECK( new_num == ( TEST_ATOMIC_ROUND_NUM / 8U ));
+    FLASH_SIM_CHECK( stats.nmi_num > 0U );
+
+    printf( "rounds=%u old=%u new=%u nmi=%u\n", TEST_ATOMIC_ROUND_NUM, old_num, new_num, stats.nmi_num );
+
+    return 0;
+}
+
+int main(void)
+{
+    return flash_sim_run( test_atomic_fuzz );
+}
@@ -0,0 +1,165 @@
+// Copyright (c) 2026  Ziga Miklosic
+// All Rights Reserved
+////////////////////////////////////////////////////////////////////////////////
+/**
+*@file      test_cache.c
+*@brief     Cache suspend and reset once per API call, job step and
+*           scheduler process call
+*@author    Ziga Miklosic
+*@email		ziga.miklosic@gmail.si
+*@date      16.10.2026
+*@version   V0.2.0
+*/
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+
+#include "flash.h"
+#include "flash_sim.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define TEST_CACHE_ADDR                     ( 0x08020000U )
+#define TEST_CACHE_ACR                      ( FLASH_ACR_ICEN | FLASH_ACR_DCEN | FLASH_ACR_PRFTEN )
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+static uint8_t              g_buf[3000];
+static flash_sim_stats_t    g_before;
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Start counting cache resets
+*
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void test_cache_start(void)
+{
+    flash_sim_get_stats( &g_before );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Check cache resets since test_cache_start and restored caches
+*
+* @param[in]    dcache_rst  - Expected data cache resets
+* @param[in]    icache_rst  - Expected instruction cache resets
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void test_cache_check(const uint32_t dcache_rst, const uint32_t icache_rst)
+{
+    flash_sim_stats_t after;
+
+    flash_sim_get_stats( &after );
+
+    FLASH_SIM_CHECK(( after.dcache_rst_num - g_before.dcache_rst_num ) == dcache_rst );
+    FLASH_SIM_CHECK(( after.icache_rst_num - g_before.icache_rst_num ) == icache_rst );
+    FLASH_SIM_CHECK( 0U == after.cached_op_num );
+    FLASH_SIM_CHECK( TEST_CACHE_ACR == ( FLASH->ACR & TEST_CACHE_ACR ));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Test
+*
+* @return       0 on success
+*/
+////////////////////////////////////////////////////////////////////////////////
+static int test_cache(void)
+{
+    flash_iovec_t       iov[3];
+    flash_cmd_t         cmd;
+    flash_sched_req_t   req;
+    bool                is_done = false;
+    uint32_t            step    = 0U;
+    uint32_t            pending = 0U;
+
+    flash_sim_init();
+    FLASH_SIM_CHECK( eFLASH_OK == flash_init());
+    FLASH->ACR |= TEST_CACHE_ACR;
+
+    for ( uint32_t i = 0; i < sizeof( g_buf ); i++ )
+    {
+        g_buf[i] = (uint8_t)( i * 7U );
+    }
+
+    // Unaligned write: head, rows and tail
+    test_cache_start();
+    FLASH_SIM_CHECK( eFLASH_OK == flash_write( TEST_CACHE_ADDR + 8U, 1000U, g_buf ));
+    test_cache_check( 1U, 0U );
+
+    // Gathered write, several program runs
+    iov[0] = (flash_iovec_t) { g_buf, 5U };
+    iov[1] = (flash_iovec_t) { &g_buf[100], 700U };
+    iov[2] = (flash_iovec_t) { &g_buf[1000], 3U };
+    test_cache_start();
+    FLASH_SIM_CHECK( eFLASH_OK == flash_writev( TEST_CACHE_ADDR + 0x800U, iov, 3U ));
+    test_cache_check( 1U, 0U );
+
+    // Erase of several pages
+    test_cache_start();
+    FLASH_SIM_CHECK( eFLASH_OK == flash_erase( TEST_CACHE_ADDR, 3U * FLASH_PAGE_SIZE ));
+    test_cache_check( 1U, 1U );
+
+    test_cache_start();
+    FLASH_SIM_CHECK( eFLASH_OK == flash_fill( TEST_CACHE_ADDR + 16U, 2000U, 0x0123456789ABCDEFULL ));
+    test_cache_check( 1U, 0U );
+
+    test_cache_start();
+    FLASH_SIM_CHECK( eFLASH_OK == flash_copy( TEST_CACHE_ADDR + 0x1000U, TEST_CACHE_ADDR + 16U, 2000U ));
+    test_cache_check( 1U, 0U );
+    FLASH_SIM_CHECK( 0 == memcmp((const void*)(uintptr_t)( TEST_CACHE_ADDR + 0x1000U ), (const void*)(uintptr_t)( TEST_CACHE_ADDR + 16U ), 2000U ));
+
+    // Reads do not touch caches
+    test_cache_start();
+    FLASH_SIM_CHECK( eFLASH_OK == flash_read( TEST_CACHE_ADDR, sizeof( g_buf ), g_buf ));
+    test_cache_check( 0U, 0U );
+
+    // One reset per job step
+    cmd = (flash_cmd_t) { .addr = TEST_CACHE_ADDR + 0x2000U, .size = sizeof( g_buf ), .p_data = g_buf, .type = eFLASH_CMD_WRITE };
+    FLASH_SIM_CHECK( eFLASH_OK == flash_erase( cmd.addr, 2U * FLASH_PAGE_SIZE ));
+    FLASH_SIM_CHECK( eFLASH_OK == flash_job_start( &cmd ));
+
+    test_cache_start();
+
+    while ( false == is_done )
+    {
+        FLASH_SIM_CHECK( eFLASH_OK == flash_job_step( 100U, &is_done ));
+        step++;
+    }
+
+    FLASH_SIM_CHECK( step > 1U );
+    test_cache_check( step, 0U );
+    FLASH_SIM_CHECK( 0 == memcmp((const void*)(uintptr_t) cmd.addr, g_buf, sizeof( g_buf )));
+
+    // One reset per scheduler process call, erase and write together
+    req = (flash_sched_req_t) { .cmd = { .addr = TEST_CACHE_ADDR + 0x4000U, .size = FLASH_PAGE_SIZE, .p_data = NULL, .type = eFLASH_CMD_ERASE }, .prio = eFLASH_PRIO_HIGH };
+    FLASH_SIM_CHECK( eFLASH_OK == flash_sched_submit( &req ));
+    req = (flash_sched_req_t) { .cmd = { .addr = TEST_CACHE_ADDR + 0x4000U, .size = 600U, .p_data = g_buf, .type = eFLASH_CMD_WRITE }, .prio = eFLASH_PRIO_NORMAL };
+    FLASH_SIM_CHECK( eFLASH_OK == flash_sched_submit( &req ));
+
+    test_cache_start();
+    FLASH_SIM_CHECK( eFLASH_OK == flash_sched_process( 1000000U, &pending ));
+    FLASH_SIM_CHECK( 0U == pending );
+    test_cache_check( 1U, 1U );
+    FLASH_SIM_CHECK( 0 == memcmp((const void*)(uintptr_t)( TEST_CACHE_ADDR + 0x4000U ), g_buf, 600U ));
+
+    return 0;
+}
+
+int main(void)
+{
+    return flash_sim_run( test_cache );
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2026  Ziga Miklosic
+// All Rights Reserved
+////////////////////////////////////////////////////////////////////////////////
+/**
+*@file      test_copy.c
+*@brief     Flash to flash copy test
+*@author    Ziga Miklosic
+*@email		ziga.miklosic@gmail.si
+*@date      16.10.2026
+*@version   V0.2.0
+*/
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+
+#include "flash.h"
+#include "flash_sim.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define TEST_COPY_SRC                       ( 0x08040000U )
+#define TEST_COPY_SIZE                      ( 1000U )
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+static uint8_t g_buf[TEST_COPY_SIZE];
+static uint8_t g_flash[4U * TEST_COPY_SIZE];
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Check rejected overlapping copy leaves flash untouched
+*
+* @param[in]    dst     - Destination flash address
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void test_copy_overlap(const uint32_t dst)
+{
+    memcpy( g_flash, (const void*)(uintptr_t) TEST_COPY_SRC, sizeof( g_flash ));
+
+    FLASH_SIM_CHECK( eFLASH_ERROR_OVERLAP == flash_copy( dst, TEST_COPY_SRC + TEST_COPY_SIZE, TEST_COPY_SIZE ));
+    FLASH_SIM_CHECK( 0 == memcmp((const void*)(uintptr_t) TEST_COPY_SRC, g_flash, sizeof( g_flash )));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Test
+*
+* @return       0 on success
+*/
+////////////////////////////////////////////////////////////////////////////////
+static int test_copy(void)
+{
+    flash_stats_t before;
+    flash_stats_t after;
+
+    flash_sim_init();
+    FLASH_SIM_CHECK( eFLASH_OK == flash_init());
+
+    for ( uint32_t i = 0; i < sizeof( g_buf ); i++ )
+    {
+        g_buf[i] = (uint8_t)(( i * 11U ) + 3U );
+    }
+
+    FLASH_SIM_CHECK( eFLASH_OK == flash_write( TEST_COPY_SRC + TEST_COPY_SIZE, TEST_COPY_SIZE, g_buf ));
+
+    // Destination adjacent to source, below and above
+    FLASH_SIM_CHECK( eFLASH_OK == flash_copy( TEST_COPY_SRC, TEST_COPY_SRC + TEST_COPY_SIZE, TEST_COPY_SIZE ));
+    FLASH_SIM_CHECK( 0 == memcmp((const void*)(uintptr_t) TEST_COPY_SRC, g_buf, TEST_COPY_SIZE ));
+
+    FLASH_SIM_CHECK( eFLASH_OK == flash_copy( TEST_COPY_SRC + ( 2U * TEST_COPY_SIZE ), TEST_COPY_SRC + TEST_COPY_SIZE, TEST_COPY_SIZE ));
+    FLASH_SIM_CHECK( 0 == memcmp((const void*)(uintptr_t)( TEST_COPY_SRC + ( 2U * TEST_COPY_SIZE )), g_buf, TEST_COPY_SIZE ));
+
+    // Destination already holds data, all rows skipped
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_stats( &before ));
+    FLASH_SIM_CHECK( eFLASH_OK == flash_copy( TEST_COPY_SRC, TEST_COPY_SRC + TEST_COPY_SIZE, TEST_COPY_SIZE ));
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_stats( &after ));
+    FLASH_SIM_CHECK(( after.copy_skip_num - before.copy_skip_num ) > 0U );
+    FLASH_SIM_CHECK(( after.program_unit_num == before.program_unit_num ) && ( after.program_row_num == before.program_row_num ));
+
+    // Overlapping ranges rejected: destination below, above and equal to source
+    FLASH_SIM_CHECK( eFLASH_OK == flash_erase( TEST_COPY_SRC, FLASH_CFG_PAGE_SIZE_BYTE ));
+    FLASH_SIM_CHECK( eFLASH_OK == flash_write( TEST_COPY_SRC + TEST_COPY_SIZE, TEST_COPY_SIZE, g_buf ));
+
+    test_copy_overlap( TEST_COPY_SRC + 8U );
+    test_copy_overlap( TEST_COPY_SRC + ( 2U * TEST_COPY_SIZE ) - 8U );
+    test_copy_overlap( TEST_COPY_SRC + TEST_COPY_SIZE );
+
+    return 0;
+}
+
+int main(void)
+{
+    return flash_sim_run( test_copy );
+}
@@ -0,0 +1,257 @@
+// Copyright (c) 2026  Ziga Miklosic
+// All Rights Reserved
+////////////////////////////////////////////////////////////////////////////////
+/**
+*@file      test_cut_replay.c
+*@brief     Power cut replay over every cut point of erase and write
+*@author    Ziga Miklosic
+*@email		ziga.miklosic@gmail.si
+*@date      16.10.2026
+*@version   V0.2.0
+*
+*@note      Scenario erases two pages and writes first one. Scenario is
+*           run once to count cut points (fault_op_num), then replayed
+*           from the same initial flash content with power cut at every
+*           cut point N. After each cut flash must hold exactly N complete
+*           operations followed by torn one, and next boot must recover
+*           by repeating scenario.
+*/
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flash.h"
+#include "flash_sim.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define TEST_CUT_ADDR                       ( 0x08020000U )
+#define TEST_CUT_ERASE_SIZE                 ( 2U * FLASH_PAGE_SIZE )
+#define TEST_CUT_WRITE_SIZE                 ( 1024U )
+#define TEST_CUT_ERASE_OP_NUM               ( TEST_CUT_ERASE_SIZE / FLASH_PAGE_SIZE )
+#define TEST_CUT_WRITE_OP_NUM               ( TEST_CUT_WRITE_SIZE / sizeof( uint64_t ))
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+static uint64_t g_old[TEST_CUT_ERASE_SIZE / sizeof( uint64_t )];
+static uint64_t g_new[TEST_CUT_WRITE_SIZE / sizeof( uint64_t )];
+static uint32_t gu32_cut_at = 0U;
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Power cut callback
+*
+* @param[in]    addr    - Address of operation in progress
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void test_cut_power_cut(const uint32_t addr)
+{
+    flash_sim_power_cut( addr );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Scenario: erase region and write new data
+*
+* @return       status of operation
+*/
+////////////////////////////////////////////////////////////////////////////////
+static flash_status_t test_cut_scenario(void)
+{
+    flash_status_t status = flash_erase( TEST_CUT_ADDR, TEST_CUT_ERASE_SIZE );
+
+    if ( eFLASH_OK == status )
+    {
+        status = flash_write( TEST_CUT_ADDR, TEST_CUT_WRITE_SIZE, (const uint8_t*) g_new );
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Boot: count cut points of scenario
+*
+* @return       number of cut points
+*/
+////////////////////////////////////////////////////////////////////////////////
+static int test_cut_boot_count(void)
+{
+    flash_stats_t before;
+    flash_stats_t after;
+
+    FLASH_SIM_CHECK( eFLASH_OK == flash_init());
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_stats( &before ));
+    FLASH_SIM_CHECK( eFLASH_OK == test_cut_scenario());
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_stats( &after ));
+
+    return (int)( after.fault_op_num - before.fault_op_num );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Boot: run scenario with power cut armed
+*
+* @return       0 when scenario completed without cut
+*/
+////////////////////////////////////////////////////////////////////////////////
+static int test_cut_boot_cut(void)
+{
+    srand( gu32_cut_at + 1U );
+
+    FLASH_SIM_CHECK( eFLASH_OK == flash_init());
+    FLASH_SIM_CHECK( eFLASH_OK == flash_fault_arm( gu32_cut_at, test_cut_power_cut ));
+
+    return (( eFLASH_OK == test_cut_scenario()) ? 0 : 1 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Boot: recover by repeating scenario
+*
+* @return       0 on success
+*/
+////////////////////////////////////////////////////////////////////////////////
+static int test_cut_boot_recover(void)
+{
+    FLASH_SIM_CHECK( eFLASH_OK == flash_init());
+    FLASH_SIM_CHECK( eFLASH_OK == test_cut_scenario());
+    FLASH_SIM_CHECK( 0 == memcmp((const void*)(uintptr_t) TEST_CUT_ADDR, g_new, TEST_CUT_WRITE_SIZE ));
+
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Check flash content after power cut
+*
+* @param[in]    cut     - Cut point
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void test_cut_check(const uint32_t cut)
+{
+    const uint64_t * const  p_flash     = (const uint64_t*)(uintptr_t) TEST_CUT_ADDR;
+    const uint32_t          page_dw_num = ( FLASH_PAGE_SIZE / sizeof( uint64_t ));
+    uint32_t                torn_num    = 0U;
+
+    for ( uint32_t dw = 0U; dw < ( TEST_CUT_ERASE_SIZE / sizeof( uint64_t )); dw++ )
+    {
+        const uint32_t  page        = ( dw / page_dw_num );
+        const uint32_t  addr        = TEST_CUT_ADDR + ( dw * sizeof( uint64_t ));
+        const bool      is_corrupt  = flash_sim_is_corrupt( addr );
+
+        // Page erase in progress: erased or torn
+        if ( page == cut )
+        {
+            FLASH_SIM_CHECK(( UINT64_MAX == p_flash[dw] ) != is_corrupt );
+            torn_num += ( is_corrupt ? 1U : 0U );
+        }
+
+        // Page not erased yet
+        else if ( page > cut )
+        {
+            FLASH_SIM_CHECK(( g_old[dw] == p_flash[dw] ) && ( false == is_corrupt ));
+        }
+
+        // Programmed
+        else if (( dw + TEST_CUT_ERASE_OP_NUM ) < cut )
+        {
+            FLASH_SIM_CHECK(( g_new[dw] == p_flash[dw] ) && ( false == is_corrupt ));
+        }
+
+        // Program in progress: subset of bits programmed
+        else if (( dw + TEST_CUT_ERASE_OP_NUM ) == cut )
+        {
+            FLASH_SIM_CHECK( true == is_corrupt );
+            FLASH_SIM_CHECK( g_new[dw] == ( p_flash[dw] & g_new[dw] ));
+            FLASH_SIM_CHECK( g_new[dw] != p_flash[dw] );
+            torn_num++;
+        }
+
+        // Not programmed yet
+        else
+        {
+            FLASH_SIM_CHECK(( UINT64_MAX == p_flash[dw] ) && ( false == is_corrupt ));
+        }
+    }
+
+    FLASH_SIM_CHECK( torn_num > 0U );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Test
+*
+* @return       0 on success
+*/
+////////////////////////////////////////////////////////////////////////////////
+static int test_cut_replay(void)
+{
+    flash_sim_stats_t   stats;
+    int                 op_num = 0;
+
+    flash_sim_init();
+
+    for ( uint32_t i = 0U; i < ( sizeof( g_old ) / sizeof( g_old[0] )); i++ )
+    {
+        g_old[i] = ( 0x0123456789ABCDEFULL ^ ((uint64_t) i * 0x9E3779B97F4A7C15ULL ));
+    }
+
+    for ( uint32_t i = 0U; i < ( sizeof( g_new ) / sizeof( g_new[0] )); i++ )
+    {
+        g_new[i] = ( 0x5AA5C33C0FF0F00FULL ^ ((uint64_t) i << 17 ));
+    }
+
+    // Initial content
+    memcpy((void*)(uintptr_t) TEST_CUT_ADDR, g_old, sizeof( g_old ));
+    flash_sim_save();
+
+    op_num = flash_sim_boot( test_cut_boot_count );
+    FLASH_SIM_CHECK( op_num == ( TEST_CUT_ERASE_OP_NUM + TEST_CUT_WRITE_OP_NUM ));
+
+    // Cut at every cut point
+    for ( gu32_cut_at = 0U; gu32_cut_at < (uint32_t) op_num; gu32_cut_at++ )
+    {
+        flash_sim_restore();
+
+        FLASH_SIM_CHECK( FLASH_SIM_BOOT_CUT == flash_sim_boot( test_cut_boot_cut ));
+        test_cut_check( gu32_cut_at );
+
+        FLASH_SIM_CHECK( 0 == flash_sim_boot( test_cut_boot_recover ));
+
+        for ( uint32_t addr = TEST_CUT_ADDR; addr < ( TEST_CUT_ADDR + TEST_CUT_ERASE_SIZE ); addr += sizeof( uint64_t ))
+        {
+            FLASH_SIM_CHECK( false == flash_sim_is_corrupt( addr ));
+        }
+    }
+
+    // Cut point past scenario is never reached
+    flash_sim_restore();
+    FLASH_SIM_CHECK( 0 == flash_sim_boot( test_cut_boot_cut ));
+    FLASH_SIM_CHECK( 0 == memcmp((const void*)(uintptr_t) TEST_CUT_ADDR, g_new, sizeof( g_new )));
+
+    flash_sim_get_stats( &stats );
+    FLASH_SIM_CHECK( stats.cut_num == (uint32_t) op_num );
+
+    printf( "cut points=%d\n", op_num );
+
+    return 0;
+}
+
+int main(void)
+{
+    return flash_sim_run( test_cut_replay );
+}
@@ -0,0 +1,221 @@
+// Copyright (c) 2026  Ziga Miklosic
+// All Rights Reserved
+////////////////////////////////////////////////////////////////////////////////
+/**
+*@file      test_ecc_remap.c
+*@brief     ECC page relocation and remap table validation test
+*@author    Ziga Miklosic
+*@email		ziga.miklosic@gmail.si
+*@date      16.10.2026
+*@version   V0.2.0
+*/
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+
+#include "flash.h"
+#include "flash_sim.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ *  Remap area of template configuration: table page and 3 spare pages
+ */
+#define TEST_ECC_TABLE_ADDR                 ( 0x0807C000U )
+#define TEST_ECC_SPARE_ADDR(n)              ( TEST_ECC_TABLE_ADDR + ((( n ) + 1U ) * FLASH_CFG_PAGE_SIZE_BYTE ))
+#define TEST_ECC_ENTRY_SIZE                 ( 16U )
+
+/**
+ *  Pages with corrected errors
+ */
+#define TEST_ECC_PAGE_A                     ( 0x08010000U )
+#define TEST_ECC_PAGE_B                     ( 0x08014000U )
+
+/**
+ *  Remap table entry, as stored in flash
+ */
+typedef struct
+{
+    uint32_t page;
+    uint32_t spare;
+    uint32_t seq;
+    uint32_t check;
+} test_ecc_entry_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+static uint8_t g_buf[FLASH_CFG_PAGE_SIZE_BYTE];
+static uint8_t g_rd[FLASH_CFG_PAGE_SIZE_BYTE];
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Report corrected ECC error at address and relocate its page
+*
+* @param[in]    addr    - Flash address
+* @return       status of relocation
+*/
+////////////////////////////////////////////////////////////////////////////////
+static flash_status_t test_ecc_correct(const uint32_t addr)
+{
+    FLASH->ECCR = ( FLASH_ECCR_ECCC | ( addr - FLASH_BASE ));
+    FLASH_IRQHandler();
+    FLASH->ECCR = 0U;
+
+    return flash_ecc_hndl();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Reload remap table and get number of relocated pages
+*
+* @return       number of relocated pages
+*/
+////////////////////////////////////////////////////////////////////////////////
+static uint32_t test_ecc_reload(void)
+{
+    flash_ecc_info_t info;
+
+    FLASH_SIM_CHECK( eFLASH_OK == flash_deinit());
+    FLASH_SIM_CHECK( eFLASH_OK == flash_init());
+    FLASH_SIM_CHECK( eFLASH_OK == flash_ecc_get_info( &info ));
+
+    return info.remap_num;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Place crafted entry into table slot, bypassing driver
+*
+* @param[in]    slot    - Table slot
+* @param[in]    page    - Relocated page
+* @param[in]    spare   - Spare page
+* @param[in]    seq     - Sequence number
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void test_ecc_entry_put(const uint32_t slot, const uint32_t page, const uint32_t spare, const uint32_t seq)
+{
+    test_ecc_entry_t * const p_entry = (test_ecc_entry_t*)(uintptr_t)( TEST_ECC_TABLE_ADDR + ( slot * TEST_ECC_ENTRY_SIZE ));
+
+    p_entry->page   = page;
+    p_entry->spare  = spare;
+    p_entry->seq    = seq;
+    p_entry->check  = ~( page ^ spare ^ seq );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Erase remap area, drops all relocations
+*
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void test_ecc_table_clear(void)
+{
+    FLASH_SIM_CHECK( eFLASH_OK == flash_erase( TEST_ECC_TABLE_ADDR, 4U * FLASH_CFG_PAGE_SIZE_BYTE ));
+    FLASH_SIM_CHECK( 0U == test_ecc_reload());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Test
+*
+* @return       0 on success
+*/
+////////////////////////////////////////////////////////////////////////////////
+static int test_ecc_remap(void)
+{
+    flash_error_t   error;
+    bool            is_ecc = false;
+
+    flash_sim_init();
+    FLASH_SIM_CHECK( eFLASH_OK == flash_init());
+
+    for ( uint32_t i = 0; i < sizeof( g_buf ); i++ )
+    {
+        g_buf[i] = (uint8_t)(( i * 13U ) + 5U );
+    }
+
+    // Relocation keeps content, spare page holds copy
+    FLASH_SIM_CHECK( eFLASH_OK == flash_write( TEST_ECC_PAGE_A, sizeof( g_buf ), g_buf ));
+    FLASH_SIM_CHECK( eFLASH_OK == test_ecc_correct( TEST_ECC_PAGE_A + 0x100U ));
+    FLASH_SIM_CHECK( eFLASH_OK == flash_read( TEST_ECC_PAGE_A, sizeof( g_rd ), g_rd ));
+    FLASH_SIM_CHECK( 0 == memcmp( g_rd, g_buf, sizeof( g_buf )));
+    FLASH_SIM_CHECK( 0 == memcmp((const void*)(uintptr_t) TEST_ECC_SPARE_ADDR( 0U ), g_buf, sizeof( g_buf )));
+
+    // Erase and write are redirected to spare page
+    FLASH_SIM_CHECK( eFLASH_OK == flash_erase( TEST_ECC_PAGE_A, FLASH_CFG_PAGE_SIZE_BYTE ));
+    FLASH_SIM_CHECK( 0xFFFFFFFFU == *(const uint32_t*)(uintptr_t) TEST_ECC_SPARE_ADDR( 0U ));
+    FLASH_SIM_CHECK( eFLASH_OK == flash_write( TEST_ECC_PAGE_A - 0x100U, 1024U, &g_buf[100] ));
+    FLASH_SIM_CHECK( eFLASH_OK == flash_read( TEST_ECC_PAGE_A - 0x100U, 1024U, g_rd ));
+    FLASH_SIM_CHECK( 0 == memcmp( g_rd, &g_buf[100], 1024U ));
+    FLASH_SIM_CHECK( 0 == memcmp((const void*)(uintptr_t) TEST_ECC_SPARE_ADDR( 0U ), &g_buf[356], 768U ));
+
+    // Table survives reset
+    FLASH_SIM_CHECK( 1U == test_ecc_reload());
+
+    // Torn entry is skipped, but its slot and spare page stay used
+    test_ecc_entry_put( 1U, TEST_ECC_PAGE_B, TEST_ECC_SPARE_ADDR( 1U ), 1U );
+    *(uint64_t*)(uintptr_t)( TEST_ECC_TABLE_ADDR + TEST_ECC_ENTRY_SIZE + 8U ) = UINT64_MAX;
+    FLASH_SIM_CHECK( 1U == test_ecc_reload());
+
+    FLASH_SIM_CHECK( eFLASH_OK == flash_write( TEST_ECC_PAGE_B, sizeof( g_buf ), g_buf ));
+    FLASH_SIM_CHECK( eFLASH_OK == test_ecc_correct( TEST_ECC_PAGE_B ));
+    FLASH_SIM_CHECK( 2U == test_ecc_reload());
+    FLASH_SIM_CHECK( 0 == memcmp((const void*)(uintptr_t) TEST_ECC_SPARE_ADDR( 2U ), g_buf, sizeof( g_buf )));
+
+    // No spare page left
+    FLASH_SIM_CHECK( eFLASH_ERROR == test_ecc_correct( TEST_ECC_PAGE_B + FLASH_CFG_PAGE_SIZE_BYTE ));
+    FLASH_SIM_CHECK( 2U == test_ecc_reload());
+
+    // Entries redirecting outside of user region or into remap area are rejected
+    test_ecc_table_clear();
+    test_ecc_entry_put( 0U, TEST_ECC_PAGE_B + 0x10U, TEST_ECC_SPARE_ADDR( 0U ), 0U );
+    FLASH_SIM_CHECK( 0U == test_ecc_reload());
+
+    test_ecc_table_clear();
+    test_ecc_entry_put( 0U, FLASH_BASE, TEST_ECC_SPARE_ADDR( 0U ), 0U );
+    FLASH_SIM_CHECK( 0U == test_ecc_reload());
+
+    test_ecc_table_clear();
+    test_ecc_entry_put( 0U, TEST_ECC_SPARE_ADDR( 1U ), TEST_ECC_SPARE_ADDR( 0U ), 0U );
+    FLASH_SIM_CHECK( 0U == test_ecc_reload());
+
+    test_ecc_table_clear();
+    test_ecc_entry_put( 0U, TEST_ECC_PAGE_B, TEST_ECC_SPARE_ADDR( 1U ), 0U );
+    FLASH_SIM_CHECK( 0U == test_ecc_reload());
+
+    test_ecc_table_clear();
+    test_ecc_entry_put( 0U, TEST_ECC_PAGE_B, TEST_ECC_SPARE_ADDR( 0U ), 5U );
+    FLASH_SIM_CHECK( 0U == test_ecc_reload());
+
+    test_ecc_table_clear();
+    test_ecc_entry_put( 0U, TEST_ECC_PAGE_B, TEST_ECC_SPARE_ADDR( 0U ), 0U );
+    FLASH_SIM_CHECK( 1U == test_ecc_reload());
+
+    // Uncorrectable error reported via NMI
+    FLASH->ECCR = ( FLASH_ECCR_ECCD | 0x10200U );
+    FLASH_SIM_CHECK( eFLASH_OK == flash_ecc_nmi_hndl( &is_ecc ));
+    FLASH->ECCR = 0U;
+    FLASH_SIM_CHECK( true == is_ecc );
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_error( &error ));
+    FLASH_SIM_CHECK(( eFLASH_ERROR_ECC == error.status ) && ( 0x08010200U == error.addr ));
+
+    return 0;
+}
+
+int main(void)
+{
+    return flash_sim_run( test_ecc_remap );
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2026  Ziga Miklosic
+// All Rights Reserved
+////////////////////////////////////////////////////////////////////////////////
+/**
+*@file      test_fill.c
+*@brief     Pattern fill test: head, complete rows and tail
+*@author    Ziga Miklosic
+*@email		ziga.miklosic@gmail.si
+*@date      16.10.2026
+*@version   V0.2.0
+*/
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+
+#include "flash.h"
+#include "flash_sim.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ *  Fill with 240 byte head, 6 complete rows and 228 byte tail
+ */
+#define TEST_FILL_ADDR                      ( 0x08040010U )
+#define TEST_FILL_SIZE                      ( 2004U )
+#define TEST_FILL_ROW_NUM                   ( 6U )
+#define TEST_FILL_PATTERN                   ( 0x0123456789ABCDEFULL )
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Check filled range, last partial unit padded with erased value
+*
+* @param[in]    pattern - Double word pattern
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void test_fill_check(const uint64_t pattern)
+{
+    const uint8_t * const p_flash = (const uint8_t*)(uintptr_t) TEST_FILL_ADDR;
+
+    for ( uint32_t i = 0U; i < TEST_FILL_SIZE; i++ )
+    {
+        FLASH_SIM_CHECK( p_flash[i] == (uint8_t)( pattern >> (( i % 8U ) * 8U )));
+    }
+
+    FLASH_SIM_CHECK( 0xFFFFFFFFU == *(const uint32_t*)(uintptr_t)( TEST_FILL_ADDR + TEST_FILL_SIZE ));
+    FLASH_SIM_CHECK( 0xFFFFFFFFU == *(const uint32_t*)(uintptr_t)( TEST_FILL_ADDR - 4U ));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Test
+*
+* @return       0 on success
+*/
+////////////////////////////////////////////////////////////////////////////////
+static int test_fill(void)
+{
+    flash_stats_t before;
+    flash_stats_t after;
+
+    flash_sim_init();
+    FLASH_SIM_CHECK( eFLASH_OK == flash_init());
+
+    // Erased rows fast programmed
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_stats( &before ));
+    FLASH_SIM_CHECK( eFLASH_OK == flash_fill( TEST_FILL_ADDR, TEST_FILL_SIZE, TEST_FILL_PATTERN ));
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_stats( &after ));
+    FLASH_SIM_CHECK(( after.program_row_num - before.program_row_num ) == TEST_FILL_ROW_NUM );
+    test_fill_check( TEST_FILL_PATTERN );
+
+    // Zero invalidation over data, rows programmed unit by unit
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_stats( &before ));
+    FLASH_SIM_CHECK( eFLASH_OK == flash_fill( TEST_FILL_ADDR, TEST_FILL_SIZE + 4U, 0U ));
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_stats( &after ));
+    FLASH_SIM_CHECK( after.program_row_num == before.program_row_num );
+    FLASH_SIM_CHECK(( after.program_unit_num - before.program_unit_num ) == (( TEST_FILL_SIZE + 4U ) / 8U ));
+
+    for ( uint32_t i = 0U; i < ( TEST_FILL_SIZE + 4U ); i++ )
+    {
+        FLASH_SIM_CHECK( 0U == *(const uint8_t*)(uintptr_t)( TEST_FILL_ADDR + i ));
+    }
+
+    // Short fill inside single row
+    FLASH_SIM_CHECK( eFLASH_OK == flash_fill( 0x08041008U, 16U, TEST_FILL_PATTERN ));
+    FLASH_SIM_CHECK( TEST_FILL_PATTERN == *(const uint64_t*)(uintptr_t) 0x08041010U );
+    FLASH_SIM_CHECK( UINT64_MAX == *(const uint64_t*)(uintptr_t) 0x08041018U );
+
+    return 0;
+}
+
+int main(void)
+{
+    return flash_sim_run( test_fill );
+}
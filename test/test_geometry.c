@@ -0,0 +1,134 @@
+// Copyright (c) 2026  Ziga Miklosic
+// All Rights Reserved
+////////////////////////////////////////////////////////////////////////////////
+/**
+*@file      test_geometry.c
+*@brief     Runtime geometry of 256 kB G4 device, bank 2 placement
+*@author    Ziga Miklosic
+*@email		ziga.miklosic@gmail.si
+*@date      16.10.2026
+*@version   V0.2.0
+*
+*@note      In dual-bank mode G4 bank 2 starts at 0x08040000 regardless of
+*           device size (RM0440), 256 kB device leaves gap between end of
+*           bank 1 (0x08020000) and bank 2. User region of configuration
+*           covers complete bank 2.
+*/
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+
+#include "flash.h"
+#include "flash_sim.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define TEST_GEO_SIZE                       ( 256U * 1024U )
+#define TEST_GEO_BANK_SIZE                  ( TEST_GEO_SIZE / 2U )
+#define TEST_GEO_BANK2_ADDR                 ( 0x08040000U )
+#define TEST_GEO_BANK1_LAST                 ( FLASH_BASE + TEST_GEO_BANK_SIZE - FLASH_PAGE_SIZE )
+#define TEST_GEO_PATTERN                    ( 0xA5U )
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Check that memory holds single byte value
+*
+* @param[in]    addr    - Flash address
+* @param[in]    size    - Size in bytes
+* @param[in]    val     - Expected value
+* @return       true if all bytes equal value
+*/
+////////////////////////////////////////////////////////////////////////////////
+static bool test_geo_is(const uint32_t addr, const uint32_t size, const uint8_t val)
+{
+    const uint8_t * const   p_mem   = (const uint8_t*)(uintptr_t) addr;
+    bool                    is_val  = true;
+
+    for ( uint32_t i = 0U; ( i < size ) && ( true == is_val ); i++ )
+    {
+        is_val = ( val == p_mem[i] );
+    }
+
+    return is_val;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Test
+*
+* @return       0 on success
+*/
+////////////////////////////////////////////////////////////////////////////////
+static int test_geometry(void)
+{
+    flash_geometry_t    geo;
+    flash_error_t       error;
+    bool                is_ecc = false;
+
+    flash_sim_init();
+    flash_sim_set_size( TEST_GEO_SIZE );
+    FLASH_SIM_CHECK( eFLASH_OK == flash_init());
+
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_geometry( &geo ));
+    FLASH_SIM_CHECK( TEST_GEO_SIZE == geo.size );
+    FLASH_SIM_CHECK( true == geo.is_dual_bank );
+    FLASH_SIM_CHECK( TEST_GEO_BANK_SIZE == geo.bank_size );
+    FLASH_SIM_CHECK( TEST_GEO_BANK2_ADDR == geo.bank2_addr );
+    FLASH_SIM_CHECK( FLASH_PAGE_SIZE == geo.page_size );
+    FLASH_SIM_CHECK(( TEST_GEO_BANK_SIZE / FLASH_PAGE_SIZE ) == geo.page_num );
+
+    // Page erase in bank 2 hits bank 2, last page of bank 1 untouched
+    memset((void*)(uintptr_t) TEST_GEO_BANK1_LAST, TEST_GEO_PATTERN, FLASH_PAGE_SIZE );
+    memset((void*)(uintptr_t) TEST_GEO_BANK2_ADDR, TEST_GEO_PATTERN, TEST_GEO_BANK_SIZE );
+
+    FLASH_SIM_CHECK( eFLASH_OK == flash_erase( TEST_GEO_BANK2_ADDR + FLASH_CFG_PAGE_SIZE_BYTE, FLASH_CFG_PAGE_SIZE_BYTE ));
+    FLASH_SIM_CHECK( test_geo_is( TEST_GEO_BANK2_ADDR, FLASH_CFG_PAGE_SIZE_BYTE, TEST_GEO_PATTERN ));
+    FLASH_SIM_CHECK( test_geo_is( TEST_GEO_BANK2_ADDR + FLASH_CFG_PAGE_SIZE_BYTE, FLASH_CFG_PAGE_SIZE_BYTE, 0xFFU ));
+    FLASH_SIM_CHECK( test_geo_is( TEST_GEO_BANK2_ADDR + ( 2U * FLASH_CFG_PAGE_SIZE_BYTE ), FLASH_CFG_PAGE_SIZE_BYTE, TEST_GEO_PATTERN ));
+    FLASH_SIM_CHECK( test_geo_is( TEST_GEO_BANK1_LAST, FLASH_PAGE_SIZE, TEST_GEO_PATTERN ));
+
+    // Bank erase covers complete bank 2 only
+    FLASH_SIM_CHECK( eFLASH_OK == flash_erase_bank( eFLASH_BANK_2 ));
+    FLASH_SIM_CHECK( test_geo_is( TEST_GEO_BANK2_ADDR, TEST_GEO_BANK_SIZE, 0xFFU ));
+    FLASH_SIM_CHECK( test_geo_is( TEST_GEO_BANK1_LAST, FLASH_PAGE_SIZE, TEST_GEO_PATTERN ));
+
+    // ECC offset is relative to bank 2 start
+    FLASH->ECCR = ( FLASH_ECCR_ECCD | FLASH_ECCR_BK_ECC | 0x200U );
+    FLASH_SIM_CHECK( eFLASH_OK == flash_ecc_nmi_hndl( &is_ecc ));
+    FLASH->ECCR = 0U;
+    FLASH_SIM_CHECK( true == is_ecc );
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_error( &error ));
+    FLASH_SIM_CHECK(( eFLASH_ERROR_ECC == error.status ) && (( TEST_GEO_BANK2_ADDR + 0x200U ) == error.addr ));
+
+    // Single bank mode of 512 kB device: 4 kB erase unit, template page
+    // size still valid
+    FLASH_SIM_CHECK( eFLASH_OK == flash_deinit());
+    FLASH->OPTR &= ~FLASH_OPTR_DBANK;
+    flash_sim_set_size( FLASH_SIZE );
+    FLASH_SIM_CHECK( eFLASH_OK == flash_init());
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_geometry( &geo ));
+    FLASH_SIM_CHECK(( false == geo.is_dual_bank ) && ( FLASH_PAGE_SIZE_128_BITS == geo.page_size ) && ( 0U == geo.bank2_addr ));
+    FLASH_SIM_CHECK( eFLASH_OK == flash_erase( TEST_GEO_BANK2_ADDR, FLASH_CFG_PAGE_SIZE_BYTE ));
+
+    // User region past end of 128 kB device
+    FLASH_SIM_CHECK( eFLASH_OK == flash_deinit());
+    FLASH->OPTR |= FLASH_OPTR_DBANK;
+    flash_sim_set_size( TEST_GEO_SIZE / 2U );
+    FLASH_SIM_CHECK( eFLASH_OK != flash_init());
+
+    return 0;
+}
+
+int main(void)
+{
+    return flash_sim_run( test_geometry );
+}
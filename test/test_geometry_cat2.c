@@ -0,0 +1,117 @@
+// Copyright (c) 2026  Ziga Miklosic
+// All Rights Reserved
+////////////////////////////////////////////////////////////////////////////////
+/**
+*@file      test_geometry_cat2.c
+*@brief     Runtime geometry of 128 kB G4 category 2 device
+*@author    Ziga Miklosic
+*@email		ziga.miklosic@gmail.si
+*@date      17.10.2026
+*@version   V0.2.0
+*
+*@note      Category 2 devices (G431/G441/G491/G4A1) have no DBANK option
+*           bit and no FLASH_PAGE_SIZE_128_BITS, flash is single bank with
+*           2 kB pages. Template 4 kB logical page spans two erase units.
+*/
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+
+#include "flash.h"
+#include "flash_sim.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define TEST_CAT2_SIZE                      ( 128U * 1024U )
+#define TEST_CAT2_ADDR                      ( 0x08010000U )
+#define TEST_CAT2_PATTERN                   ( 0xA5U )
+
+#if defined( FLASH_OPTR_DBANK ) || defined( FLASH_PAGE_SIZE_128_BITS )
+    #error "Test requires category 2 stub, build with FLASH_SIM_CAT2!"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+static uint8_t g_data[256];
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Check that memory holds single byte value
+*
+* @param[in]    addr    - Flash address
+* @param[in]    size    - Size in bytes
+* @param[in]    val     - Expected value
+* @return       true if all bytes equal value
+*/
+////////////////////////////////////////////////////////////////////////////////
+static bool test_cat2_is(const uint32_t addr, const uint32_t size, const uint8_t val)
+{
+    const uint8_t * const   p_mem   = (const uint8_t*)(uintptr_t) addr;
+    bool                    is_val  = true;
+
+    for ( uint32_t i = 0U; ( i < size ) && ( true == is_val ); i++ )
+    {
+        is_val = ( val == p_mem[i] );
+    }
+
+    return is_val;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Test
+*
+* @return       0 on success
+*/
+////////////////////////////////////////////////////////////////////////////////
+static int test_geometry_cat2(void)
+{
+    flash_geometry_t    geo;
+    bool                is_dual = true;
+
+    flash_sim_init();
+    flash_sim_set_size( TEST_CAT2_SIZE );
+    FLASH_SIM_CHECK( eFLASH_OK == flash_init());
+
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_geometry( &geo ));
+    FLASH_SIM_CHECK( TEST_CAT2_SIZE == geo.size );
+    FLASH_SIM_CHECK( false == geo.is_dual_bank );
+    FLASH_SIM_CHECK( 0U == geo.bank2_addr );
+    FLASH_SIM_CHECK( FLASH_PAGE_SIZE == geo.page_size );
+    FLASH_SIM_CHECK(( TEST_CAT2_SIZE / FLASH_PAGE_SIZE ) == geo.page_num );
+
+    // Logical page erase covers two erase units, neighbours untouched
+    memset((void*)(uintptr_t)( TEST_CAT2_ADDR - FLASH_PAGE_SIZE ), TEST_CAT2_PATTERN, ( 2U * FLASH_CFG_PAGE_SIZE_BYTE ));
+
+    FLASH_SIM_CHECK( eFLASH_OK == flash_erase( TEST_CAT2_ADDR, FLASH_CFG_PAGE_SIZE_BYTE ));
+    FLASH_SIM_CHECK( test_cat2_is( TEST_CAT2_ADDR - FLASH_PAGE_SIZE, FLASH_PAGE_SIZE, TEST_CAT2_PATTERN ));
+    FLASH_SIM_CHECK( test_cat2_is( TEST_CAT2_ADDR, FLASH_CFG_PAGE_SIZE_BYTE, 0xFFU ));
+    FLASH_SIM_CHECK( test_cat2_is( TEST_CAT2_ADDR + FLASH_CFG_PAGE_SIZE_BYTE, FLASH_PAGE_SIZE, TEST_CAT2_PATTERN ));
+
+    // Write across erase unit boundary
+    memset( g_data, 0x3C, sizeof( g_data ));
+    FLASH_SIM_CHECK( eFLASH_OK == flash_write( TEST_CAT2_ADDR + FLASH_PAGE_SIZE - 128U, sizeof( g_data ), g_data ));
+    FLASH_SIM_CHECK( 0 == memcmp((const void*)(uintptr_t)( TEST_CAT2_ADDR + FLASH_PAGE_SIZE - 128U ), g_data, sizeof( g_data )));
+
+    // No bank mode option bit
+    FLASH_SIM_CHECK( eFLASH_OK == flash_bank_mode_get( &is_dual ));
+    FLASH_SIM_CHECK( false == is_dual );
+    FLASH_SIM_CHECK( eFLASH_ERROR == flash_bank_mode_set( true ));
+
+    return 0;
+}
+
+int main(void)
+{
+    return flash_sim_run( test_geometry_cat2 );
+}
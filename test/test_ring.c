@@ -0,0 +1,176 @@
+// Copyright (c) 2026  Ziga Miklosic
+// All Rights Reserved
+////////////////////////////////////////////////////////////////////////////////
+/**
+*@file      test_ring.c
+*@brief     Command ring producer/consumer test
+*@author    Ziga Miklosic
+*@email		ziga.miklosic@gmail.si
+*@date      16.10.2026
+*@version   V0.2.0
+*
+*@note      Producer thread stands in for ISR posting commands, test thread
+*           for flash service task processing them. Each round erases
+*           region and rewrites it with new records, so any reordering or
+*           lost command fails programming or content check.
+*/
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "flash.h"
+#include "flash_sim.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ *  Test region and load
+ */
+#define TEST_RING_ADDR                      ( 0x08010000U )
+#define TEST_RING_REGION_SIZE               ( 0x1000U )
+#define TEST_RING_REC_NUM                   ( TEST_RING_REGION_SIZE / sizeof( uint64_t ))
+#define TEST_RING_ROUND_NUM                 ( 64U )
+#define TEST_RING_CMD_NUM                   ( TEST_RING_ROUND_NUM * ( TEST_RING_REC_NUM + 1U ))
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ *  Record data, must stay valid until processed
+ */
+static uint64_t     g_rec[TEST_RING_ROUND_NUM][TEST_RING_REC_NUM];
+
+/**
+ *  Posts rejected due to full ring
+ */
+static atomic_uint  g_post_fail_num = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Post command, retry while ring is full
+*
+* @param[in]    p_cmd   - Command
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void test_ring_post(const flash_cmd_t * const p_cmd)
+{
+    while ( eFLASH_OK != flash_ring_post( p_cmd ))
+    {
+        atomic_fetch_add( &g_post_fail_num, 1U );
+        sched_yield();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Producer, stands in for ISR
+*
+* @param[in]    p_arg   - Unused
+* @return       NULL
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void * test_ring_producer(void * p_arg)
+{
+    flash_cmd_t cmd;
+
+    (void) p_arg;
+
+    for ( uint32_t r = 0; r < TEST_RING_ROUND_NUM; r++ )
+    {
+        cmd.type    = eFLASH_CMD_ERASE;
+        cmd.addr    = TEST_RING_ADDR;
+        cmd.size    = TEST_RING_REGION_SIZE;
+        cmd.p_data  = NULL;
+        test_ring_post( &cmd );
+
+        for ( uint32_t i = 0; i < TEST_RING_REC_NUM; i++ )
+        {
+            cmd.type    = eFLASH_CMD_WRITE;
+            cmd.addr    = TEST_RING_ADDR + ( i * sizeof( uint64_t ));
+            cmd.size    = sizeof( uint64_t );
+            cmd.p_data  = (const uint8_t*) &g_rec[r][i];
+            test_ring_post( &cmd );
+        }
+    }
+
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Test
+*
+* @return       0 on success
+*/
+////////////////////////////////////////////////////////////////////////////////
+static int test_ring(void)
+{
+    pthread_t       producer;
+    flash_stats_t   stats;
+    uint32_t        total   = 0U;
+    uint32_t        num     = 0U;
+
+    flash_sim_init();
+    FLASH_SIM_CHECK( eFLASH_OK == flash_init());
+
+    for ( uint32_t r = 0; r < TEST_RING_ROUND_NUM; r++ )
+    {
+        for ( uint32_t i = 0; i < TEST_RING_REC_NUM; i++ )
+        {
+            g_rec[r][i] = ((uint64_t)( r + 1U ) << 32 ) | i;
+        }
+    }
+
+    FLASH_SIM_CHECK( 0 == pthread_create( &producer, NULL, test_ring_producer, NULL ));
+
+    // Service task
+    while ( total < TEST_RING_CMD_NUM )
+    {
+        FLASH_SIM_CHECK( eFLASH_OK == flash_ring_process( 4U, &num ));
+        total += num;
+
+        if ( 0U == num )
+        {
+            sched_yield();
+        }
+    }
+
+    FLASH_SIM_CHECK( 0 == pthread_join( producer, NULL ));
+
+    // Nothing left behind
+    FLASH_SIM_CHECK( eFLASH_OK == flash_ring_process( 4U, &num ));
+    FLASH_SIM_CHECK( 0U == num );
+
+    // Last round survived in order
+    for ( uint32_t i = 0; i < TEST_RING_REC_NUM; i++ )
+    {
+        FLASH_SIM_CHECK( g_rec[ TEST_RING_ROUND_NUM - 1U ][i] == ((const uint64_t*)(uintptr_t) TEST_RING_ADDR )[i] );
+    }
+
+    // Every rejected post is accounted
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_stats( &stats ));
+    FLASH_SIM_CHECK( atomic_load( &g_post_fail_num ) == stats.ring_drop_num );
+
+    printf( "commands=%u drops=%u\n", total, stats.ring_drop_num );
+
+    return 0;
+}
+
+int main(void)
+{
+    return flash_sim_run( test_ring );
+}
@@ -0,0 +1,315 @@
+// Copyright (c) 2026  Ziga Miklosic
+// All Rights Reserved
+////////////////////////////////////////////////////////////////////////////////
+/**
+*@file      test_sched.c
+*@brief     Scheduler preemption, request order and concurrent submit
+*@author    Ziga Miklosic
+*@email		ziga.miklosic@gmail.si
+*@date      16.10.2026
+*@version   V0.2.0
+*
+*@note      Scheduler is processed one operation per call (1 us budget),
+*           so order of operations can be observed between calls.
+*
+*@note      Producer threads stand in for interrupts of different priority
+*           submitting to full scheduler at the same time. Every rejected
+*           submit must be counted.
+*/
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "flash.h"
+#include "flash_sim.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define TEST_SCHED_ADDR                     ( 0x08040000U )
+#define TEST_SCHED_PRODUCER_NUM             ( 4U )
+#define TEST_SCHED_SUBMIT_NUM               ( 100000U )
+
+/**
+ *  Background erase of 8 erase units preempted by urgent write
+ */
+#define TEST_SCHED_ERASE_ADDR               ( 0x08050000U )
+#define TEST_SCHED_ERASE_SIZE               ( 8U * FLASH_PAGE_SIZE )
+#define TEST_SCHED_WRITE_ADDR               ( 0x08060000U )
+
+/**
+ *  Service task runs 1 ms after urgent submit
+ */
+#define TEST_SCHED_DELAY_US                 ( 1000U )
+
+/**
+ *  Order test, single program unit per request
+ */
+#define TEST_SCHED_ORDER_ADDR               ( 0x08061000U )
+#define TEST_SCHED_ORDER_NUM                ( 7U )
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+static uint8_t          g_data[64];
+static volatile bool    gb_erase_done   = false;
+static volatile bool    gb_write_done   = false;
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Background erase completion
+*
+* @param[in]    status  - Status of request
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void test_sched_erase_done(const flash_status_t status)
+{
+    FLASH_SIM_CHECK( eFLASH_OK == status );
+    gb_erase_done = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Urgent write completion
+*
+* @param[in]    status  - Status of request
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void test_sched_write_done(const flash_status_t status)
+{
+    FLASH_SIM_CHECK( eFLASH_OK == status );
+    gb_write_done = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Number of erased erase units of background erase
+*
+* @return       num     - Number of erased units
+*/
+////////////////////////////////////////////////////////////////////////////////
+static uint32_t test_sched_erased_num(void)
+{
+    uint32_t num = 0U;
+
+    for ( uint32_t addr = TEST_SCHED_ERASE_ADDR; addr < ( TEST_SCHED_ERASE_ADDR + TEST_SCHED_ERASE_SIZE ); addr += FLASH_PAGE_SIZE )
+    {
+        if ( UINT64_MAX == *(const uint64_t*)(uintptr_t) addr )
+        {
+            num++;
+        }
+    }
+
+    return num;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Urgent write preempts background erase
+*
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void test_sched_preempt(void)
+{
+    const flash_sched_req_t erase = { .cmd = { .addr = TEST_SCHED_ERASE_ADDR, .size = TEST_SCHED_ERASE_SIZE, .type = eFLASH_CMD_ERASE }, .pf_done = test_sched_erase_done, .prio = eFLASH_PRIO_LOW };
+    const flash_sched_req_t write = { .cmd = { .addr = TEST_SCHED_WRITE_ADDR, .size = sizeof( g_data ), .p_data = g_data, .type = eFLASH_CMD_WRITE }, .pf_done = test_sched_write_done, .prio = eFLASH_PRIO_HIGH };
+    flash_stats_t           stats;
+    uint32_t                pending     = 0U;
+    uint32_t                erased_num  = 0U;
+
+    memset((void*)(uintptr_t) TEST_SCHED_ERASE_ADDR, 0, TEST_SCHED_ERASE_SIZE );
+    memset( g_data, 0xC3, sizeof( g_data ));
+
+    // Background erase started
+    FLASH_SIM_CHECK( eFLASH_OK == flash_sched_submit( &erase ));
+    FLASH_SIM_CHECK( eFLASH_OK == flash_sched_process( 1U, &pending ));
+    FLASH_SIM_CHECK(( 1U == pending ) && ( 1U == test_sched_erased_num()));
+
+    // Urgent write mid-way
+    FLASH_SIM_CHECK( eFLASH_OK == flash_sched_submit( &write ));
+    DWT->CYCCNT += ( TEST_SCHED_DELAY_US * ( SystemCoreClock / 1000000U ));
+
+    for ( uint32_t i = 0U; ( i < 100U ) && ( false == gb_write_done ); i++ )
+    {
+        FLASH_SIM_CHECK( eFLASH_OK == flash_sched_process( 1U, &pending ));
+    }
+
+    erased_num = test_sched_erased_num();
+
+    FLASH_SIM_CHECK( true == gb_write_done );
+    FLASH_SIM_CHECK( false == gb_erase_done );
+    FLASH_SIM_CHECK(( erased_num - 1U ) <= 1U );
+    FLASH_SIM_CHECK( 0 == memcmp((const void*)(uintptr_t) TEST_SCHED_WRITE_ADDR, g_data, sizeof( g_data )));
+
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_stats( &stats ));
+    FLASH_SIM_CHECK( stats.sched_wait_max_us[ eFLASH_PRIO_HIGH ] >= TEST_SCHED_DELAY_US );
+    FLASH_SIM_CHECK( stats.sched_latency_max_us[ eFLASH_PRIO_HIGH ] > stats.sched_wait_max_us[ eFLASH_PRIO_HIGH ] );
+
+    // Background erase resumes
+    FLASH_SIM_CHECK( eFLASH_OK == flash_sched_process( 1000000U, &pending ));
+    FLASH_SIM_CHECK(( 0U == pending ) && ( true == gb_erase_done ));
+    FLASH_SIM_CHECK(( TEST_SCHED_ERASE_SIZE / FLASH_PAGE_SIZE ) == test_sched_erased_num());
+
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_stats( &stats ));
+    FLASH_SIM_CHECK( stats.sched_latency_max_us[ eFLASH_PRIO_LOW ] > 0U );
+    FLASH_SIM_CHECK( 0U == stats.sched_miss_num );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Requests served by priority, then deadline, then submit order
+*
+* @note     Deadlines of 20 s and 30 s exceed 32-bit clock range in CPU
+*           cycles at 170 MHz.
+*
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void test_sched_order(void)
+{
+    static const struct
+    {
+        uint32_t        deadline_us;
+        flash_prio_t    prio;
+        uint32_t        rank;
+    } req[TEST_SCHED_ORDER_NUM] =
+    {
+        { .deadline_us = 0U,        .prio = eFLASH_PRIO_NORMAL, .rank = 4U },
+        { .deadline_us = 30000000U, .prio = eFLASH_PRIO_NORMAL, .rank = 3U },
+        { .deadline_us = 0U,        .prio = eFLASH_PRIO_LOW,    .rank = 6U },
+        { .deadline_us = 0U,        .prio = eFLASH_PRIO_HIGH,   .rank = 0U },
+        { .deadline_us = 20000000U, .prio = eFLASH_PRIO_NORMAL, .rank = 1U },
+        { .deadline_us = 0U,        .prio = eFLASH_PRIO_NORMAL, .rank = 5U },
+        { .deadline_us = 20000000U, .prio = eFLASH_PRIO_NORMAL, .rank = 2U },
+    };
+    flash_stats_t   stats;
+    uint32_t        pending = 0U;
+
+    for ( uint32_t i = 0U; i < TEST_SCHED_ORDER_NUM; i++ )
+    {
+        const flash_sched_req_t sched_req = { .cmd = { .addr = TEST_SCHED_ORDER_ADDR + ( i * 8U ), .size = 8U, .p_data = g_data, .type = eFLASH_CMD_WRITE }, .deadline_us = req[i].deadline_us, .prio = req[i].prio };
+
+        FLASH_SIM_CHECK( eFLASH_OK == flash_sched_submit( &sched_req ));
+    }
+
+    // Single request programmed per call
+    for ( uint32_t rank = 0U; rank < TEST_SCHED_ORDER_NUM; rank++ )
+    {
+        FLASH_SIM_CHECK( eFLASH_OK == flash_sched_process( 1U, &pending ));
+        FLASH_SIM_CHECK(( TEST_SCHED_ORDER_NUM - 1U - rank ) == pending );
+
+        for ( uint32_t i = 0U; i < TEST_SCHED_ORDER_NUM; i++ )
+        {
+            const bool is_done = ( UINT64_MAX != *(const uint64_t*)(uintptr_t)( TEST_SCHED_ORDER_ADDR + ( i * 8U )));
+
+            FLASH_SIM_CHECK( is_done == ( req[i].rank <= rank ));
+        }
+    }
+
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_stats( &stats ));
+    FLASH_SIM_CHECK( 0U == stats.sched_miss_num );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Producer submitting to full scheduler
+*
+* @param[in]    p_arg   - Unused
+* @return       NULL
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void * test_sched_producer(void * p_arg)
+{
+    const flash_sched_req_t req = { .cmd = { .addr = TEST_SCHED_ADDR, .size = sizeof( g_data ), .p_data = g_data, .type = eFLASH_CMD_WRITE }, .prio = eFLASH_PRIO_NORMAL };
+
+    (void) p_arg;
+
+    for ( uint32_t i = 0U; i < TEST_SCHED_SUBMIT_NUM; i++ )
+    {
+        FLASH_SIM_CHECK( eFLASH_ERROR == flash_sched_submit( &req ));
+    }
+
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Rejected submits to full scheduler counted
+*
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void test_sched_drop(void)
+{
+    pthread_t           producer[TEST_SCHED_PRODUCER_NUM];
+    flash_sched_req_t   req;
+    flash_stats_t       stats;
+    uint32_t            pending = 0U;
+
+    memset( g_data, 0x5A, sizeof( g_data ));
+
+    // Occupy all slots
+    for ( uint32_t i = 0U; i < FLASH_CFG_SCHED_SIZE; i++ )
+    {
+        req = (flash_sched_req_t) { .cmd = { .addr = TEST_SCHED_ADDR + ( i * sizeof( g_data )), .size = sizeof( g_data ), .p_data = g_data, .type = eFLASH_CMD_WRITE }, .prio = eFLASH_PRIO_NORMAL };
+        FLASH_SIM_CHECK( eFLASH_OK == flash_sched_submit( &req ));
+    }
+
+    for ( uint32_t i = 0U; i < TEST_SCHED_PRODUCER_NUM; i++ )
+    {
+        FLASH_SIM_CHECK( 0 == pthread_create( &producer[i], NULL, test_sched_producer, NULL ));
+    }
+
+    for ( uint32_t i = 0U; i < TEST_SCHED_PRODUCER_NUM; i++ )
+    {
+        FLASH_SIM_CHECK( 0 == pthread_join( producer[i], NULL ));
+    }
+
+    FLASH_SIM_CHECK( eFLASH_OK == flash_get_stats( &stats ));
+    FLASH_SIM_CHECK(( TEST_SCHED_PRODUCER_NUM * TEST_SCHED_SUBMIT_NUM ) == stats.sched_drop_num );
+
+    // Accepted requests complete
+    FLASH_SIM_CHECK( eFLASH_OK == flash_sched_process( 1000000U, &pending ));
+    FLASH_SIM_CHECK( 0U == pending );
+
+    for ( uint32_t i = 0U; i < FLASH_CFG_SCHED_SIZE; i++ )
+    {
+        FLASH_SIM_CHECK( 0 == memcmp((const void*)(uintptr_t)( TEST_SCHED_ADDR + ( i * sizeof( g_data ))), g_data, sizeof( g_data )));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Test
+*
+* @return       0 on success
+*/
+////////////////////////////////////////////////////////////////////////////////
+static int test_sched(void)
+{
+    flash_sim_init();
+    FLASH_SIM_CHECK( eFLASH_OK == flash_init());
+
+    test_sched_preempt();
+    test_sched_order();
+    test_sched_drop();
+
+    return 0;
+}
+
+int main(void)
+{
+    return flash_sim_run( test_sched );
+}
@@ -0,0 +1,116 @@
+// Copyright (c) 2026  Ziga Miklosic
+// All Rights Reserved
+////////////////////////////////////////////////////////////////////////////////
+/**
+*@file      test_writev.c
+*@brief     Scatter-gather write test
+*@author    Ziga Miklosic
+*@email		ziga.miklosic@gmail.si
+*@date      16.10.2026
+*@version   V0.2.0
+*/
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+
+#include "flash.h"
+#include "flash_sim.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define TEST_WRITEV_ADDR                    ( 0x08040000U )
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+static uint8_t  g_head[10];
+static uint8_t  g_payload[600 + 1];
+static uint8_t  g_crc[4];
+static uint8_t  g_all[614];
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Write vector at address and compare
+*
+* @param[in]    addr    - Flash address
+* @param[in]    p_iov   - Fragments forming g_all
+* @param[in]    count   - Number of fragments
+* @return       void
+*/
+////////////////////////////////////////////////////////////////////////////////
+static void test_writev_check(const uint32_t addr, const flash_iovec_t * const p_iov, const uint32_t count)
+{
+    FLASH_SIM_CHECK( eFLASH_OK == flash_writev( addr, p_iov, count ));
+    FLASH_SIM_CHECK( 0 == memcmp((const void*)(uintptr_t) addr, g_all, sizeof( g_all )));
+
+    // Last partial unit padded with erased value
+    FLASH_SIM_CHECK( 0xFFFFU == *(const uint16_t*)(uintptr_t)( addr + sizeof( g_all )));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+*       Test
+*
+* @return       0 on success
+*/
+////////////////////////////////////////////////////////////////////////////////
+static int test_writev(void)
+{
+    flash_iovec_t   iov[4];
+    flash_iovec_t   big[2];
+
+    flash_sim_init();
+    FLASH_SIM_CHECK( eFLASH_OK == flash_init());
+
+    for ( uint32_t i = 0; i < sizeof( g_head ); i++ )       { g_head[i]     = (uint8_t) i; }
+    for ( uint32_t i = 0; i < sizeof( g_payload ); i++ )    { g_payload[i]  = (uint8_t)( i * 3U ); }
+    for ( uint32_t i = 0; i < sizeof( g_crc ); i++ )        { g_crc[i]      = (uint8_t)( 0xA0U + i ); }
+
+    memcpy( &g_all[0], g_head, 10U );
+    memcpy( &g_all[10], g_payload, 600U );
+    memcpy( &g_all[610], g_crc, 4U );
+
+    iov[0] = (flash_iovec_t) { g_head, 10U };
+    iov[1] = (flash_iovec_t) { NULL, 0U };
+    iov[2] = (flash_iovec_t) { g_payload, 600U };
+    iov[3] = (flash_iovec_t) { g_crc, 4U };
+
+    // Row aligned and unaligned start
+    test_writev_check( TEST_WRITEV_ADDR, iov, 4U );
+    test_writev_check( TEST_WRITEV_ADDR + 0x1008U, iov, 4U );
+
+    // Unaligned payload source
+    memmove( &g_payload[1], &g_payload[0], 600U );
+    iov[2].p_data = &g_payload[1];
+    test_writev_check( TEST_WRITEV_ADDR + 0x2000U, iov, 4U );
+
+    // Single fragment
+    big[0] = (flash_iovec_t) { g_all, sizeof( g_all ) };
+    test_writev_check( TEST_WRITEV_ADDR + 0x3000U, big, 1U );
+
+    // Total size wrapping around must not pass range check
+    big[0] = (flash_iovec_t) { g_all, 0xFFFFFF00U };
+    big[1] = (flash_iovec_t) { g_all, 0x200U };
+    FLASH_SIM_CHECK( eFLASH_ERROR_RANGE == flash_writev( TEST_WRITEV_ADDR + 0x4000U, big, 2U ));
+    FLASH_SIM_CHECK( 0xFFFFFFFFU == *(const uint32_t*)(uintptr_t)( TEST_WRITEV_ADDR + 0x4000U ));
+
+    // Invalid fragment
+    big[0] = (flash_iovec_t) { NULL, 8U };
+    FLASH_SIM_CHECK( eFLASH_ERROR == flash_writev( TEST_WRITEV_ADDR + 0x4000U, big, 1U ));
+
+    return 0;
+}
+
+int main(void)
+{
+    return flash_sim_run( test_writev );
+}